@@ -0,0 +1,269 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+
+#include "ext/xxhash.h"
+
+#include "Common/Log.h"
+#include "Common/TimeUtil.h"
+#include "Common/Profiler/Profiler.h"
+#include "Common/Thread/WorkerPool.h"
+#include "Common/GPU/Vulkan/VulkanContext.h"
+#include "Common/GPU/Vulkan/VulkanShaderCompiler.h"
+
+void VulkanShaderCompileJob::Wait() {
+	if (IsReady())
+		return;
+	std::unique_lock<std::mutex> guard(mutex_);
+	while (!ready_.load(std::memory_order_acquire)) {
+		cond_.wait(guard);
+	}
+}
+
+void VulkanShaderCompileJob::Finish(bool success) {
+	success_ = success;
+	std::lock_guard<std::mutex> guard(mutex_);
+	ready_.store(true, std::memory_order_release);
+	cond_.notify_all();
+}
+
+VulkanShaderCompiler::VulkanShaderCompiler(int numThreads) {
+	if (numThreads > 0) {
+		pool_ = new WorkerPool(numThreads, "ShaderCompile");
+	}
+}
+
+VulkanShaderCompiler::~VulkanShaderCompiler() {
+	// Let in-flight jobs finish, someone might be waiting on them.
+	WaitUntilIdle();
+	delete pool_;
+}
+
+uint64_t VulkanShaderCompiler::HashSource(VkShaderStageFlagBits stage, const std::string &source) {
+	return XXH64(source.data(), source.size(), (unsigned long long)stage);
+}
+
+std::shared_ptr<VulkanShaderCompileJob> VulkanShaderCompiler::Compile(VkShaderStageFlagBits stage, const std::string &source) {
+	uint64_t hash = HashSource(stage, source);
+	std::shared_ptr<VulkanShaderCompileJob> job;
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		auto pendingIter = pending_.find(hash);
+		if (pendingIter != pending_.end()) {
+			return pendingIter->second;
+		}
+
+		job = std::make_shared<VulkanShaderCompileJob>(stage, hash);
+		auto cacheIter = cache_.find(hash);
+		if (cacheIter != cache_.end()) {
+			cacheHits_++;
+			cacheIter->second.lastUse = ++useCounter_;
+			job->spirv_ = cacheIter->second.spirv;
+			job->fromCache_ = true;
+			job->Finish(true);
+			return job;
+		}
+		pending_[hash] = job;
+	}
+
+	if (pool_) {
+		// Copy the source, the caller's buffer is usually reused for the next shader.
+		pool_->Run([this, job, source] {
+			RunJob(job, source);
+		}, [this, job] {
+			CancelJob(job);
+		});
+	} else {
+		RunJob(job, source);
+	}
+	return job;
+}
+
+void VulkanShaderCompiler::RunJob(std::shared_ptr<VulkanShaderCompileJob> job, const std::string &source) {
+	PROFILE_THIS_SCOPE("shadercomp");
+	double start = time_now_d();
+	bool success = GLSLtoSPV(job->stage_, source.c_str(), GLSLVariant::VULKAN, job->spirv_, &job->errorMessage_);
+	double elapsed = time_now_d() - start;
+
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		if (success) {
+			compiled_++;
+			AddToCache(job->hash_, job->spirv_);
+			cacheDirty_ = true;
+		} else {
+			failed_++;
+		}
+		compileSeconds_ += elapsed;
+		pending_.erase(job->hash_);
+	}
+
+	job->Finish(success);
+}
+
+void VulkanShaderCompiler::CancelJob(std::shared_ptr<VulkanShaderCompileJob> job) {
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		pending_.erase(job->hash_);
+	}
+	job->errorMessage_ = "Compile cancelled";
+	job->Finish(false);
+}
+
+void VulkanShaderCompiler::WaitUntilIdle() {
+	if (pool_)
+		pool_->WaitUntilIdle();
+}
+
+VulkanShaderCompilerStats VulkanShaderCompiler::GetStats() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	VulkanShaderCompilerStats stats;
+	stats.compiled = compiled_;
+	stats.failed = failed_;
+	stats.cacheHits = cacheHits_;
+	stats.pending = (int)pending_.size();
+	stats.cached = (int)cache_.size();
+	stats.compileSeconds = compileSeconds_;
+	return stats;
+}
+
+void VulkanShaderCompiler::ClearCache() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	cache_.clear();
+	cacheWords_ = 0;
+	cacheDirty_ = true;
+}
+
+void VulkanShaderCompiler::AddToCache(uint64_t hash, std::vector<uint32_t> spirv) {
+	CacheEntry &entry = cache_[hash];
+	cacheWords_ -= entry.spirv.size();
+	cacheWords_ += spirv.size();
+	entry.spirv = std::move(spirv);
+	entry.lastUse = ++useCounter_;
+	EvictIfFull();
+}
+
+// Total size limit of the cache. Stale entries from old shader generator versions would otherwise pile up forever.
+#define SPIRV_CACHE_MAX_TOTAL_WORDS (16 * 1024 * 1024 / 4)
+
+void VulkanShaderCompiler::EvictIfFull() {
+	if (cacheWords_ <= SPIRV_CACHE_MAX_TOTAL_WORDS)
+		return;
+
+	// Drop the least recently used quarter or so in one go, so we don't sort on every insert.
+	std::vector<std::pair<uint64_t, uint64_t>> byAge;
+	byAge.reserve(cache_.size());
+	for (const auto &iter : cache_) {
+		byAge.push_back(std::make_pair(iter.second.lastUse, iter.first));
+	}
+	std::sort(byAge.begin(), byAge.end());
+
+	const size_t target = SPIRV_CACHE_MAX_TOTAL_WORDS / 4 * 3;
+	int evicted = 0;
+	for (const auto &item : byAge) {
+		if (cacheWords_ <= target)
+			break;
+		auto iter = cache_.find(item.second);
+		cacheWords_ -= iter->second.spirv.size();
+		cache_.erase(iter);
+		evicted++;
+	}
+	cacheDirty_ = true;
+	INFO_LOG(G3D, "SPIR-V cache full, evicted %d modules", evicted);
+}
+
+// SPIR-V cache file.
+//
+// A flat list of (hash, word count, words). We don't store anything about the GPU or the game here,
+// SPIR-V is device independent and the key covers everything that affects the output - except the
+// glslang version, which is what SPIRV_CACHE_VERSION is for.
+
+#define SPIRV_CACHE_MAGIC 0x56525053  // "SPRV"
+#define SPIRV_CACHE_VERSION 1
+// Sanity limit when loading, no generated shader gets anywhere near this.
+#define SPIRV_CACHE_MAX_WORDS (1024 * 1024)
+
+struct SPIRVCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t reserved;
+};
+
+bool VulkanShaderCompiler::LoadCache(FILE *f) {
+	SPIRVCacheHeader header{};
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != SPIRV_CACHE_MAGIC || header.version != SPIRV_CACHE_VERSION)
+		return false;
+
+	std::vector<std::pair<uint64_t, std::vector<uint32_t>>> loaded;
+	loaded.reserve(header.numEntries);
+	for (uint32_t i = 0; i < header.numEntries; i++) {
+		uint64_t hash;
+		uint32_t numWords;
+		if (fread(&hash, sizeof(hash), 1, f) != 1 || fread(&numWords, sizeof(numWords), 1, f) != 1 || numWords == 0 || numWords > SPIRV_CACHE_MAX_WORDS) {
+			ERROR_LOG(G3D, "SPIR-V cache truncated or corrupt");
+			return false;
+		}
+		loaded.push_back(std::make_pair(hash, std::vector<uint32_t>()));
+		std::vector<uint32_t> &spirv = loaded.back().second;
+		spirv.resize(numWords);
+		if (fread(&spirv[0], sizeof(uint32_t), numWords, f) != numWords) {
+			ERROR_LOG(G3D, "SPIR-V cache truncated");
+			return false;
+		}
+	}
+
+	// Entries are saved oldest first, so this keeps their order for eviction.
+	std::lock_guard<std::mutex> guard(mutex_);
+	for (auto &iter : loaded) {
+		AddToCache(iter.first, std::move(iter.second));
+	}
+	NOTICE_LOG(G3D, "Loaded %d SPIR-V modules from cache", (int)header.numEntries);
+	return true;
+}
+
+void VulkanShaderCompiler::SaveCache(FILE *f) {
+	std::lock_guard<std::mutex> guard(mutex_);
+	SPIRVCacheHeader header{};
+	header.magic = SPIRV_CACHE_MAGIC;
+	header.version = SPIRV_CACHE_VERSION;
+	header.numEntries = (uint32_t)cache_.size();
+	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
+
+	// Oldest first, so the next load knows what to evict first.
+	std::vector<std::pair<uint64_t, uint64_t>> byAge;
+	byAge.reserve(cache_.size());
+	for (const auto &iter : cache_) {
+		byAge.push_back(std::make_pair(iter.second.lastUse, iter.first));
+	}
+	std::sort(byAge.begin(), byAge.end());
+
+	for (const auto &item : byAge) {
+		const std::vector<uint32_t> &spirv = cache_[item.second].spirv;
+		uint32_t numWords = (uint32_t)spirv.size();
+		writeFailed = writeFailed || fwrite(&item.second, sizeof(item.second), 1, f) != 1;
+		writeFailed = writeFailed || fwrite(&numWords, sizeof(numWords), 1, f) != 1;
+		writeFailed = writeFailed || fwrite(spirv.data(), sizeof(uint32_t), numWords, f) != numWords;
+	}
+	if (writeFailed) {
+		ERROR_LOG(G3D, "Failed to write SPIR-V cache, disk full?");
+	} else {
+		cacheDirty_ = false;
+		NOTICE_LOG(G3D, "Saved %d SPIR-V modules", (int)header.numEntries);
+	}
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/GPU/Vulkan/VulkanLoader.h"
+
+class WorkerPool;
+
+// One GLSL -> SPIR-V compilation, possibly still running on a worker thread.
+// Shared between the compiler and whoever requested it, so it can be polled or waited on.
+class VulkanShaderCompileJob {
+public:
+	VulkanShaderCompileJob(VkShaderStageFlagBits stage, uint64_t hash) : stage_(stage), hash_(hash) {}
+
+	VkShaderStageFlagBits Stage() const { return stage_; }
+	uint64_t SourceHash() const { return hash_; }
+
+	bool IsReady() const { return ready_.load(std::memory_order_acquire); }
+	// Blocks until the SPIR-V (or an error) is available.
+	void Wait();
+
+	// Only valid once IsReady() returns true.
+	bool Succeeded() const { return success_; }
+	bool FromCache() const { return fromCache_; }
+	const std::vector<uint32_t> &SPIRV() const { return spirv_; }
+	const std::string &ErrorMessage() const { return errorMessage_; }
+
+private:
+	friend class VulkanShaderCompiler;
+	void Finish(bool success);
+
+	VkShaderStageFlagBits stage_;
+	uint64_t hash_;
+	std::vector<uint32_t> spirv_;
+	std::string errorMessage_;
+	bool success_ = false;
+	bool fromCache_ = false;
+
+	std::atomic<bool> ready_{};
+	std::mutex mutex_;
+	std::condition_variable cond_;
+};
+
+struct VulkanShaderCompilerStats {
+	int compiled;
+	int failed;
+	int cacheHits;
+	int pending;
+	int cached;
+	double compileSeconds;  // Summed over all workers.
+};
+
+// Compiles shaders on a worker pool and keeps the resulting SPIR-V in a content-addressed cache,
+// keyed by a hash of the stage and the full GLSL text. Since the key is the source itself, the cache
+// never needs invalidation when the shader generators change - stale entries simply stop being hit,
+// and get evicted (least recently used first) once the cache grows past its size limit.
+// glslang must already be initialized (init_glslang) before compiling.
+class VulkanShaderCompiler {
+public:
+	// numThreads == 0 compiles synchronously on the calling thread.
+	explicit VulkanShaderCompiler(int numThreads);
+	~VulkanShaderCompiler();
+
+	// Never returns null. If the source is cached, the returned job is already ready.
+	// Identical requests that are in flight at the same time share a job.
+	std::shared_ptr<VulkanShaderCompileJob> Compile(VkShaderStageFlagBits stage, const std::string &source);
+	void WaitUntilIdle();
+
+	bool LoadCache(FILE *f);
+	void SaveCache(FILE *f);
+	void ClearCache();
+	// True if anything was compiled since the cache was last loaded or saved.
+	bool CacheDirty() {
+		std::lock_guard<std::mutex> guard(mutex_);
+		return cacheDirty_;
+	}
+
+	VulkanShaderCompilerStats GetStats();
+
+	static uint64_t HashSource(VkShaderStageFlagBits stage, const std::string &source);
+
+private:
+	void RunJob(std::shared_ptr<VulkanShaderCompileJob> job, const std::string &source);
+	// Releases waiters on a job the pool dropped before it ran.
+	void CancelJob(std::shared_ptr<VulkanShaderCompileJob> job);
+	// Call with mutex_ held.
+	void AddToCache(uint64_t hash, std::vector<uint32_t> spirv);
+	void EvictIfFull();
+
+	struct CacheEntry {
+		std::vector<uint32_t> spirv;
+		uint64_t lastUse;
+	};
+
+	WorkerPool *pool_ = nullptr;
+
+	std::mutex mutex_;
+	std::unordered_map<uint64_t, CacheEntry> cache_;
+	size_t cacheWords_ = 0;
+	uint64_t useCounter_ = 0;
+	std::unordered_map<uint64_t, std::shared_ptr<VulkanShaderCompileJob>> pending_;
+	bool cacheDirty_ = false;
+
+	int compiled_ = 0;
+	int failed_ = 0;
+	int cacheHits_ = 0;
+	double compileSeconds_ = 0.0;
+};
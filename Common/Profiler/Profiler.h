@@ -2,6 +2,8 @@
 
 #include <cstdint>
 
+#include "Common/Profiler/TraceRecorder.h"
+
 // #define USE_PROFILER
 
 #ifdef USE_PROFILER
@@ -36,13 +38,14 @@ class ProfileThis {
 };
 
 #define PROFILE_INIT() internal_profiler_init();
-#define PROFILE_THIS_SCOPE(cat) ProfileThis _profile_scoped(cat);
-#define PROFILE_END_FRAME() internal_profiler_end_frame();
+#define PROFILE_THIS_SCOPE(cat) ProfileThis _profile_scoped(cat); TRACE_THIS_SCOPE(cat, "scope");
+#define PROFILE_END_FRAME() internal_profiler_end_frame(); TraceRecorder::Instant("frame", "frame");
 
 #else
 
+// Scopes are still traced while TraceRecorder is recording.
 #define PROFILE_INIT()
-#define PROFILE_THIS_SCOPE(cat)
-#define PROFILE_END_FRAME()
+#define PROFILE_THIS_SCOPE(cat) TRACE_THIS_SCOPE(cat, "scope");
+#define PROFILE_END_FRAME() TraceRecorder::Instant("frame", "frame");
 
 #endif
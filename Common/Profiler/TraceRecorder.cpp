@@ -0,0 +1,186 @@
+// Chrome trace event recorder, see TraceRecorder.h.
+// Format: https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/Profiler/TraceRecorder.h"
+#include "Common/StringUtils.h"
+
+namespace TraceRecorder {
+
+// Per thread, so about 2.5 MB each for threads that record anything.
+static const int MAX_EVENTS_PER_THREAD = 65536;
+
+enum class EventType : uint8_t {
+	COMPLETE,
+	INSTANT,
+};
+
+struct Event {
+	const char *name;
+	const char *category;
+	uint64_t startTicks;
+	uint64_t endTicks;
+	EventType type;
+};
+
+struct ThreadBuffer {
+	int tid;
+	const char *name;
+	std::unique_ptr<Event[]> events;
+	// Only the owning thread writes events, and then publishes them by bumping count.
+	std::atomic<int> count;
+	std::atomic<int> dropped;
+	// Which recording the events belong to.  The owning thread resets the buffer itself when
+	// it sees a new one, so Start() never touches a buffer that might be written to.
+	std::atomic<uint32_t> session;
+};
+
+std::atomic<bool> recording;
+static std::atomic<uint32_t> currentSession;
+
+static std::mutex threadsLock;
+// Never freed, since a thread might still be writing as we stop.
+static std::vector<ThreadBuffer *> threads;
+static thread_local ThreadBuffer *currentThread = nullptr;
+static thread_local const char *currentThreadName = nullptr;
+static uint64_t startTicks;
+
+static ThreadBuffer *GetThreadBuffer() {
+	if (currentThread)
+		return currentThread;
+
+	ThreadBuffer *buffer = new ThreadBuffer();
+	buffer->name = currentThreadName;
+	buffer->events.reset(new Event[MAX_EVENTS_PER_THREAD]);
+	buffer->count = 0;
+	buffer->dropped = 0;
+	buffer->session = currentSession.load(std::memory_order_acquire);
+
+	std::lock_guard<std::mutex> guard(threadsLock);
+	buffer->tid = (int)threads.size() + 1;
+	threads.push_back(buffer);
+	currentThread = buffer;
+	return buffer;
+}
+
+static void Record(const Event &event) {
+	ThreadBuffer *buffer = GetThreadBuffer();
+	const uint32_t session = currentSession.load(std::memory_order_acquire);
+	if (buffer->session.load(std::memory_order_relaxed) != session) {
+		buffer->count.store(0, std::memory_order_relaxed);
+		buffer->dropped.store(0, std::memory_order_relaxed);
+		buffer->session.store(session, std::memory_order_release);
+	}
+	int index = buffer->count.load(std::memory_order_relaxed);
+	if (index >= MAX_EVENTS_PER_THREAD) {
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	buffer->events[index] = event;
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void RecordComplete(const char *name, const char *category, uint64_t start, uint64_t end) {
+	Record(Event{ name, category, start, end, EventType::COMPLETE });
+}
+
+void RecordInstant(const char *name, const char *category) {
+	uint64_t now = time_now_ticks();
+	Record(Event{ name, category, now, now, EventType::INSTANT });
+}
+
+void SetThreadName(const char *name) {
+	currentThreadName = name;
+	if (currentThread)
+		currentThread->name = name;
+}
+
+bool Start() {
+	std::lock_guard<std::mutex> guard(threadsLock);
+	if (recording)
+		return false;
+
+	// Buffers from the last recording are skipped from now on, and reset by their threads.
+	currentSession.fetch_add(1, std::memory_order_release);
+	// Calibrate now, so it doesn't happen during the first event.
+	time_ticks_per_second();
+	startTicks = time_now_ticks();
+	recording = true;
+	return true;
+}
+
+std::string Stop() {
+	std::lock_guard<std::mutex> guard(threadsLock);
+	if (!recording)
+		return "";
+	recording = false;
+
+	const double ticksToMicros = 1000000.0 / time_ticks_per_second();
+	auto timestamp = [&](uint64_t ticks) {
+		// Events from just before Start() can show up, clamp them to the start.
+		double micros = ticks > startTicks ? (double)(ticks - startTicks) * ticksToMicros : 0.0;
+		return StringFromFormat("%.3f", micros);
+	};
+
+	json::JsonWriter writer;
+	writer.begin();
+	writer.pushArray("traceEvents");
+	const uint32_t session = currentSession.load(std::memory_order_acquire);
+	for (ThreadBuffer *buffer : threads) {
+		if (buffer->session.load(std::memory_order_acquire) != session)
+			continue;
+		int count = buffer->count.load(std::memory_order_acquire);
+		if (count == 0)
+			continue;
+
+		writer.pushDict();
+		writer.writeString("name", "thread_name");
+		writer.writeString("ph", "M");
+		writer.writeInt("pid", 1);
+		writer.writeInt("tid", buffer->tid);
+		writer.pushDict("args");
+		writer.writeString("name", buffer->name ? buffer->name : StringFromFormat("Thread %d", buffer->tid));
+		writer.pop();
+		writer.pop();
+
+		for (int i = 0; i < count; ++i) {
+			const Event &event = buffer->events[i];
+			writer.pushDict();
+			writer.writeString("name", event.name);
+			writer.writeString("cat", event.category);
+			writer.writeInt("pid", 1);
+			writer.writeInt("tid", buffer->tid);
+			writer.writeRaw("ts", timestamp(event.startTicks));
+			if (event.type == EventType::COMPLETE) {
+				writer.writeString("ph", "X");
+				writer.writeRaw("dur", StringFromFormat("%.3f", (double)(event.endTicks - event.startTicks) * ticksToMicros));
+			} else {
+				writer.writeString("ph", "i");
+				writer.writeString("s", "t");
+			}
+			writer.pop();
+		}
+
+		int dropped = buffer->dropped.load(std::memory_order_relaxed);
+		if (dropped != 0) {
+			writer.pushDict();
+			writer.writeString("name", StringFromFormat("Buffer full, dropped %d events", dropped));
+			writer.writeString("ph", "i");
+			writer.writeString("s", "t");
+			writer.writeInt("pid", 1);
+			writer.writeInt("tid", buffer->tid);
+			writer.writeRaw("ts", timestamp(buffer->events[count - 1].endTicks));
+			writer.pop();
+		}
+	}
+	writer.pop();
+	writer.writeString("displayTimeUnit", "ms");
+	writer.end();
+	return writer.str();
+}
+
+}  // namespace TraceRecorder
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "Common/TimeUtil.h"
+
+// Records what every thread is doing as Chrome trace events, viewable in chrome://tracing
+// or ui.perfetto.dev.  Each thread writes into its own buffer without locking, so this is
+// cheap enough to leave compiled in.  All name and category strings must be string literals
+// (or otherwise live until the end of the process), only the pointers are recorded.
+
+namespace TraceRecorder {
+
+extern std::atomic<bool> recording;
+
+inline bool IsRecording() {
+	return recording.load(std::memory_order_relaxed);
+}
+
+// Returns false if already recording.
+bool Start();
+// Stops recording and returns the trace as JSON.  Empty if not recording.
+std::string Stop();
+
+// Called by setCurrentThreadName().
+void SetThreadName(const char *name);
+
+void RecordComplete(const char *name, const char *category, uint64_t startTicks, uint64_t endTicks);
+void RecordInstant(const char *name, const char *category);
+
+// A span of time on the current thread, in time_now_ticks() units.
+inline void Complete(const char *name, const char *category, uint64_t startTicks, uint64_t endTicks) {
+	if (IsRecording())
+		RecordComplete(name, category, startTicks, endTicks);
+}
+
+// A point in time on the current thread, like a flip.
+inline void Instant(const char *name, const char *category) {
+	if (IsRecording())
+		RecordInstant(name, category);
+}
+
+}  // namespace TraceRecorder
+
+class TraceScope {
+public:
+	TraceScope(const char *name, const char *category) : name_(name), category_(category) {
+		startTicks_ = TraceRecorder::IsRecording() ? time_now_ticks() : 0;
+	}
+	~TraceScope() {
+		if (startTicks_ != 0)
+			TraceRecorder::Complete(name_, category_, startTicks_, time_now_ticks());
+	}
+
+private:
+	const char *name_;
+	const char *category_;
+	uint64_t startTicks_;
+};
+
+#define TRACE_THIS_SCOPE(name, category) TraceScope _trace_scoped(name, category);
@@ -15,14 +15,160 @@
 // Official SVN repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <snappy-c.h>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/WorkerPool.h"
+
+static WorkerPool &CompressionPool() {
+	static WorkerPool pool(WorkerPool::DefaultThreadCount(), "StateCompress");
+	return pool;
+}
+
+// Runs func(0) .. func(count - 1) on the compression pool, and waits for them all.
+static void RunOnCompressionPool(int count, const std::function<void(int)> &func) {
+	if (count == 1) {
+		func(0);
+		return;
+	}
+
+	std::mutex lock;
+	std::condition_variable done;
+	int remaining = count;
+	for (int i = 0; i < count; ++i) {
+		CompressionPool().Run([&, i] {
+			func(i);
+			std::lock_guard<std::mutex> guard(lock);
+			if (--remaining == 0)
+				done.notify_one();
+		});
+	}
+
+	std::unique_lock<std::mutex> guard(lock);
+	done.wait(guard, [&] { return remaining == 0; });
+}
+
+struct ChunkedOutput::OutputBlock {
+	std::vector<u8> data;
+	std::vector<u8> compressed;
+	bool changed = true;
+
+	void Compress() {
+		size_t len = snappy_max_compressed_length(data.size());
+		compressed.resize(len);
+		snappy_compress((const char *)data.data(), data.size(), (char *)compressed.data(), &len);
+		compressed.resize(len);
+		// Not needed anymore, keep the peak down.
+		std::vector<u8>().swap(data);
+	}
+};
+
+ChunkedOutput::ChunkedOutput(size_t blockSize, bool compress) : blockSize_(blockSize), compress_(compress) {
+}
+
+ChunkedOutput::~ChunkedOutput() {
+	// Workers may still be using our blocks.
+	std::unique_lock<std::mutex> guard(pendingLock_);
+	pendingDone_.wait(guard, [&] { return pending_ == 0; });
+}
+
+void ChunkedOutput::WriteSlow(const u8 *data, size_t size) {
+	while (size > 0) {
+		if (cur_ == end_) {
+			EndBlock(true);
+			blocks_.emplace_back(new OutputBlock());
+			std::vector<u8> &block = blocks_.back()->data;
+			block.swap(spare_);
+			block.resize(blockSize_);
+			cur_ = block.data();
+			end_ = cur_ + blockSize_;
+		}
+
+		size_t n = std::min(size, (size_t)(end_ - cur_));
+		memcpy(cur_, data, n);
+		cur_ += n;
+		data += n;
+		size -= n;
+		size_ += n;
+	}
+}
+
+void ChunkedOutput::EndBlock(bool async) {
+	if (!end_)
+		return;
+
+	OutputBlock *block = blocks_.back().get();
+	block->data.resize(cur_ - block->data.data());
+	cur_ = nullptr;
+	end_ = nullptr;
+	if (reference_) {
+		// Only a short block at the very end can match a short range, so sizes stay the same.
+		size_t offset = (blocks_.size() - 1) * blockSize_;
+		size_t len = block->data.size();
+		bool fits = offset + len == referenceSize_ || (len == blockSize_ && offset + len <= referenceSize_);
+		if (fits && memcmp(block->data.data(), reference_ + offset, len) == 0) {
+			block->changed = false;
+			spare_.swap(block->data);
+			block->data.clear();
+		}
+	}
+	if (!compress_)
+		return;
+
+	if (!async) {
+		block->Compress();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(pendingLock_);
+		pending_++;
+	}
+	CompressionPool().Run([this, block] {
+		block->Compress();
+		std::lock_guard<std::mutex> guard(pendingLock_);
+		if (--pending_ == 0)
+			pendingDone_.notify_one();
+	});
+}
+
+void ChunkedOutput::Finish() {
+	// We'd just be waiting anyway, so do the last one here.
+	EndBlock(false);
+
+	std::unique_lock<std::mutex> guard(pendingLock_);
+	pendingDone_.wait(guard, [&] { return pending_ == 0; });
+}
+
+const std::vector<u8> &ChunkedOutput::Block(size_t i) const {
+	return compress_ ? blocks_[i]->compressed : blocks_[i]->data;
+}
+
+void ChunkedOutput::SetReference(const u8 *reference, size_t size) {
+	_dbg_assert_(!compress_ && size_ == 0);
+	reference_ = reference;
+	referenceSize_ = size;
+}
+
+bool ChunkedOutput::BlockChanged(size_t i) const {
+	return blocks_[i]->changed;
+}
+
+void ChunkedOutput::CopyTo(u8 *dest) const {
+	_dbg_assert_(!compress_ && !reference_);
+	for (const auto &block : blocks_) {
+		memcpy(dest, block->data.data(), block->data.size());
+		dest += block->data.size();
+	}
+}
 
 PointerWrapSection PointerWrap::Section(const char *title, int ver) {
 	return Section(title, ver, ver);
@@ -71,7 +217,7 @@ void PointerWrap::SetError(Error error_) {
 bool PointerWrap::ExpectVoid(void *data, int size) {
 	switch (mode) {
 	case MODE_READ:	if (memcmp(data, *ptr, size) != 0) return false; break;
-	case MODE_WRITE: memcpy(*ptr, data, size); break;
+	case MODE_WRITE: WriteBytes(data, size); break;
 	case MODE_MEASURE: break;  // MODE_MEASURE - don't need to do anything
 	case MODE_VERIFY:
 		for (int i = 0; i < size; i++)
@@ -86,7 +232,7 @@ bool PointerWrap::ExpectVoid(void *data, int size) {
 void PointerWrap::DoVoid(void *data, int size) {
 	switch (mode) {
 	case MODE_READ:	memcpy(data, *ptr, size); break;
-	case MODE_WRITE: memcpy(*ptr, data, size); break;
+	case MODE_WRITE: WriteBytes(data, size); break;
 	case MODE_MEASURE: break;  // MODE_MEASURE - don't need to do anything
 	case MODE_VERIFY:
 		for (int i = 0; i < size; i++)
@@ -103,7 +249,7 @@ void Do(PointerWrap &p, std::string &x) {
 
 	switch (p.mode) {
 	case PointerWrap::MODE_READ: x = (char*)*p.ptr; break;
-	case PointerWrap::MODE_WRITE: memcpy(*p.ptr, x.c_str(), stringLen); break;
+	case PointerWrap::MODE_WRITE: p.WriteBytes(x.c_str(), stringLen); break;
 	case PointerWrap::MODE_MEASURE: break;
 	case PointerWrap::MODE_VERIFY: _dbg_assert_msg_(!strcmp(x.c_str(), (char*)*p.ptr), "Savestate verification failure: \"%s\" != \"%s\" (at %p).\n", x.c_str(), (char *)*p.ptr, p.ptr); break;
 	}
@@ -116,7 +262,7 @@ void Do(PointerWrap &p, std::wstring &x) {
 
 	switch (p.mode) {
 	case PointerWrap::MODE_READ: x = (wchar_t*)*p.ptr; break;
-	case PointerWrap::MODE_WRITE: memcpy(*p.ptr, x.c_str(), stringLen); break;
+	case PointerWrap::MODE_WRITE: p.WriteBytes(x.c_str(), stringLen); break;
 	case PointerWrap::MODE_MEASURE: break;
 	case PointerWrap::MODE_VERIFY: _dbg_assert_msg_(x == (wchar_t*)*p.ptr, "Savestate verification failure: \"%ls\" != \"%ls\" (at %p).\n", x.c_str(), (wchar_t*)*p.ptr, p.ptr); break;
 	}
@@ -129,7 +275,7 @@ void Do(PointerWrap &p, std::u16string &x) {
 
 	switch (p.mode) {
 	case PointerWrap::MODE_READ: x = (char16_t*)*p.ptr; break;
-	case PointerWrap::MODE_WRITE: memcpy(*p.ptr, x.c_str(), stringLen); break;
+	case PointerWrap::MODE_WRITE: p.WriteBytes(x.c_str(), stringLen); break;
 	case PointerWrap::MODE_MEASURE: break;
 	case PointerWrap::MODE_VERIFY: _dbg_assert_msg_(x == (char16_t*)*p.ptr, "Savestate verification failure: (at %p).\n", x.c_str()); break;
 	}
@@ -244,6 +390,44 @@ CChunkFileReader::Error CChunkFileReader::GetFileTitle(const std::string &filena
 	return LoadFileHeader(pFile, header, title);
 }
 
+bool CChunkFileReader::DecompressBlocks(const u8 *data, size_t sz, u8 *dest, size_t destSize) {
+	u32 header[2];
+	if (sz < sizeof(header))
+		return false;
+	memcpy(header, data, sizeof(header));
+	const u32 blockSize = header[0];
+	const u32 numBlocks = header[1];
+	if (blockSize == 0 || (u64)numBlocks * blockSize < destSize || (numBlocks != 0 && (u64)(numBlocks - 1) * blockSize >= destSize))
+		return false;
+	if (sizeof(header) + (u64)numBlocks * sizeof(u32) > sz)
+		return false;
+
+	std::vector<u32> sizes(numBlocks);
+	memcpy(sizes.data(), data + sizeof(header), numBlocks * sizeof(u32));
+	std::vector<size_t> offsets(numBlocks);
+	size_t offset = sizeof(header) + numBlocks * sizeof(u32);
+	for (u32 i = 0; i < numBlocks; ++i) {
+		offsets[i] = offset;
+		offset += sizes[i];
+	}
+	if (offset != sz)
+		return false;
+
+	std::atomic<bool> success(true);
+	RunOnCompressionPool((int)numBlocks, [&](int i) {
+		const char *src = (const char *)data + offsets[i];
+		const size_t expected = std::min((size_t)blockSize, destSize - (size_t)i * blockSize);
+		size_t len = 0;
+		if (snappy_uncompressed_length(src, sizes[i], &len) != SNAPPY_OK || len != expected) {
+			success = false;
+			return;
+		}
+		if (snappy_uncompress(src, sizes[i], (char *)dest + (size_t)i * blockSize, &len) != SNAPPY_OK || len != expected)
+			success = false;
+	});
+	return success;
+}
+
 CChunkFileReader::Error CChunkFileReader::LoadFile(const std::string &filename, std::string *gitVersion, u8 *&_buffer, size_t &sz, std::string *failureReason) {
 	if (!File::Exists(filename)) {
 		*failureReason = "LoadStateDoesntExist";
@@ -268,7 +452,18 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const std::string &filename,
 		return ERROR_BAD_FILE;
 	}
 
-	if (header.Compress) {
+	if (header.Compress == COMPRESS_SNAPPY_BLOCKS) {
+		u8 *uncomp_buffer = new u8[header.UncompressedSize];
+		if (!DecompressBlocks(buffer, sz, uncomp_buffer, header.UncompressedSize)) {
+			ERROR_LOG(SAVESTATE, "ChunkReader: Failed to decompress file");
+			delete [] uncomp_buffer;
+			delete [] buffer;
+			return ERROR_BAD_FILE;
+		}
+		_buffer = uncomp_buffer;
+		sz = header.UncompressedSize;
+		delete [] buffer;
+	} else if (header.Compress) {
 		u8 *uncomp_buffer = new u8[header.UncompressedSize];
 		size_t uncomp_size = header.UncompressedSize;
 		auto status = snappy_uncompress((const char *)buffer, sz, (char *)uncomp_buffer, &uncomp_size);
@@ -300,38 +495,32 @@ CChunkFileReader::Error CChunkFileReader::LoadFile(const std::string &filename,
 	return ERROR_NONE;
 }
 
-// Takes ownership of buffer.
-CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz) {
+CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, const ChunkedOutput &output) {
 	INFO_LOG(SAVESTATE, "ChunkReader: Writing %s", filename.c_str());
 
 	File::IOFile pFile(filename, "wb");
 	if (!pFile) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Error opening file for write");
-		free(buffer);
 		return ERROR_BAD_FILE;
 	}
 
-	// Make sure we can allocate a buffer to compress before compressing.
-	size_t write_len = snappy_max_compressed_length(sz);
-	u8 *compressed_buffer = (u8 *)malloc(write_len);
-	u8 *write_buffer = buffer;
-	if (!compressed_buffer) {
-		ERROR_LOG(SAVESTATE, "ChunkReader: Unable to allocate compressed buffer");
-		// We'll save uncompressed.  Better than not saving...
-		write_len = sz;
-	} else {
-		snappy_compress((const char *)buffer, sz, (char *)compressed_buffer, &write_len);
-		free(buffer);
-
-		write_buffer = compressed_buffer;
+	// The block table goes first, see COMPRESS_SNAPPY_BLOCKS.
+	std::vector<u32> table;
+	table.push_back((u32)output.BlockSize());
+	table.push_back((u32)output.NumBlocks());
+	size_t write_len = 0;
+	for (size_t i = 0; i < output.NumBlocks(); ++i) {
+		table.push_back((u32)output.Block(i).size());
+		write_len += output.Block(i).size();
 	}
+	write_len += table.size() * sizeof(u32);
 
 	// Create header
 	SChunkHeader header{};
-	header.Compress = compressed_buffer ? 1 : 0;
+	header.Compress = COMPRESS_SNAPPY_BLOCKS;
 	header.Revision = REVISION_CURRENT;
 	header.ExpectedSize = (u32)write_len;
-	header.UncompressedSize = (u32)sz;
+	header.UncompressedSize = (u32)output.Size();
 	truncate_cpy(header.GitVersion, gitVersion);
 
 	// Setup the fixed-length title.
@@ -341,23 +530,23 @@ CChunkFileReader::Error CChunkFileReader::SaveFile(const std::string &filename,
 	// Now let's start writing out the file...
 	if (!pFile.WriteArray(&header, 1)) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing header");
-		free(write_buffer);
 		return ERROR_BAD_FILE;
 	}
 	if (!pFile.WriteArray(titleFixed, sizeof(titleFixed))) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing title");
-		free(write_buffer);
 		return ERROR_BAD_FILE;
 	}
 
-	if (!pFile.WriteBytes(write_buffer, write_len)) {
+	bool success = pFile.WriteArray(table.data(), table.size());
+	for (size_t i = 0; i < output.NumBlocks() && success; ++i) {
+		const std::vector<u8> &block = output.Block(i);
+		success = block.empty() || pFile.WriteBytes(block.data(), block.size());
+	}
+	if (!success) {
 		ERROR_LOG(SAVESTATE, "ChunkReader: Failed writing compressed data");
-		free(write_buffer);
 		return ERROR_BAD_FILE;
-	} else if (sz != write_len) {
-		INFO_LOG(SAVESTATE, "Savestate: Compressed %i bytes into %i", (int)sz, (int)write_len);
 	}
-	free(write_buffer);
+	INFO_LOG(SAVESTATE, "Savestate: Compressed %i bytes into %i", (int)output.Size(), (int)write_len);
 
 	INFO_LOG(SAVESTATE, "ChunkReader: Done writing %s", filename.c_str());
 	return ERROR_NONE;
@@ -29,9 +29,13 @@
 // + Sections can be versioned for backwards/forwards compatibility
 // - Serialization code for anything complex has to be manually written.
 
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
-#include <cstdlib>
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
@@ -48,6 +52,67 @@ struct LinkedListItem : public T
 
 class PointerWrap;
 
+// Growable destination for PointerWrap::MODE_WRITE, so a state can be written without measuring it first.
+// Data is kept in fixed size blocks.  When compressing, each block is snappy compressed on a worker
+// thread as soon as it fills up, while the rest of the state is still being written.
+class ChunkedOutput {
+public:
+	ChunkedOutput(size_t blockSize, bool compress);
+	~ChunkedOutput();
+
+	void Write(const void *data, size_t size) {
+		if (size <= (size_t)(end_ - cur_)) {
+			memcpy(cur_, data, size);
+			cur_ += size;
+			size_ += size;
+		} else {
+			WriteSlow((const u8 *)data, size);
+		}
+	}
+
+	// Ends the last block, and waits for any compression to finish.
+	void Finish();
+
+	size_t Size() const { return size_; }
+	size_t BlockSize() const { return blockSize_; }
+	size_t NumBlocks() const { return blocks_.size(); }
+	// After Finish().  These are the compressed blocks when compressing.
+	const std::vector<u8> &Block(size_t i) const;
+	// After Finish(), without compression.  Copies Size() bytes.
+	void CopyTo(u8 *dest) const;
+
+	// Compares each block against the same range of reference as it's finished, and drops the ones
+	// that match, so only changes are kept.  Without compression only, and reference must not change until Finish().
+	void SetReference(const u8 *reference, size_t size);
+	// After Finish().  With a reference, dropped blocks are empty.
+	bool BlockChanged(size_t i) const;
+
+private:
+	struct OutputBlock;
+
+	void WriteSlow(const u8 *data, size_t size);
+	void EndBlock(bool async);
+
+	size_t blockSize_;
+	bool compress_;
+	std::vector<std::unique_ptr<OutputBlock>> blocks_;
+	u8 *cur_ = nullptr;
+	u8 *end_ = nullptr;
+	size_t size_ = 0;
+
+	const u8 *reference_ = nullptr;
+	size_t referenceSize_ = 0;
+	// A dropped block's buffer, to reuse for the next one.
+	std::vector<u8> spare_;
+
+	std::mutex pendingLock_;
+	std::condition_variable pendingDone_;
+	int pending_ = 0;
+
+	ChunkedOutput(const ChunkedOutput &other) = delete;
+	void operator =(const ChunkedOutput &other) = delete;
+};
+
 class PointerWrapSection
 {
 public:
@@ -118,8 +183,19 @@ class PointerWrap
 
 	void DoMarker(const char *prevName, u32 arbitraryNumber = 0x42);
 
+	// With an output, MODE_WRITE goes there instead, and ptr only counts bytes (like MODE_MEASURE.)
+	void SetOutput(ChunkedOutput *output) { output_ = output; }
+	// For MODE_WRITE: copies to the output or ptr, without advancing.
+	void WriteBytes(const void *data, int size) {
+		if (output_)
+			output_->Write(data, size);
+		else
+			memcpy(*ptr, data, size);
+	}
+
 private:
 	const char *firstBadSectionTitle_ = nullptr;
+	ChunkedOutput *output_ = nullptr;
 };
 
 class CChunkFileReader
@@ -190,21 +266,33 @@ class CChunkFileReader
 		return error;
 	}
 
+	// Writes the state in one pass, and finishes output.
+	template<class T>
+	static Error SaveToOutput(ChunkedOutput &output, T &_class)
+	{
+		u8 *ptr = nullptr;
+		PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+		p.SetOutput(&output);
+		_class.DoState(p);
+		output.Finish();
+
+		if (p.error != p.ERROR_FAILURE) {
+			return ERROR_NONE;
+		} else {
+			return ERROR_BROKEN_STATE;
+		}
+	}
+
 	// Save file template
 	template<class T>
 	static Error Save(const std::string &filename, const std::string &title, const char *gitVersion, T& _class)
 	{
-		// Get data
-		size_t const sz = MeasurePtr(_class);
-		u8 *buffer = (u8 *)malloc(sz);
-		if (!buffer)
-			return ERROR_BAD_ALLOC;
-		Error error = SavePtr(buffer, _class);
-
-		// SaveFile takes ownership of buffer
-		if (error == ERROR_NONE)
-			error = SaveFile(filename, title, gitVersion, buffer, sz);
-		return error;
+		// One pass, compressing as we go.
+		ChunkedOutput output(SAVE_BLOCK_SIZE, true);
+		Error error = SaveToOutput(output, _class);
+		if (error != ERROR_NONE)
+			return error;
+		return SaveFile(filename, title, gitVersion, output);
 	}
 	
 	template <class T>
@@ -249,7 +337,19 @@ class CChunkFileReader
 		REVISION_CURRENT = REVISION_TITLE,
 	};
 
+	// Values for SChunkHeader::Compress.
+	enum {
+		COMPRESS_NONE = 0,
+		COMPRESS_SNAPPY = 1,
+		// A u32 block size and count, a u32 compressed size per block, then the blocks.
+		// Each is compressed separately, so they can be decompressed in parallel.
+		COMPRESS_SNAPPY_BLOCKS = 2,
+	};
+
+	static const size_t SAVE_BLOCK_SIZE = 1024 * 1024;
+
+	static bool DecompressBlocks(const u8 *data, size_t sz, u8 *dest, size_t destSize);
 	static Error LoadFile(const std::string &filename, std::string *gitVersion, u8 *&buffer, size_t &sz, std::string *failureReason);
-	static Error SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, u8 *buffer, size_t sz);
+	static Error SaveFile(const std::string &filename, const std::string &title, const char *gitVersion, const ChunkedOutput &output);
 	static Error LoadFileHeader(File::IOFile &pFile, SChunkHeader &header, std::string *title);
 };
@@ -21,7 +21,7 @@ void PrioritizedWorkQueue::Add(PrioritizedWorkQueueItem *item) {
 void PrioritizedWorkQueue::Stop() {
 	std::lock_guard<std::mutex> guard(mutex_);
 	done_ = true;
-	notEmpty_.notify_one();
+	notEmpty_.notify_all();
 }
 
 void PrioritizedWorkQueue::Flush() {
@@ -57,23 +57,25 @@ bool PrioritizedWorkQueue::WaitUntilDone(bool all) {
 
 void PrioritizedWorkQueue::NotifyDrain() {
 	std::lock_guard<std::mutex> guard(drainMutex_);
-	drain_.notify_one();
+	drain_.notify_all();
 }
 
 bool PrioritizedWorkQueue::AllItemsDone() {
 	std::lock_guard<std::mutex> guard(mutex_);
-	return queue_.empty() && !working_;
+	return queue_.empty() && working_ == 0;
 }
 
 // The worker should simply call this in a loop. Will block when appropriate.
-PrioritizedWorkQueueItem *PrioritizedWorkQueue::Pop() {
-	{
-		std::lock_guard<std::mutex> guard(mutex_);
-		working_ = false;  // The thread only calls Pop if it's done.
-	}
+PrioritizedWorkQueueItem *PrioritizedWorkQueue::Pop(bool finishedItem) {
+	if (finishedItem) {
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			working_--;
+		}
 
-	// Important: make sure mutex_ is not locked while draining.
-	NotifyDrain();
+		// Important: make sure mutex_ is not locked while draining.
+		NotifyDrain();
+	}
 
 	std::unique_lock<std::mutex> guard(mutex_);
 	if (done_) {
@@ -100,7 +102,7 @@ PrioritizedWorkQueueItem *PrioritizedWorkQueue::Pop() {
 	if (best != queue_.end()) {
 		PrioritizedWorkQueueItem *poppedItem = *best;
 		queue_.erase(best);
-		working_ = true;  // This will be worked on.
+		working_++;  // This will be worked on.
 		return poppedItem;
 	} else {
 		// Not really sure how this can happen, but let's be safe.
@@ -110,12 +112,14 @@ PrioritizedWorkQueueItem *PrioritizedWorkQueue::Pop() {
 
 // TODO: This feels ugly. Revisit later.
 
-static std::thread *workThread;
+static std::vector<std::thread *> workThreads;
 
 static void threadfunc(PrioritizedWorkQueue *wq) {
 	setCurrentThreadName("PrioQueue");
+	bool finishedItem = false;
 	while (true) {
-		PrioritizedWorkQueueItem *item = wq->Pop();
+		PrioritizedWorkQueueItem *item = wq->Pop(finishedItem);
+		finishedItem = item != nullptr;
 		if (!item) {
 			if (wq->Done())
 				break;
@@ -126,15 +130,16 @@ static void threadfunc(PrioritizedWorkQueue *wq) {
 	}
 }
 
-void ProcessWorkQueueOnThreadWhile(PrioritizedWorkQueue *wq) {
-	workThread = new std::thread([=](){threadfunc(wq);});
+void ProcessWorkQueueOnThreadWhile(PrioritizedWorkQueue *wq, int threadCount) {
+	for (int i = 0; i < threadCount; ++i)
+		workThreads.push_back(new std::thread([=](){threadfunc(wq);}));
 }
 
 void StopProcessingWorkQueue(PrioritizedWorkQueue *wq) {
 	wq->Stop();
-	if (workThread) {
+	for (std::thread *workThread : workThreads) {
 		workThread->join();
 		delete workThread;
 	}
-	workThread = nullptr;
+	workThreads.clear();
 }
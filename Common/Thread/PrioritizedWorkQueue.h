@@ -25,13 +25,14 @@ class PrioritizedWorkQueueItem {
 
 class PrioritizedWorkQueue {
 public:
-	PrioritizedWorkQueue() : done_(false), working_(false) {}
+	PrioritizedWorkQueue() : done_(false), working_(0) {}
 	~PrioritizedWorkQueue();
 	// Takes ownership.
 	void Add(PrioritizedWorkQueueItem *item);
 
 	// The worker should simply call this in a loop. Will block when appropriate.
-	PrioritizedWorkQueueItem *Pop();
+	// Pass true if the worker just finished an item from the last Pop().
+	PrioritizedWorkQueueItem *Pop(bool finishedItem);
 
 	void Flush();
 	bool Done() { return done_; }
@@ -39,7 +40,7 @@ class PrioritizedWorkQueue {
 	bool WaitUntilDone(bool all = true);
 
 	bool IsWorking() {
-		return working_;
+		return working_ != 0;
 	}
 
 private:
@@ -47,7 +48,8 @@ class PrioritizedWorkQueue {
 	bool AllItemsDone();
 
 	bool done_;
-	bool working_;
+	// Number of workers running an item.
+	int working_;
 	std::mutex mutex_;
 	std::mutex drainMutex_;
 	std::condition_variable notEmpty_;
@@ -59,7 +61,8 @@ class PrioritizedWorkQueue {
 };
 
 
-// Starts up a thread that keeps trying to run this workqueue.
+// Starts up threads that keep trying to run this workqueue.  With more than one, items
+// may run at the same time, in priority order.
 // TODO: This feels ugly. Revisit later.
-void ProcessWorkQueueOnThreadWhile(PrioritizedWorkQueue *wq);
+void ProcessWorkQueueOnThreadWhile(PrioritizedWorkQueue *wq, int threadCount = 1);
 void StopProcessingWorkQueue(PrioritizedWorkQueue *wq);
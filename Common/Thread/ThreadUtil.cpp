@@ -12,6 +12,7 @@
 #include <cstdint>
 
 #include "Common/Log.h"
+#include "Common/Profiler/TraceRecorder.h"
 #include "Common/Thread/ThreadUtil.h"
 
 #if defined(__ANDROID__) || defined(__APPLE__) || (defined(__GLIBC__) && defined(_GNU_SOURCE))
@@ -112,6 +113,7 @@ void setCurrentThreadName(const char* threadName) {
 #ifdef TLS_SUPPORTED
 	curThreadName = threadName;
 #endif
+	TraceRecorder::SetThreadName(threadName);
 }
 
 void AssertCurrentThreadName(const char *threadName) {
@@ -0,0 +1,120 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+
+#include "Common/Thread/WorkerPool.h"
+#include "Common/Thread/ThreadUtil.h"
+
+#include "Common/Log.h"
+
+WorkerPool::WorkerPool(int numThreads, const char *name) : name_(name) {
+	if (numThreads <= 0) {
+		INFO_LOG(SYSTEM, "WorkerPool %s: Bad number of threads %d", name, numThreads);
+		numThreads = 1;
+	}
+	threads_.reserve(numThreads);
+	for (int i = 0; i < numThreads; ++i) {
+		threads_.push_back(std::thread(std::bind(&WorkerPool::WorkFunc, this)));
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	std::deque<Item> dropped;
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		done_ = true;
+		dropped.swap(queue_);
+		workAvailable_.notify_all();
+	}
+	for (auto &thread : threads_) {
+		if (thread.joinable())
+			thread.join();
+	}
+	CancelItems(dropped);
+}
+
+void WorkerPool::Run(std::function<void()> func) {
+	Run(std::move(func), nullptr);
+}
+
+void WorkerPool::Run(std::function<void()> func, std::function<void()> cancel) {
+	std::lock_guard<std::mutex> guard(mutex_);
+	queue_.push_back(Item{ std::move(func), std::move(cancel) });
+	workAvailable_.notify_one();
+}
+
+void WorkerPool::WaitUntilIdle() {
+	std::unique_lock<std::mutex> guard(mutex_);
+	while (!queue_.empty() || running_ != 0) {
+		idle_.wait(guard);
+	}
+}
+
+int WorkerPool::Flush() {
+	std::deque<Item> dropped;
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		dropped.swap(queue_);
+		if (running_ == 0)
+			idle_.notify_all();
+	}
+	// Outside the lock, the cancel functions may well queue more work.
+	CancelItems(dropped);
+	return (int)dropped.size();
+}
+
+void WorkerPool::CancelItems(std::deque<Item> &items) {
+	for (auto &item : items) {
+		if (item.cancel)
+			item.cancel();
+	}
+}
+
+int WorkerPool::QueueSize() {
+	std::lock_guard<std::mutex> guard(mutex_);
+	return (int)queue_.size();
+}
+
+int WorkerPool::DefaultThreadCount() {
+	int cores = (int)std::thread::hardware_concurrency();
+	return std::max(1, std::min(cores - 1, 8));
+}
+
+void WorkerPool::WorkFunc() {
+	setCurrentThreadName(name_);
+	std::unique_lock<std::mutex> guard(mutex_);
+	while (true) {
+		while (!done_ && queue_.empty()) {
+			workAvailable_.wait(guard);
+		}
+		if (done_)
+			break;
+
+		std::function<void()> work = std::move(queue_.front().func);
+		queue_.pop_front();
+		running_++;
+		guard.unlock();
+
+		work();
+
+		guard.lock();
+		running_--;
+		if (running_ == 0 && queue_.empty())
+			idle_.notify_all();
+	}
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/Thread/Executor.h"
+
+// A fixed set of threads pulling independent work items off a shared FIFO.
+// Unlike ThreadPool, which splits a single loop and waits for it, this is meant
+// for fire-and-forget background jobs (shader compiles, file scans, compression...).
+// Items that were never started when the pool is flushed or destroyed are dropped, and their
+// cancel function (if any) is called instead, so anyone waiting on them can be released.
+class WorkerPool : public threading::Executor {
+public:
+	// name must be a string literal, see setCurrentThreadName.
+	WorkerPool(int numThreads, const char *name);
+	~WorkerPool();
+
+	void Run(std::function<void()> func) override;
+	// cancel runs (on the calling thread of Flush() or the destructor) if func never gets to run.
+	void Run(std::function<void()> func, std::function<void()> cancel);
+
+	// Blocks until the queue is empty and no worker is running an item.
+	void WaitUntilIdle();
+	// Drops all queued items that haven't started yet, calling their cancel functions.
+	// Returns how many were dropped.
+	int Flush();
+
+	int NumThreads() const { return (int)threads_.size(); }
+	int QueueSize();
+
+	// Suggested worker count for CPU-bound background work, leaving a core for the emu thread.
+	static int DefaultThreadCount();
+
+private:
+	struct Item {
+		std::function<void()> func;
+		std::function<void()> cancel;
+	};
+
+	void WorkFunc();
+	static void CancelItems(std::deque<Item> &items);
+
+	const char *name_;
+	std::vector<std::thread> threads_;
+	std::deque<Item> queue_;
+	std::mutex mutex_;
+	std::condition_variable workAvailable_;
+	std::condition_variable idle_;
+	int running_ = 0;
+	bool done_ = false;
+
+	WorkerPool(const WorkerPool &other) = delete;
+	void operator =(const WorkerPool &other) = delete;
+};
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstdio>
 #include <cstdint>
 #include <ctime>
@@ -19,6 +20,14 @@
 #include <unistd.h>
 #endif
 
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
 static double curtime = 0;
 
 #ifdef _WIN32
@@ -54,6 +63,54 @@ double time_now_d() {
 
 #endif
 
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+
+uint64_t time_now_ticks() {
+	return __rdtsc();
+}
+
+static double CalibrateTicks() {
+	// Not called often, so just measure against the normal clock for a bit.
+	const double startTime = time_now_d();
+	const uint64_t startTicks = time_now_ticks();
+	double endTime;
+	do {
+		endTime = time_now_d();
+	} while (endTime - startTime < 0.02);
+	return (double)(time_now_ticks() - startTicks) / (endTime - startTime);
+}
+
+#elif PPSSPP_ARCH(ARM64) && !defined(_MSC_VER)
+
+uint64_t time_now_ticks() {
+	uint64_t ticks;
+	asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+	return ticks;
+}
+
+static double CalibrateTicks() {
+	uint64_t freq;
+	asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+	return (double)freq;
+}
+
+#else
+
+uint64_t time_now_ticks() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double CalibrateTicks() {
+	return 1000000000.0;
+}
+
+#endif
+
+double time_ticks_per_second() {
+	static const double ticksPerSecond = CalibrateTicks();
+	return ticksPerSecond;
+}
+
 void sleep_ms(int ms) {
 #ifdef _WIN32
 	Sleep(ms);
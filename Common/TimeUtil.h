@@ -1,8 +1,15 @@
 #pragma once
 
+#include <cstdint>
+
 // Seconds.
 double time_now_d();
 
+// Raw tick counter, cheap enough for hot paths (the TSC on x86.)  Only differences are meaningful.
+uint64_t time_now_ticks();
+// How many ticks time_now_ticks() advances per second.  Calibrated on first use.
+double time_ticks_per_second();
+
 // Sleep. Does not necessarily have millisecond granularity, especially on Windows.
 void sleep_ms(int ms);
 
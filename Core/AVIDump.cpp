@@ -8,15 +8,23 @@
 #define __STDC_CONSTANT_MACROS 1
 #endif
 
-#include <string>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #ifdef USE_FFMPEG
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
 #include <libavutil/mathematics.h>
 #include <libswscale/swscale.h>
 }
@@ -25,11 +33,14 @@ extern "C" {
 
 #include "Common/File/FileUtil.h"
 #include "Common/ColorConv.h"
+#include "Common/Thread/ThreadUtil.h"
 
 #include "Core/Config.h"
 #include "Core/AVIDump.h"
+#include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/Screenshot.h"
+#include "Core/Util/AudioFormat.h"
 
 #include "GPU/Common/GPUDebugInterface.h"
 
@@ -46,8 +57,10 @@ extern "C" {
 
 static AVFormatContext* s_format_context = nullptr;
 static AVStream* s_stream = nullptr;
+static AVStream* s_audio_stream = nullptr;
 static AVFrame* s_src_frame = nullptr;
 static AVFrame* s_scaled_frame = nullptr;
+static AVFrame* s_audio_frame = nullptr;
 static SwsContext* s_sws_context = nullptr;
 
 #endif
@@ -59,8 +72,56 @@ static bool s_start_dumping = false;
 static int s_current_width;
 static int s_current_height;
 static int s_file_index = 0;
+static std::string s_file_base_name;
 static GPUDebugBuffer buf;
 
+// Frames are converted on the emu thread into a small pool, and scaled, encoded and written on the
+// encoder thread.  If the encoder can't keep up, we drop frames rather than slow down the game.
+static const int FRAME_POOL_SIZE = 8;
+// Audio comes in small blocks, this is a bit more than the frame pool's worth.  Past that, audio is
+// dropped too, and picks up again at the right time.
+static const int AUDIO_QUEUE_MAX = 256;
+static const int AUDIO_SAMPLE_RATE = 44100;
+
+struct CapturedFrame {
+	std::vector<u8> rgb;
+	u32 w = 0;
+	u32 h = 0;
+};
+
+struct EncodeItem {
+	// Index into s_frames, or -1 for audio.
+	int frame;
+	std::vector<s16> audio;
+	// Emulated time, from CoreTiming.
+	u64 timeUs;
+	// For audio, set when blocks were dropped before this one.
+	bool audioGap;
+};
+
+static CapturedFrame s_frames[FRAME_POOL_SIZE];
+static std::vector<int> s_free_frames;
+static std::vector<std::vector<s16>> s_free_audio;
+static std::deque<EncodeItem> s_queue;
+static std::mutex s_queue_lock;
+static std::condition_variable s_queue_cond;
+static std::thread s_encoder_thread;
+// Checked by AddFrame/AddAudio on the emu and audio threads.
+static std::atomic<bool> s_encoder_running{ false };
+static bool s_encoder_stop = false;
+static int s_frames_captured = 0;
+static int s_frames_dropped = 0;
+static int s_audio_queued = 0;
+static int s_audio_dropped = 0;
+static bool s_audio_gap = false;
+
+// Only used on the encoder thread while it runs.
+static bool s_file_open = false;
+static bool s_file_has_start = false;
+static u64 s_file_start_us = 0;
+static s64 s_last_video_pts = -1;
+static s64 s_next_audio_pts = -1;
+
 static void InitAVCodec() {
 	static bool first_run = true;
 	if (first_run) {
@@ -78,20 +139,45 @@ bool AVIDump::Start(int w, int h)
 	s_current_width = w;
 	s_current_height = h;
 
+	// Use gameID_EmulatedTimestamp for filename
+	std::string discID = g_paramSFO.GetDiscID();
+	s_file_base_name = StringFromFormat("%s%s_%s", GetSysDirectory(DIRECTORY_VIDEO).c_str(), discID.c_str(), KernelTimeNowFormatted().c_str());
+
 	InitAVCodec();
 	bool success = CreateAVI();
-	if (!success)
+	if (!success) {
 		CloseFile();
-	return success;
+		return false;
+	}
+
+	{
+		// Don't pick up anything left over from the last dump.
+		std::lock_guard<std::mutex> guard(s_queue_lock);
+		s_queue.clear();
+		s_free_frames.clear();
+		for (int i = 0; i < FRAME_POOL_SIZE; ++i)
+			s_free_frames.push_back(i);
+		s_frames_captured = 0;
+		s_frames_dropped = 0;
+		s_audio_queued = 0;
+		s_audio_dropped = 0;
+		s_audio_gap = false;
+		s_encoder_stop = false;
+	}
+	s_encoder_running = true;
+	s_encoder_thread = std::thread(&AVIDump::EncoderThread);
+	return true;
 }
 
 bool AVIDump::CreateAVI() {
 #ifdef USE_FFMPEG
 	AVCodec* codec = nullptr;
+	s_file_has_start = false;
+	s_last_video_pts = -1;
+	s_next_audio_pts = -1;
 
-	// Use gameID_EmulatedTimestamp for filename
-	std::string discID = g_paramSFO.GetDiscID();
-	std::string video_file_name = StringFromFormat("%s%s_%s.avi", GetSysDirectory(DIRECTORY_VIDEO).c_str(), discID.c_str(), KernelTimeNowFormatted().c_str()).c_str();
+	// After a resolution change, the name gets the file index so we don't overwrite the first part.
+	std::string video_file_name = s_file_index == 0 ? s_file_base_name + ".avi" : StringFromFormat("%s_%d.avi", s_file_base_name.c_str(), s_file_index);
 
 	s_format_context = avformat_alloc_context();
 	std::stringstream s_file_index_str;
@@ -143,6 +229,25 @@ bool AVIDump::CreateAVI() {
 		return false;
 #endif
 
+	// The mixed audio goes in the same file as plain PCM.
+	AVCodec* audio_codec = nullptr;
+	if (!(s_audio_stream = avformat_new_stream(s_format_context, nullptr)))
+		return false;
+	s_audio_stream->codec->codec_id = AV_CODEC_ID_PCM_S16LE;
+	s_audio_stream->codec->codec_type = AVMEDIA_TYPE_AUDIO;
+	s_audio_stream->codec->sample_fmt = AV_SAMPLE_FMT_S16;
+	s_audio_stream->codec->sample_rate = AUDIO_SAMPLE_RATE;
+	s_audio_stream->codec->channels = 2;
+	s_audio_stream->codec->channel_layout = AV_CH_LAYOUT_STEREO;
+	s_audio_stream->codec->time_base.num = 1;
+	s_audio_stream->codec->time_base.den = AUDIO_SAMPLE_RATE;
+
+	if (!(audio_codec = avcodec_find_encoder(s_audio_stream->codec->codec_id)) || (avcodec_open2(s_audio_stream->codec, audio_codec, nullptr) < 0))
+	{
+		return false;
+	}
+	s_audio_frame = av_frame_alloc();
+
 	NOTICE_LOG(G3D, "Opening file %s for dumping", s_format_context->filename);
 	if (avio_open(&s_format_context->pb, s_format_context->filename, AVIO_FLAG_WRITE) < 0 || avformat_write_header(s_format_context, nullptr))
 	{
@@ -150,6 +255,7 @@ bool AVIDump::CreateAVI() {
 		return false;
 	}
 
+	s_file_open = true;
 	return true;
 #else
 	return false;
@@ -168,6 +274,22 @@ static void PreparePacket(AVPacket* pkt) {
 
 void AVIDump::AddFrame()
 {
+	if (!s_encoder_running)
+		return;
+
+	int index;
+	{
+		std::lock_guard<std::mutex> guard(s_queue_lock);
+		s_frames_captured++;
+		if (s_free_frames.empty()) {
+			// The encoder is behind, better to skip a frame than to stall the game.
+			s_frames_dropped++;
+			return;
+		}
+		index = s_free_frames.back();
+		s_free_frames.pop_back();
+	}
+
 	u32 w = 0;
 	u32 h = 0;
 	if (g_Config.bDumpVideoOutput) {
@@ -179,27 +301,104 @@ void AVIDump::AddFrame()
 		w = PSP_CoreParameter().renderWidth;
 		h = PSP_CoreParameter().renderHeight;
 	}
-	CheckResolution(w, h);
 	u8 *flipbuffer = nullptr;
 	const u8 *buffer = ConvertBufferToScreenshot(buf, false, flipbuffer, w, h);
 
+	// buf may point straight at emulated VRAM, so we need our own copy.
+	CapturedFrame &frame = s_frames[index];
+	frame.w = w;
+	frame.h = h;
+	frame.rgb.assign(buffer, buffer + w * h * 3);
+	delete[] flipbuffer;
+
+	std::lock_guard<std::mutex> guard(s_queue_lock);
+	s_queue.push_back(EncodeItem{ index, std::vector<s16>(), CoreTiming::GetGlobalTimeUs(), false });
+	s_queue_cond.notify_one();
+}
+
+void AVIDump::AddAudio(const s32 *samples, int frames)
+{
+	if (!s_encoder_running)
+		return;
+
+	std::lock_guard<std::mutex> guard(s_queue_lock);
+	if (s_audio_queued >= AUDIO_QUEUE_MAX) {
+		// Same as video, don't let the encoder stall the game or eat memory.
+		s_audio_dropped++;
+		s_audio_gap = true;
+		return;
+	}
+	s_audio_queued++;
+
+	std::vector<s16> audio;
+	if (!s_free_audio.empty()) {
+		audio.swap(s_free_audio.back());
+		s_free_audio.pop_back();
+	}
+	audio.resize(frames * 2);
+	ClampBufferToS16(audio.data(), samples, frames * 2);
+	s_queue.push_back(EncodeItem{ -1, std::move(audio), CoreTiming::GetGlobalTimeUs(), s_audio_gap });
+	s_audio_gap = false;
+	s_queue_cond.notify_one();
+}
+
 #ifdef USE_FFMPEG
 
-	s_src_frame->data[0] = const_cast<u8*>(buffer);
-	s_src_frame->linesize[0] = w * 3;
+static void WritePacket(AVStream *stream, AVPacket *pkt) {
+	// Write the compressed frame in the media file.
+	if (pkt->pts != (s64)AV_NOPTS_VALUE)
+	{
+		pkt->pts = av_rescale_q(pkt->pts, stream->codec->time_base, stream->time_base);
+	}
+	if (pkt->dts != (s64)AV_NOPTS_VALUE)
+	{
+		pkt->dts = av_rescale_q(pkt->dts, stream->codec->time_base, stream->time_base);
+	}
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(56, 60, 100)
+	if (stream->codec->coded_frame && stream->codec->coded_frame->key_frame)
+		pkt->flags |= AV_PKT_FLAG_KEY;
+#endif
+	pkt->stream_index = stream->index;
+	av_interleaved_write_frame(s_format_context, pkt);
+}
+
+// Converts emulated time to a pts in the time base, relative to the start of the file.
+static s64 FileTimeToPts(u64 timeUs, AVRational time_base) {
+	if (!s_file_has_start) {
+		s_file_start_us = timeUs;
+		s_file_has_start = true;
+	}
+	if (timeUs < s_file_start_us)
+		return 0;
+	AVRational us = { 1, 1000000 };
+	return av_rescale_q((s64)(timeUs - s_file_start_us), us, time_base);
+}
+
+static void EncodeFrame(const CapturedFrame &frame, u64 timeUs) {
+	if (!s_file_open)
+		return;
+
+	s_src_frame->data[0] = const_cast<u8*>(frame.rgb.data());
+	s_src_frame->linesize[0] = frame.w * 3;
 	s_src_frame->format = AV_PIX_FMT_RGB24;
 	s_src_frame->width = s_width;
 	s_src_frame->height = s_height;
 
 	// Convert image from BGR24 to desired pixel format, and scale to initial width and height
-	if ((s_sws_context = sws_getCachedContext(s_sws_context, w, h, AV_PIX_FMT_RGB24, s_width, s_height, s_stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr)))
+	if ((s_sws_context = sws_getCachedContext(s_sws_context, frame.w, frame.h, AV_PIX_FMT_RGB24, s_width, s_height, s_stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr)))
 	{
-		sws_scale(s_sws_context, s_src_frame->data, s_src_frame->linesize, 0, h, s_scaled_frame->data, s_scaled_frame->linesize);
+		sws_scale(s_sws_context, s_src_frame->data, s_src_frame->linesize, 0, frame.h, s_scaled_frame->data, s_scaled_frame->linesize);
 	}
 
 	s_scaled_frame->format = s_stream->codec->pix_fmt;
 	s_scaled_frame->width = s_width;
 	s_scaled_frame->height = s_height;
+	// Dropped frames just leave a gap.  Frames within the same tick would collide, so bump those.
+	s64 pts = FileTimeToPts(timeUs, s_stream->codec->time_base);
+	if (pts <= s_last_video_pts)
+		pts = s_last_video_pts + 1;
+	s_scaled_frame->pts = pts;
+	s_last_video_pts = pts;
 
 	// Encode and write the image.
 	AVPacket pkt;
@@ -208,21 +407,7 @@ void AVIDump::AddFrame()
 	int error = avcodec_encode_video2(s_stream->codec, &pkt, s_scaled_frame, &got_packet);
 	while (!error && got_packet)
 	{
-		// Write the compressed frame in the media file.
-		if (pkt.pts != (s64)AV_NOPTS_VALUE)
-		{
-			pkt.pts = av_rescale_q(pkt.pts, s_stream->codec->time_base, s_stream->time_base);
-		}
-		if (pkt.dts != (s64)AV_NOPTS_VALUE)
-		{
-			pkt.dts = av_rescale_q(pkt.dts, s_stream->codec->time_base, s_stream->time_base);
-		}
-#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(56, 60, 100)
-		if (s_stream->codec->coded_frame->key_frame)
-			pkt.flags |= AV_PKT_FLAG_KEY;
-#endif
-		pkt.stream_index = s_stream->index;
-		av_interleaved_write_frame(s_format_context, &pkt);
+		WritePacket(s_stream, &pkt);
 
 		// Handle delayed frames.
 		PreparePacket(&pkt);
@@ -230,20 +415,93 @@ void AVIDump::AddFrame()
 	}
 	if (error)
 		ERROR_LOG(G3D, "Error while encoding video: %d", error);
+}
+
+static void EncodeAudio(const std::vector<s16> &samples, u64 timeUs, bool gap) {
+	if (!s_file_open)
+		return;
+
+	// Only the first block (and the first after a drop) goes by time, otherwise they're back to back.
+	if (s_next_audio_pts < 0 || gap)
+		s_next_audio_pts = std::max(s_next_audio_pts, FileTimeToPts(timeUs, s_audio_stream->codec->time_base));
+
+	int frames = (int)samples.size() / 2;
+	s_audio_frame->nb_samples = frames;
+	s_audio_frame->format = AV_SAMPLE_FMT_S16;
+	s_audio_frame->channel_layout = AV_CH_LAYOUT_STEREO;
+	s_audio_frame->pts = s_next_audio_pts;
+	s_next_audio_pts += frames;
+	avcodec_fill_audio_frame(s_audio_frame, 2, AV_SAMPLE_FMT_S16, (const uint8_t *)samples.data(), (int)(samples.size() * sizeof(s16)), 1);
+
+	AVPacket pkt;
+	PreparePacket(&pkt);
+	int got_packet;
+	int error = avcodec_encode_audio2(s_audio_stream->codec, &pkt, s_audio_frame, &got_packet);
+	if (!error && got_packet)
+		WritePacket(s_audio_stream, &pkt);
+	if (error)
+		ERROR_LOG(G3D, "Error while encoding audio: %d", error);
+}
+
 #endif
-	delete[] flipbuffer;
+
+void AVIDump::EncoderThread() {
+	setCurrentThreadName("AVIDump");
+
+	std::unique_lock<std::mutex> guard(s_queue_lock);
+	while (true) {
+		s_queue_cond.wait(guard, [] { return !s_queue.empty() || s_encoder_stop; });
+		// When stopping, we still finish what's queued.
+		if (s_queue.empty())
+			break;
+
+		EncodeItem item = std::move(s_queue.front());
+		s_queue.pop_front();
+		guard.unlock();
+
+#ifdef USE_FFMPEG
+		if (item.frame >= 0) {
+			CheckResolution(s_frames[item.frame].w, s_frames[item.frame].h);
+			EncodeFrame(s_frames[item.frame], item.timeUs);
+		} else
+			EncodeAudio(item.audio, item.timeUs, item.audioGap);
+#endif
+
+		guard.lock();
+		if (item.frame >= 0)
+			s_free_frames.push_back(item.frame);
+		else {
+			s_free_audio.push_back(std::move(item.audio));
+			s_audio_queued--;
+		}
+	}
 }
 
 void AVIDump::Stop() {
-#ifdef USE_FFMPEG
+	if (s_encoder_running) {
+		{
+			std::lock_guard<std::mutex> guard(s_queue_lock);
+			s_encoder_stop = true;
+			s_queue_cond.notify_one();
+		}
+		s_encoder_thread.join();
+		s_encoder_running = false;
+		NOTICE_LOG(G3D, "Captured %d frames, dropped %d (and %d audio blocks)", s_frames_captured, s_frames_dropped, s_audio_dropped);
+	}
 
-	av_write_trailer(s_format_context);
-	CloseFile();
+	FinishFile();
 	s_file_index = 0;
-#endif
 	NOTICE_LOG(G3D, "Stopping frame dump");
 }
 
+void AVIDump::FinishFile() {
+#ifdef USE_FFMPEG
+	if (s_file_open)
+		av_write_trailer(s_format_context);
+	CloseFile();
+#endif
+}
+
 void AVIDump::CloseFile() {
 #ifdef USE_FFMPEG
 
@@ -259,8 +517,17 @@ void AVIDump::CloseFile() {
 		av_freep(&s_stream);
 	}
 
+	if (s_audio_stream)
+	{
+		if (s_audio_stream->codec)
+			avcodec_close(s_audio_stream->codec);
+		av_freep(&s_audio_stream);
+	}
+
 	av_frame_free(&s_src_frame);
 	av_frame_free(&s_scaled_frame);
+	av_frame_free(&s_audio_frame);
+	s_file_open = false;
 
 	if (s_format_context)
 	{
@@ -283,12 +550,15 @@ void AVIDump::CheckResolution(int width, int height) {
 	// was dumped, then create a new file accordingly. However, is it possible for the width and height
 	// to have a value of zero. If this is the case, simply keep the last known resolution of the video
 	// for the added frame.
+	// This runs on the encoder thread, so it only swaps the file.
 	if ((width != s_current_width || height != s_current_height) && (width > 0 && height > 0))
 	{
-		int temp_file_index = s_file_index;
-		Stop();
-		s_file_index = temp_file_index + 1;
-		Start(width, height);
+		FinishFile();
+		s_file_index++;
+		s_width = width;
+		s_height = height;
+		if (!CreateAVI())
+			CloseFile();
 		s_current_width = width;
 		s_current_height = height;
 	}
@@ -11,12 +11,17 @@ class AVIDump
 {
 private:
 	static bool CreateAVI();
+	static void FinishFile();
 	static void CloseFile();
 	static void CheckResolution(int width, int height);
+	static void EncoderThread();
 
 public:
 	static bool Start(int w, int h);
+	// Captures the frame, which is then encoded on a separate thread.
 	static void AddFrame();
+	// The mixed 44100hz stereo audio, to go in the same file.
+	static void AddAudio(const s32 *samples, int frames);
 	static void Stop();
 };
 #endif
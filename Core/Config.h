@@ -108,6 +108,8 @@ struct Config {
 	bool bHideStateWarnings;
 	bool bPreloadFunctions;
 	uint32_t uJitDisableFlags;
+	// Native jit only: blocks run this many times in the IR interpreter before being compiled. 0 = off.
+	int iJitTierThreshold;
 
 	bool bSeparateSASThread;
 	bool bSeparateIOThread;
@@ -182,6 +184,7 @@ struct Config {
 	bool bVertexCache;
 	bool bTextureBackoffCache;
 	bool bTextureSecondaryCache;
+	bool bTextureDirtyPageTracking;  // Skip rehashing textures in memory that HLE/DMA hasn't written to.
 	bool bVertexDecoderJit;
 	bool bFullScreen;
 	bool bFullScreenMulti;
@@ -212,6 +215,7 @@ struct Config {
 	bool bBlockTransferGPU;
 	bool bDisableSlowFramebufEffects;
 	bool bFragmentTestCache;
+	bool bSkipDrawsWithPendingShaders;  // Vulkan: drop draws whose shaders are still compiling instead of waiting.
 	int iSplineBezierQuality; // 0 = low , 1 = Intermediate , 2 = High
 	bool bHardwareTessellation;
 
@@ -230,6 +234,7 @@ struct Config {
 	int iGlobalVolume;
 	int iAltSpeedVolume;
 	bool bExtraAudioBuffering;  // For bluetooth
+	bool bHighQualityResampler;
 	std::string sAudioDevice;
 	bool bAutoAudioDevice;
 
@@ -517,7 +517,10 @@ void ProcessFifoWaitEvents()
 //				first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
 			Event* evt = first;
 			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
+			{
+				TRACE_THIS_SCOPE(event_types[evt->type].name, "coretiming");
+				event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
+			}
 			FreeEvent(evt);
 		}
 		else
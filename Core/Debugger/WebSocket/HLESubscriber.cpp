@@ -25,7 +25,9 @@
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSStackWalk.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HLE/sceKernelThread.h"
+#include "Core/System.h"
 
 DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
 	map["hle.thread.list"] = &WebSocketHLEThreadList;
@@ -36,6 +38,7 @@ DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
 	map["hle.func.remove"] = &WebSocketHLEFuncRemove;
 	map["hle.func.rename"] = &WebSocketHLEFuncRename;
 	map["hle.module.list"] = &WebSocketHLEModuleList;
+	map["hle.syscall.profile"] = &WebSocketHLESyscallProfile;
 	map["hle.backtrace"] = &WebSocketHLEBacktrace;
 
 	return nullptr;
@@ -427,6 +430,55 @@ void WebSocketHLEModuleList(DebuggerRequest &req) {
 	json.pop();
 }
 
+// Report time spent in each HLE syscall (hle.syscall.profile)
+//
+// Parameters:
+//  - reset: optional boolean, clear the counters after reporting them.
+//
+// Response (same event name):
+//  - bucketSeconds: array of numbers, the lower bound of each histogram bucket in seconds.
+//  - functions: array of objects, most total time first, each with properties:
+//     - module: name of the HLE module, e.g. 'sceDisplay'.
+//     - name: name of the function.
+//     - calls: number of times the function was called.
+//     - totalSeconds: number of seconds spent inside the function, in total.
+//     - maxSeconds: number of seconds spent in the slowest call.
+//     - histogram: array of call counts per latency bucket.  The last one includes anything slower.
+void WebSocketHLESyscallProfile(DebuggerRequest &req) {
+	if (!PSP_IsInited())
+		return req.Fail("CPU not started");
+
+	bool reset = false;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	auto entries = hleGetSyscallProfile();
+	if (reset)
+		hleResetSyscallProfile();
+
+	JsonWriter &json = req.Respond();
+	json.pushArray("bucketSeconds");
+	for (int i = 0; i < HLE_SYSCALL_PROFILE_BUCKETS; ++i)
+		json.writeFloat(i == 0 ? 0.0 : hleSyscallProfileSeconds(1ULL << i));
+	json.pop();
+
+	json.pushArray("functions");
+	for (const auto &entry : entries) {
+		json.pushDict();
+		json.writeString("module", entry.module);
+		json.writeString("name", entry.name);
+		json.writeFloat("calls", (double)entry.profile.calls);
+		json.writeFloat("totalSeconds", hleSyscallProfileSeconds(entry.profile.ticks));
+		json.writeFloat("maxSeconds", hleSyscallProfileSeconds(entry.profile.maxTicks));
+		json.pushArray("histogram");
+		for (int i = 0; i < HLE_SYSCALL_PROFILE_BUCKETS; ++i)
+			json.writeUint(entry.profile.histogram[i]);
+		json.pop();
+		json.pop();
+	}
+	json.pop();
+}
+
 // Walk the stack and list stack frames (hle.backtrace)
 //
 // Parameters:
@@ -29,4 +29,5 @@ void WebSocketHLEFuncAdd(DebuggerRequest &req);
 void WebSocketHLEFuncRemove(DebuggerRequest &req);
 void WebSocketHLEFuncRename(DebuggerRequest &req);
 void WebSocketHLEModuleList(DebuggerRequest &req);
+void WebSocketHLESyscallProfile(DebuggerRequest &req);
 void WebSocketHLEBacktrace(DebuggerRequest &req);
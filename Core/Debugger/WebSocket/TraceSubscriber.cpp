@@ -0,0 +1,57 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "Common/Data/Encoding/Base64.h"
+#include "Common/Profiler/TraceRecorder.h"
+#include "Core/Debugger/WebSocket/TraceSubscriber.h"
+#include "Core/Debugger/WebSocket/WebSocketUtils.h"
+
+DebuggerSubscriber *WebSocketTraceInit(DebuggerEventHandlerMap &map) {
+	map["trace.start"] = &WebSocketTraceStart;
+	map["trace.stop"] = &WebSocketTraceStop;
+
+	return nullptr;
+}
+
+// Start recording a trace of all threads (trace.start)
+//
+// No parameters.
+//
+// Response (same event name) with no extra data.
+//
+// Note: profiler scopes, CoreTiming events, syscalls, GE lists, and flips are recorded.
+void WebSocketTraceStart(DebuggerRequest &req) {
+	if (!TraceRecorder::Start())
+		return req.Fail("Trace already in progress");
+
+	req.Respond();
+}
+
+// Stop recording and return the trace (trace.stop)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - uri: data: URI containing Chrome trace event JSON, for chrome://tracing or ui.perfetto.dev.
+void WebSocketTraceStop(DebuggerRequest &req) {
+	if (!TraceRecorder::IsRecording())
+		return req.Fail("No trace in progress");
+
+	std::string trace = TraceRecorder::Stop();
+	JsonWriter &json = req.Respond();
+	json.writeString("uri", "data:application/json;base64," + Base64Encode((const uint8_t *)trace.data(), trace.size()));
+}
@@ -19,14 +19,34 @@
 #include <cstring>
 #include <algorithm>
 
+#include "Common/Data/Encoding/Utf8.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
+#include "Common/MemoryUtil.h"
 #include "Common/Swap.h"
+#include "Core/Config.h"
 #include "Core/Loaders.h"
 #include "Core/Host.h"
 #include "Core/FileSystems/BlockDevices.h"
 
+#ifdef HAVE_MAPPED_BLOCK_DEVICE
+#ifdef _WIN32
+#include "Common/CommonWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if PPSSPP_PLATFORM(LINUX)
+#include <sys/vfs.h>
+#elif PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS) || defined(__FreeBSD__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+#endif
+#endif
+
 extern "C"
 {
 #include "zlib.h"
@@ -46,8 +66,16 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 		return new CISOFileBlockDevice(fileLoader);
 	else if (size == 4 && !memcmp(buffer, "\x00PBP", 4))
 		return new NPDRMDemoBlockDevice(fileLoader);
-	else
-		return new FileBlockDevice(fileLoader);
+
+#ifdef HAVE_MAPPED_BLOCK_DEVICE
+	// If the user asked to cache the ISO in RAM, respect that instead.
+	if (!fileLoader->IsRemote() && !g_Config.bCacheFullIsoInRam) {
+		BlockDevice *mapped = MappedFileBlockDevice::Create(fileLoader);
+		if (mapped)
+			return mapped;
+	}
+#endif
+	return new FileBlockDevice(fileLoader);
 }
 
 u32 BlockDevice::CalculateCRC() {
@@ -99,6 +127,197 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+#ifdef HAVE_MAPPED_BLOCK_DEVICE
+
+// Read ahead starts small, and doubles each time a sequential read catches up to it.
+static const u32 MAPPED_READAHEAD_MIN_BLOCKS = 16;
+static const u32 MAPPED_READAHEAD_MAX_BLOCKS = 1024;
+
+static void UnmapFile(const u8 *base, u64 filesize, void *mapping) {
+#ifdef _WIN32
+	UnmapViewOfFile(base);
+	CloseHandle(mapping);
+#else
+	munmap((void *)base, (size_t)filesize);
+#endif
+}
+
+// A read error in a mapping is a SIGBUS or EXCEPTION_IN_PAGE_ERROR, not a short read.
+// So only map files that can't just go away: on fixed local disks, not shares or SD cards.
+#ifdef _WIN32
+static bool IsOnLocalFixedDisk(const std::wstring &filename) {
+	wchar_t volume[MAX_PATH];
+	if (!GetVolumePathNameW(filename.c_str(), volume, MAX_PATH))
+		return false;
+	return GetDriveTypeW(volume) == DRIVE_FIXED;
+}
+#else
+static bool IsOnLocalFixedDisk(int fd) {
+#if PPSSPP_PLATFORM(LINUX)
+	struct statfs fs;
+	if (fstatfs(fd, &fs) != 0)
+		return false;
+	// FAT, exFAT, NTFS, FUSE (including Android's shared storage) and network filesystems are
+	// mostly removable or remote, so only allow the usual filesystems for a system disk.
+	switch ((u32)fs.f_type) {
+	case 0xEF53:      // ext2/3/4
+	case 0x58465342:  // XFS
+	case 0x9123683E:  // Btrfs
+	case 0xF2F52010:  // F2FS
+	case 0x2FC12FC1:  // ZFS
+		return true;
+	default:
+		return false;
+	}
+#elif PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS) || defined(__FreeBSD__)
+	struct statfs fs;
+	if (fstatfs(fd, &fs) != 0 || (fs.f_flags & MNT_LOCAL) == 0)
+		return false;
+	// Local also includes USB sticks and SD cards, which are usually FAT or exFAT.
+	return strcmp(fs.f_fstypename, "msdos") != 0 && strcmp(fs.f_fstypename, "exfat") != 0;
+#else
+	return false;
+#endif
+}
+#endif
+
+MappedFileBlockDevice *MappedFileBlockDevice::Create(FileLoader *fileLoader) {
+	const std::string filename = fileLoader->Path();
+	const u8 *base = nullptr;
+	u64 filesize = 0;
+	void *mapping = nullptr;
+
+#ifdef _WIN32
+	const std::wstring wfilename = ConvertUTF8ToWString(filename);
+	if (!IsOnLocalFixedDisk(wfilename)) {
+		INFO_LOG(LOADER, "Not mapping %s, it's not on a local fixed disk", filename.c_str());
+		return nullptr;
+	}
+	HANDLE file = CreateFile(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) && size.QuadPart >= 2048) {
+		filesize = (u64)size.QuadPart;
+		mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			base = (const u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (!base) {
+				CloseHandle(mapping);
+				mapping = nullptr;
+			}
+		}
+	}
+	// The mapping keeps the file open.
+	CloseHandle(file);
+#else
+	int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return nullptr;
+	if (!IsOnLocalFixedDisk(fd)) {
+		INFO_LOG(LOADER, "Not mapping %s, it's not on a local fixed disk", filename.c_str());
+		close(fd);
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= 2048) {
+		filesize = (u64)st.st_size;
+		void *ptr = mmap(nullptr, (size_t)filesize, PROT_READ, MAP_SHARED, fd, 0);
+		if (ptr != MAP_FAILED)
+			base = (const u8 *)ptr;
+	}
+	// The mapping keeps the file open.
+	close(fd);
+#endif
+
+	if (!base) {
+		WARN_LOG(LOADER, "Unable to map %s, reading it normally", filename.c_str());
+		return nullptr;
+	}
+	if (filesize != (u64)fileLoader->FileSize()) {
+		// Something's odd, maybe it's being written to.  Let the loader deal with it.
+		WARN_LOG(LOADER, "Mapped size of %s doesn't match, reading it normally", filename.c_str());
+		UnmapFile(base, filesize, mapping);
+		return nullptr;
+	}
+
+	INFO_LOG(LOADER, "Mapped %s into memory (%lld bytes)", filename.c_str(), (long long)filesize);
+	return new MappedFileBlockDevice(base, filesize, mapping);
+}
+
+MappedFileBlockDevice::MappedFileBlockDevice(const u8 *base, u64 filesize, void *mapping)
+	: base_(base), filesize_(filesize), mapping_(mapping), nextBlock_(0), readAheadEnd_(0), readAheadBlocks_(MAPPED_READAHEAD_MIN_BLOCKS) {
+}
+
+MappedFileBlockDevice::~MappedFileBlockDevice() {
+	UnmapFile(base_, filesize_, mapping_);
+}
+
+bool MappedFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	if (blockNumber < 0 || (u64)(blockNumber + 1) * 2048 > filesize_) {
+		DEBUG_LOG(FILESYS, "Could not read 2048 bytes from block");
+		return false;
+	}
+
+	// Uncached reads (like the CRC) shouldn't disturb the read ahead.
+	if (!uncached)
+		NotifyRead(blockNumber, 1);
+	memcpy(outPtr, base_ + (u64)blockNumber * 2048, 2048);
+	return true;
+}
+
+bool MappedFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	if (count <= 0)
+		return count == 0;
+
+	// Copy what we can, same as a short read would.
+	const u32 numBlocks = GetNumBlocks();
+	const u32 available = minBlock < numBlocks ? std::min((u32)count, numBlocks - minBlock) : 0;
+	if (available != 0) {
+		NotifyRead(minBlock, available);
+		memcpy(outPtr, base_ + (u64)minBlock * 2048, (size_t)available * 2048);
+	}
+	if (available != (u32)count) {
+		ERROR_LOG(FILESYS, "Could not read %d bytes from block", 2048 * count);
+		return false;
+	}
+	return true;
+}
+
+void MappedFileBlockDevice::NotifyRead(u32 minBlock, u32 count) {
+	const u32 end = minBlock + count;
+	if (nextBlock_.exchange(end) != minBlock) {
+		// A seek.  Start over with a small window, the kernel's own read ahead handles the rest.
+		readAheadBlocks_ = MAPPED_READAHEAD_MIN_BLOCKS;
+		readAheadEnd_ = end;
+		return;
+	}
+
+	// Sequential, likely a file being streamed through sceIo.  Stay ahead of it.
+	u32 window = readAheadBlocks_;
+	if (end + window / 2 < readAheadEnd_)
+		return;
+	window = std::min(window * 2, MAPPED_READAHEAD_MAX_BLOCKS);
+	readAheadBlocks_ = window;
+
+	const u32 from = std::max(end, (u32)readAheadEnd_);
+	const u32 to = std::min(end + window, GetNumBlocks());
+	if (from >= to)
+		return;
+	readAheadEnd_ = to;
+
+#ifndef _WIN32
+	// madvise wants the start aligned to a page, the length doesn't matter.
+	const uintptr_t pageMask = (uintptr_t)GetMemoryProtectPageSize() - 1;
+	const uintptr_t start = (uintptr_t)(base_ + (u64)from * 2048);
+	const uintptr_t alignedStart = start & ~pageMask;
+	madvise((void *)alignedStart, (size_t)(to - from) * 2048 + (start - alignedStart), MADV_WILLNEED);
+#endif
+	// On Windows, the cache manager already reads ahead for sequential page faults.
+}
+
+#endif
+
 // .CSO format
 
 // compressed ISO(9660) header format
@@ -215,6 +434,7 @@ CISOFileBlockDevice::~CISOFileBlockDevice()
 bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 {
 	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	std::lock_guard<std::recursive_mutex> guard(mutex_);
 	if ((u32)blockNumber >= numBlocks) {
 		memset(outPtr, 0, GetBlockSize());
 		return false;
@@ -285,6 +505,7 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 }
 
 bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	std::lock_guard<std::recursive_mutex> guard(mutex_);
 	if (count == 1) {
 		return ReadBlock(minBlock, outPtr);
 	}
@@ -23,8 +23,10 @@
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
 
+#include <atomic>
 #include <mutex>
 
+#include "ppsspp_config.h"
 #include "Common/CommonTypes.h"
 #include "Core/ELF/PBPReader.h"
 
@@ -75,6 +77,8 @@ class CISOFileBlockDevice : public BlockDevice {
 	u32 numBlocks;
 	u32 numFrames;
 	int ver_;
+	// The read and zlib buffers are shared, and ISOFileSystem may read from several threads.
+	std::recursive_mutex mutex_;
 };
 
 
@@ -92,6 +96,38 @@ class FileBlockDevice : public BlockDevice {
 	u64 filesize_;
 };
 
+#if PPSSPP_ARCH(64BIT) && !PPSSPP_PLATFORM(UWP) && !PPSSPP_PLATFORM(SWITCH)
+#define HAVE_MAPPED_BLOCK_DEVICE 1
+#endif
+
+#ifdef HAVE_MAPPED_BLOCK_DEVICE
+// Plain local ISOs, mapped into memory so reads are a single copy straight out of the page cache.
+// Only on 64-bit, where there's plenty of address space for a whole disc image.
+class MappedFileBlockDevice : public BlockDevice {
+public:
+	// Returns nullptr if the file can't be mapped, use FileBlockDevice instead then.
+	static MappedFileBlockDevice *Create(FileLoader *fileLoader);
+	~MappedFileBlockDevice();
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	u32 GetNumBlocks() override { return (u32)(filesize_ / GetBlockSize()); }
+	bool IsDisc() override { return true; }
+
+private:
+	MappedFileBlockDevice(const u8 *base, u64 filesize, void *mapping);
+	void NotifyRead(u32 minBlock, u32 count);
+
+	const u8 *base_;
+	u64 filesize_;
+	// The file mapping handle on Windows, unused elsewhere.
+	void *mapping_;
+
+	// Sequential reads (like streaming a movie) grow a read ahead window.
+	std::atomic<u32> nextBlock_;
+	std::atomic<u32> readAheadEnd_;
+	std::atomic<u32> readAheadBlocks_;
+};
+#endif
 
 // For encrypted ISOs in PBP files.
 
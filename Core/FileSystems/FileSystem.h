@@ -62,6 +62,8 @@ enum class FileSystemFlags {
 	UMD = 2,
 	CARD = 4,
 	FLASH = 8,
+	// ReadFile/WriteFile lock for themselves, and may run alongside other calls.
+	CONCURRENT_IO = 16,
 };
 ENUM_CLASS_BITOPS(FileSystemFlags);
 
@@ -210,7 +210,10 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			root->valid = true;  // Prevents re-reading
 			return;
 		}
-		lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
+		{
+			std::lock_guard<std::mutex> guard(entriesLock_);
+			lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
+		}
 
 		for (int offset = 0; offset < 2048; ) {
 			DirectoryEntry &dir = *(DirectoryEntry *)&theSector[offset];
@@ -366,6 +369,7 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 		if (strncmp(devicename, "umd0:", 5) == 0 || strncmp(devicename, "umd1:", 5) == 0)
 			entry.isBlockSectorMode = true;
 
+		std::lock_guard<std::mutex> guard(entriesLock_);
 		entries[newHandle] = entry;
 		return newHandle;
 	}
@@ -382,11 +386,13 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 	entry.seekPos = 0;
 
 	u32 newHandle = hAlloc->GetNewHandle();
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	entries[newHandle] = entry;
 	return newHandle;
 }
 
 void ISOFileSystem::CloseFile(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		//CloseHandle((*iter).second.hFile);
@@ -399,19 +405,23 @@ void ISOFileSystem::CloseFile(u32 handle) {
 }
 
 bool ISOFileSystem::OwnsHandle(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
 	return (iter != entries.end());
 }
 
 int ISOFileSystem::Ioctl(u32 handle, u32 cmd, u32 indataPtr, u32 inlen, u32 outdataPtr, u32 outlen, int &usec) {
-	EntryMap::iterator iter = entries.find(handle);
-	if (iter == entries.end()) {
-		ERROR_LOG(FILESYS, "Ioctl on a bad file handle");
-		return SCE_KERNEL_ERROR_BADF;
+	OpenFileEntry e;
+	{
+		std::lock_guard<std::mutex> guard(entriesLock_);
+		EntryMap::iterator iter = entries.find(handle);
+		if (iter == entries.end()) {
+			ERROR_LOG(FILESYS, "Ioctl on a bad file handle");
+			return SCE_KERNEL_ERROR_BADF;
+		}
+		e = iter->second;
 	}
 
-	OpenFileEntry &e = iter->second;
-
 	switch (cmd) {
 	// Get ISO9660 volume descriptor (from open ISO9660 file.)
 	case 0x01020001:
@@ -463,6 +473,7 @@ int ISOFileSystem::Ioctl(u32 handle, u32 cmd, u32 indataPtr, u32 inlen, u32 outd
 }
 
 PSPDevType ISOFileSystem::DevType(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
 	PSPDevType type = iter->second.isBlockSectorMode ? PSPDevType::BLOCK : PSPDevType::FILE;
 	if (iter->second.isRawSector)
@@ -473,7 +484,8 @@ PSPDevType ISOFileSystem::DevType(u32 handle) {
 FileSystemFlags ISOFileSystem::Flags() {
 	// TODO: Here may be a good place to force things, in case users recompress games
 	// as PBP or CSO when they were originally the other type.
-	return blockDevice->IsDisc() ? FileSystemFlags::UMD : FileSystemFlags::CARD;
+	FileSystemFlags flags = blockDevice->IsDisc() ? FileSystemFlags::UMD : FileSystemFlags::CARD;
+	return flags | FileSystemFlags::CONCURRENT_IO;
 }
 
 size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
@@ -483,6 +495,8 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 }
 
 size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
+	// Work out what to read and move the seek position under the lock, then read without it.
+	std::unique_lock<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		OpenFileEntry &e = iter->second;
@@ -494,13 +508,16 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 		
 		if (e.isBlockSectorMode) {
 			// Whole sectors! Shortcut to this simple code.
-			blockDevice->ReadBlocks(e.seekPos, (int)size, pointer);
-			if (abs((int)lastReadBlock_ - (int)e.seekPos) > 100) {
+			const u32 startBlock = e.seekPos;
+			if (abs((int)lastReadBlock_ - (int)startBlock) > 100) {
 				// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
 				usec = 100000;
 			}
 			e.seekPos += (int)size;
 			lastReadBlock_ = e.seekPos;
+			guard.unlock();
+
+			blockDevice->ReadBlocks(startBlock, (int)size, pointer);
 			return (int)size;
 		}
 
@@ -546,7 +563,16 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 			ERROR_LOG(FILESYS, "Remaining size should be aligned");
 		}
 
-		const u8 *const start = pointer;
+		const size_t totalBytes = (size_t)(firstBlockSize + middleSize + lastBlockSize);
+		const u32 endSecNum = secNum + (firstBlockSize > 0 ? 1 : 0) + (u32)(middleSize / 2048) + (lastBlockSize > 0 ? 1 : 0);
+		if (abs((int)lastReadBlock_ - (int)endSecNum) > 100) {
+			// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
+			usec = 100000;
+		}
+		lastReadBlock_ = endSecNum;
+		e.seekPos += (unsigned int)totalBytes;
+		guard.unlock();
+
 		if (firstBlockSize > 0) {
 			blockDevice->ReadBlock(secNum++, theSector);
 			memcpy(pointer, theSector + firstBlockOffset, firstBlockSize);
@@ -564,14 +590,7 @@ size_t ISOFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
 			pointer += lastBlockSize;
 		}
 
-		size_t totalBytes = pointer - start;
-		if (abs((int)lastReadBlock_ - (int)secNum) > 100) {
-			// This is an estimate, sometimes it takes 1+ seconds, but it definitely takes time.
-			usec = 100000;
-		}
-		lastReadBlock_ = secNum;
-		e.seekPos += (unsigned int)totalBytes;
-		return (size_t)totalBytes;
+		return totalBytes;
 	} else {
 		//This shouldn't happen...
 		ERROR_LOG(FILESYS, "Hey, what are you doing? Reading non-open files?");
@@ -590,6 +609,7 @@ size_t ISOFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &us
 }
 
 size_t ISOFileSystem::SeekFile(u32 handle, s32 position, FileMove type) {
+	std::lock_guard<std::mutex> guard(entriesLock_);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		OpenFileEntry &e = iter->second;
@@ -716,11 +736,14 @@ void ISOFileSystem::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+	// GetFromPath() may read directories, which takes the lock itself.
+	std::unique_lock<std::mutex> guard(entriesLock_);
 	int n = (int) entries.size();
 	Do(p, n);
 
 	if (p.mode == p.MODE_READ) {
-		entries.clear();
+		guard.unlock();
+		EntryMap loaded;
 		for (int i = 0; i < n; ++i) {
 			u32 fd = 0;
 			OpenFileEntry of;
@@ -742,8 +765,10 @@ void ISOFileSystem::DoState(PointerWrap &p) {
 				of.file = NULL;
 			}
 
-			entries[fd] = of;
+			loaded[fd] = of;
 		}
+		guard.lock();
+		entries = std::move(loaded);
 	} else {
 		for (EntryMap::iterator it = entries.begin(), end = entries.end(); it != end; ++it) {
 			OpenFileEntry &of = it->second;
@@ -19,6 +19,7 @@
 
 #include <map>
 #include <list>
+#include <mutex>
 
 #include "FileSystem.h"
 
@@ -89,6 +90,9 @@ class ISOFileSystem : public IFileSystem {
 	TreeEntry *treeroot;
 	BlockDevice *blockDevice;
 	u32 lastReadBlock_;
+	// Reads happen without the MetaFileSystem lock (see CONCURRENT_IO), so this protects entries and lastReadBlock_.
+	// The tree is only changed under the MetaFileSystem lock, and entries keep their TreeEntry alive.
+	std::mutex entriesLock_;
 
 	TreeEntry entireISO;
 
@@ -283,7 +283,8 @@ void MetaFileSystem::Mount(std::string prefix, IFileSystem *system) {
 }
 
 void MetaFileSystem::Unmount(std::string prefix, IFileSystem *system) {
-	std::lock_guard<std::recursive_mutex> guard(lock);
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	WaitForConcurrentIO(guard);
 	MountPoint x;
 	x.prefix = prefix;
 	x.system = system;
@@ -291,7 +292,8 @@ void MetaFileSystem::Unmount(std::string prefix, IFileSystem *system) {
 }
 
 void MetaFileSystem::Remount(std::string prefix, IFileSystem *newSystem) {
-	std::lock_guard<std::recursive_mutex> guard(lock);
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	WaitForConcurrentIO(guard);
 	IFileSystem *oldSystem = nullptr;
 	for (auto &it : fileSystems) {
 		if (it.prefix == prefix) {
@@ -328,7 +330,8 @@ IFileSystem *MetaFileSystem::GetSystem(const std::string &prefix) {
 
 void MetaFileSystem::Shutdown()
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	WaitForConcurrentIO(guard);
 	current = 6;
 
 	// Ownership is a bit convoluted. Let's just delete everything once.
@@ -557,44 +560,79 @@ void MetaFileSystem::CloseFile(u32 handle)
 		sys->CloseFile(handle);
 }
 
+IFileSystem *MetaFileSystem::BeginConcurrentIO(std::unique_lock<std::recursive_mutex> &guard, u32 handle, bool &concurrent) {
+	IFileSystem *sys = GetHandleOwner(handle);
+	concurrent = sys && (sys->Flags() & FileSystemFlags::CONCURRENT_IO);
+	if (concurrent) {
+		// Let other calls through while this one waits on the host.
+		concurrentIO_++;
+		guard.unlock();
+	}
+	return sys;
+}
+
+void MetaFileSystem::EndConcurrentIO() {
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	if (--concurrentIO_ == 0)
+		concurrentIODone_.notify_all();
+}
+
+void MetaFileSystem::WaitForConcurrentIO(std::unique_lock<std::recursive_mutex> &guard) {
+	// The caller may delete the file system after this, so nothing can still be using it.
+	while (concurrentIO_ != 0)
+		concurrentIODone_.wait(guard);
+}
+
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->ReadFile(handle, pointer, size);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	bool concurrent;
+	IFileSystem *sys = BeginConcurrentIO(guard, handle, concurrent);
+	if (!sys)
 		return 0;
+	size_t result = sys->ReadFile(handle, pointer, size);
+	if (concurrent)
+		EndConcurrentIO();
+	return result;
 }
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->WriteFile(handle, pointer, size);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	bool concurrent;
+	IFileSystem *sys = BeginConcurrentIO(guard, handle, concurrent);
+	if (!sys)
 		return 0;
+	size_t result = sys->WriteFile(handle, pointer, size);
+	if (concurrent)
+		EndConcurrentIO();
+	return result;
 }
 
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->ReadFile(handle, pointer, size, usec);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	bool concurrent;
+	IFileSystem *sys = BeginConcurrentIO(guard, handle, concurrent);
+	if (!sys)
 		return 0;
+	size_t result = sys->ReadFile(handle, pointer, size, usec);
+	if (concurrent)
+		EndConcurrentIO();
+	return result;
 }
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
-	if (sys)
-		return sys->WriteFile(handle, pointer, size, usec);
-	else
+	std::unique_lock<std::recursive_mutex> guard(lock);
+	bool concurrent;
+	IFileSystem *sys = BeginConcurrentIO(guard, handle, concurrent);
+	if (!sys)
 		return 0;
+	size_t result = sys->WriteFile(handle, pointer, size, usec);
+	if (concurrent)
+		EndConcurrentIO();
+	return result;
 }
 
 size_t MetaFileSystem::SeekFile(u32 handle, s32 position, FileMove type)
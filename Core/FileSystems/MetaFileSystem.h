@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -43,6 +44,14 @@ class MetaFileSystem : public IHandleAllocator, public IFileSystem {
 	std::string startingDirectory;
 	std::recursive_mutex lock;  // must be recursive
 
+	// Reads and writes running without the lock, see FileSystemFlags::CONCURRENT_IO.
+	int concurrentIO_ = 0;
+	std::condition_variable_any concurrentIODone_;
+
+	IFileSystem *BeginConcurrentIO(std::unique_lock<std::recursive_mutex> &guard, u32 handle, bool &concurrent);
+	void EndConcurrentIO();
+	void WaitForConcurrentIO(std::unique_lock<std::recursive_mutex> &guard);
+
 public:
 	MetaFileSystem() {
 		// This used to be 6, probably an attempt to replicate PSP handles.
@@ -15,13 +15,17 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdarg>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/TraceRecorder.h"
 
+#include "Common/BitScan.h"
 #include "Common/Log.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/TimeUtil.h"
@@ -92,6 +96,21 @@ struct HLEMipsCallStack {
 	};
 };
 
+struct SyscallProfileRange {
+	const HLEFunction *begin;
+	const HLEFunction *end;
+	HLESyscallProfile *profiles;
+};
+
+// One flat array per module, parallel to moduleDB.
+static std::vector<std::vector<HLESyscallProfile>> syscallProfiles;
+// Sorted by funcTable, since quick syscalls only know their HLEFunction.
+static std::vector<SyscallProfileRange> syscallProfileRanges;
+// Only guards (re)allocation, the counters themselves are updated without it.
+static std::mutex syscallProfileLock;
+static const HLEFunction *lastProfiledFunc = nullptr;
+static HLESyscallProfile *lastProfile = nullptr;
+
 // No need to save state, always flushed at a syscall end.
 static std::vector<HLEMipsCallInfo> enqueuedMipsCalls;
 // Does need to be saved, referenced by the stack and owned.
@@ -115,8 +134,35 @@ void hleDelayResultFinish(u64 userdata, int cycleslate)
 		WARN_LOG(HLE, "Someone else woke up HLE-blocked thread %d?", threadID);
 }
 
+static void InitSyscallProfile() {
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	syscallProfiles.resize(moduleDB.size());
+	syscallProfileRanges.clear();
+	for (size_t i = 0; i < moduleDB.size(); ++i) {
+		const HLEModule &module = moduleDB[i];
+		syscallProfiles[i].assign(module.numFunctions, HLESyscallProfile{});
+		if (module.numFunctions > 0)
+			syscallProfileRanges.push_back({ module.funcTable, module.funcTable + module.numFunctions, syscallProfiles[i].data() });
+	}
+
+	std::sort(syscallProfileRanges.begin(), syscallProfileRanges.end(), [](const SyscallProfileRange &a, const SyscallProfileRange &b) {
+		return (uintptr_t)a.begin < (uintptr_t)b.begin;
+	});
+	lastProfiledFunc = nullptr;
+	lastProfile = nullptr;
+}
+
+static void ShutdownSyscallProfile() {
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	syscallProfiles.clear();
+	syscallProfileRanges.clear();
+	lastProfiledFunc = nullptr;
+	lastProfile = nullptr;
+}
+
 void HLEInit() {
 	RegisterAllModules();
+	InitSyscallProfile();
 	delayedResultEvent = CoreTiming::RegisterEvent("HLEDelayedResult", hleDelayResultFinish);
 	idleOp = GetSyscallOp("FakeSysCalls", NID_IDLE);
 }
@@ -153,6 +199,7 @@ void HLEDoState(PointerWrap &p) {
 void HLEShutdown() {
 	hleAfterSyscall = HLE_AFTER_NOTHING;
 	latestSyscall = nullptr;
+	ShutdownSyscallProfile();
 	moduleDB.clear();
 	enqueuedMipsCalls.clear();
 	for (auto p : mipsCallActions) {
@@ -620,8 +667,75 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 	}
 }
 
+static HLESyscallProfile *FindSyscallProfile(const HLEFunction *info) {
+	// Games tend to call the same function repeatedly, e.g. in a polling loop.
+	if (info == lastProfiledFunc)
+		return lastProfile;
+
+	const uintptr_t key = (uintptr_t)info;
+	auto it = std::upper_bound(syscallProfileRanges.begin(), syscallProfileRanges.end(), key, [](uintptr_t k, const SyscallProfileRange &range) {
+		return k < (uintptr_t)range.begin;
+	});
+	if (it == syscallProfileRanges.begin())
+		return nullptr;
+	--it;
+	if (key >= (uintptr_t)it->end)
+		return nullptr;
+
+	lastProfiledFunc = info;
+	lastProfile = it->profiles + (info - it->begin);
+	return lastProfile;
+}
+
+static inline void RecordSyscallProfile(const HLEFunction *info, u64 ticks) {
+	HLESyscallProfile *profile = FindSyscallProfile(info);
+	if (!profile)
+		return;
+
+	profile->calls++;
+	profile->ticks += ticks;
+	if (ticks > profile->maxTicks)
+		profile->maxTicks = ticks;
+
+	const u32 clamped = ticks > 0xFFFFFFFFULL ? 0xFFFFFFFF : (u32)ticks;
+	const int bucket = 31 - (int)clz32_nonzero(clamped | 1);
+	profile->histogram[std::min(bucket, (int)HLE_SYSCALL_PROFILE_BUCKETS - 1)]++;
+}
+
+std::vector<HLESyscallProfileEntry> hleGetSyscallProfile() {
+	std::vector<HLESyscallProfileEntry> entries;
+
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	for (size_t i = 0; i < syscallProfiles.size(); ++i) {
+		const HLEModule &module = moduleDB[i];
+		for (int j = 0; j < module.numFunctions; ++j) {
+			const HLESyscallProfile &profile = syscallProfiles[i][j];
+			if (profile.calls == 0)
+				continue;
+			entries.push_back({ module.name, module.funcTable[j].name, profile });
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const HLESyscallProfileEntry &a, const HLESyscallProfileEntry &b) {
+		return a.profile.ticks > b.profile.ticks;
+	});
+	return entries;
+}
+
+void hleResetSyscallProfile() {
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	for (auto &profiles : syscallProfiles) {
+		std::fill(profiles.begin(), profiles.end(), HLESyscallProfile{});
+	}
+}
+
+double hleSyscallProfileSeconds(u64 ticks) {
+	return (double)ticks / time_ticks_per_second();
+}
+
 inline void CallSyscallWithFlags(const HLEFunction *info)
 {
+	const u64 startTicks = time_now_ticks();
 	latestSyscall = info;
 	const u32 flags = info->flags;
 
@@ -644,10 +758,15 @@ inline void CallSyscallWithFlags(const HLEFunction *info)
 		hleFinishSyscall(*info);
 	else
 		SetDeadbeefRegs();
+
+	const u64 endTicks = time_now_ticks();
+	RecordSyscallProfile(info, endTicks - startTicks);
+	TraceRecorder::Complete(info->name, "syscall", startTicks, endTicks);
 }
 
 inline void CallSyscallWithoutFlags(const HLEFunction *info)
 {
+	const u64 startTicks = time_now_ticks();
 	latestSyscall = info;
 	info->func();
 
@@ -655,6 +774,10 @@ inline void CallSyscallWithoutFlags(const HLEFunction *info)
 		hleFinishSyscall(*info);
 	else
 		SetDeadbeefRegs();
+
+	const u64 endTicks = time_now_ticks();
+	RecordSyscallProfile(info, endTicks - startTicks);
+	TraceRecorder::Complete(info->name, "syscall", startTicks, endTicks);
 }
 
 const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op)
@@ -689,11 +812,37 @@ void *GetQuickSyscallFunc(MIPSOpcode op) {
 	// TODO: Do this with a flag?
 	if (op == idleOp)
 		return (void *)info->func;
-	if (info->flags != 0)
+	if ((info->flags & ~HLE_JIT_MASK) != 0)
 		return (void *)&CallSyscallWithFlags;
 	return (void *)&CallSyscallWithoutFlags;
 }
 
+const HLEFunction *GetFastSyscallFunc(MIPSOpcode op) {
+	if (coreCollectDebugStats)
+		return nullptr;
+
+	const HLEFunction *info = GetSyscallFuncPointer(op);
+	if (!info || !info->func || info->flags != HLE_JIT_FAST_CALL)
+		return nullptr;
+	DEBUG_LOG(HLE, "Compiling fast syscall to %s", info->name);
+	return info;
+}
+
+u32 CallFastSyscall(const HLEFunction *info) {
+	const u64 startTicks = time_now_ticks();
+	// Logging and hleReSchedule() look at this, so it must be set before the call.
+	latestSyscall = info;
+	info->func();
+	const bool finish = hleAfterSyscall != HLE_AFTER_NOTHING;
+	if (finish)
+		hleFinishSyscall(*info);
+
+	const u64 endTicks = time_now_ticks();
+	RecordSyscallProfile(info, endTicks - startTicks);
+	TraceRecorder::Complete(info->name, "syscall", startTicks, endTicks);
+	return finish ? 1 : 0;
+}
+
 static double hleSteppingTime = 0.0;
 void hleSetSteppingTime(double t)
 {
@@ -717,7 +866,7 @@ void CallSyscall(MIPSOpcode op)
 	if (info->func) {
 		if (op == idleOp)
 			info->func();
-		else if (info->flags != 0)
+		else if ((info->flags & ~HLE_JIT_MASK) != 0)
 			CallSyscallWithFlags(info);
 		else
 			CallSyscallWithoutFlags(info);
@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <cstdarg>
 #include <type_traits>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
@@ -31,7 +32,11 @@ typedef void (* HLEFunc)();
 
 enum {
 	// The low 8 bits are a value, indicating special jit handling.
-	// Currently there are none.
+	HLE_JIT_MASK = 0xFF,
+	// The jit calls the func directly and keeps going in the same block, unless it used
+	// hleReSchedule() or similar.  For hot funcs that only read args and memory and never wait.
+	// These skip the syscall profile and deadbeef filling when jitted.
+	HLE_JIT_FAST_CALL = 1,
 
 	// The remaining 24 bits are flags.
 	// Don't allow the call within an interrupt.  Not yet implemented.
@@ -154,6 +159,37 @@ void HLEReturnFromMipsCall();
 const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op);
 // For jit, takes arg: const HLEFunction *
 void *GetQuickSyscallFunc(MIPSOpcode op);
+// For jit, returns the HLE_JIT_FAST_CALL func to pass to CallFastSyscall(), or nullptr.
+const HLEFunction *GetFastSyscallFunc(MIPSOpcode op);
+// Returns nonzero if the jit must exit the block afterward (reschedule, callbacks, etc.)
+u32 CallFastSyscall(const HLEFunction *info);
+
+// Latency histogram buckets are powers of two in ticks, see time_now_ticks().
+// The last bucket also counts everything slower.
+enum {
+	HLE_SYSCALL_PROFILE_BUCKETS = 24,
+};
+
+// Always collected for every syscall, including quick and fast syscalls from the jit.
+// The only exception is the idle syscall, which the jit calls directly.
+struct HLESyscallProfile {
+	u64 calls;
+	u64 ticks;
+	u64 maxTicks;
+	u32 histogram[HLE_SYSCALL_PROFILE_BUCKETS];
+};
+
+struct HLESyscallProfileEntry {
+	const char *module;
+	const char *name;
+	HLESyscallProfile profile;
+};
+
+// Functions that were called at least once since boot or the last reset, most total time first.
+std::vector<HLESyscallProfileEntry> hleGetSyscallProfile();
+void hleResetSyscallProfile();
+// Converts profile ticks to seconds.
+double hleSyscallProfileSeconds(u64 ticks);
 
 void hleDoLogInternal(LogTypes::LOG_TYPE t, LogTypes::LOG_LEVELS level, u64 res, const char *file, int line, const char *reportTag, char retmask, const char *reason, const char *formatted_reason);
 
@@ -153,6 +153,7 @@ static int Replace_memcpy() {
 	RETURN(destPtr);
 
 	CBreakPoints::ExecMemCheck(srcPtr, false, bytes, currentMIPS->pc);
+	Memory::MarkDirty(destPtr, bytes);
 	CBreakPoints::ExecMemCheck(destPtr, true, bytes, currentMIPS->pc);
 
 	return 10 + bytes / 4;  // approximation
@@ -195,6 +196,7 @@ static int Replace_memcpy_jak() {
 	RETURN(destPtr);
 
 	CBreakPoints::ExecMemCheck(srcPtr, false, bytes, currentMIPS->pc);
+	Memory::MarkDirty(destPtr, bytes);
 	CBreakPoints::ExecMemCheck(destPtr, true, bytes, currentMIPS->pc);
 
 	return 5 + bytes * 8 + 2;  // approximation. This is a slow memcpy - a byte copy loop..
@@ -223,6 +225,7 @@ static int Replace_memcpy16() {
 	RETURN(destPtr);
 
 	CBreakPoints::ExecMemCheck(srcPtr, false, bytes, currentMIPS->pc);
+	Memory::MarkDirty(destPtr, bytes);
 	CBreakPoints::ExecMemCheck(destPtr, true, bytes, currentMIPS->pc);
 
 	return 10 + bytes / 4;  // approximation
@@ -261,6 +264,7 @@ static int Replace_memcpy_swizzled() {
 	RETURN(0);
 
 	CBreakPoints::ExecMemCheck(srcPtr, false, pitch * h, currentMIPS->pc);
+	Memory::MarkDirty(destPtr, pitch * h);
 	CBreakPoints::ExecMemCheck(destPtr, true, pitch * h, currentMIPS->pc);
 
 	return 10 + (pitch * h) / 4;  // approximation
@@ -289,6 +293,7 @@ static int Replace_memmove() {
 	RETURN(destPtr);
 
 	CBreakPoints::ExecMemCheck(srcPtr, false, bytes, currentMIPS->pc);
+	Memory::MarkDirty(destPtr, bytes);
 	CBreakPoints::ExecMemCheck(destPtr, true, bytes, currentMIPS->pc);
 
 	return 10 + bytes / 4;  // approximation
@@ -310,6 +315,7 @@ static int Replace_memset() {
 	}
 	RETURN(destPtr);
 
+	Memory::MarkDirty(destPtr, bytes);
 	CBreakPoints::ExecMemCheck(destPtr, true, bytes, currentMIPS->pc);
 
 	return 10 + bytes / 4;  // approximation
@@ -341,6 +347,7 @@ static int Replace_memset_jak() {
 	currentMIPS->r[MIPS_REG_A3] = -1;
 	RETURN(destPtr);
 
+	Memory::MarkDirty(destPtr, bytes);
 	CBreakPoints::ExecMemCheck(destPtr, true, bytes, currentMIPS->pc);
 
 	return 5 + bytes * 6 + 2;  // approximation (hm, inspecting the disasm this should be 5 + 6 * bytes + 2, but this is what works..)
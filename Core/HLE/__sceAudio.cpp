@@ -22,6 +22,7 @@
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Data/Collections/FixedSizeQueue.h"
+#include "Common/TimeUtil.h"
 
 #ifdef _M_SSE
 #include <emmintrin.h>
@@ -34,6 +35,7 @@
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #ifndef MOBILE_DEVICE
+#include "Core/AVIDump.h"
 #include "Core/WaveFile.h"
 #include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/sceKernelTime.h"
@@ -336,6 +338,7 @@ void __AudioUpdate(bool resetRecording) {
 	// Audio throttle doesn't really work on the PSP since the mixing intervals are so closely tied
 	// to the CPU. Much better to throttle the frame rate on frame display and just throw away audio
 	// if the buffer somehow gets full.
+	double startTime = coreCollectDebugStats ? time_now_d() : 0.0;
 	bool firstChannel = true;
 	std::vector<int16_t> srcBuffer;
 
@@ -426,6 +429,8 @@ void __AudioUpdate(bool resetRecording) {
 	if (g_Config.bEnableSound) {
 		resampler.PushSamples(mixBuffer, hwBlockSize);
 #ifndef MOBILE_DEVICE
+		// Does nothing unless a video is being recorded.
+		AVIDump::AddAudio(mixBuffer, hwBlockSize);
 		if (g_Config.bSaveLoadResetsAVdumping && resetRecording) {
 			__StopLogAudio();
 			std::string discID = g_paramSFO.GetDiscID();
@@ -450,9 +455,7 @@ void __AudioUpdate(bool resetRecording) {
 			}
 		} else {
 			if (g_Config.bDumpAudio) {
-				for (int i = 0; i < hwBlockSize * 2; i++) {
-					clampedMixBuffer[i] = clamp_s16(mixBuffer[i]);
-				}
+				ClampBufferToS16(clampedMixBuffer, mixBuffer, hwBlockSize * 2);
 				g_wave_writer.AddStereoSamples(clampedMixBuffer, hwBlockSize);
 			} else {
 				__StopLogAudio();
@@ -460,6 +463,9 @@ void __AudioUpdate(bool resetRecording) {
 		}
 #endif
 	}
+
+	if (coreCollectDebugStats)
+		kernelStats.msInAudioUpdate += (time_now_d() - startTime) * 1000.0;
 }
 
 // numFrames is number of stereo frames.
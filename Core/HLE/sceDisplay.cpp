@@ -28,6 +28,7 @@
 
 #include "Common/Data/Text/I18n.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/TraceRecorder.h"
 #include "Common/System/System.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -740,6 +741,7 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 }
 
 void __DisplayFlip(int cyclesLate) {
+	TraceRecorder::Instant("flip", "display");
 	flippedThisFrame = true;
 	// We flip only if the framebuffer was dirty. This eliminates flicker when using
 	// non-buffered rendering. The interaction with frame skipping seems to need
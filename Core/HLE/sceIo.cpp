@@ -138,6 +138,8 @@ static std::thread *ioManagerThread;
 // TODO: Is it better to just put all on the thread?
 // Let's try. (was 256)
 const int IO_THREAD_MIN_DATA_SIZE = 0;
+// How many reads and writes on different files can be in flight on the host at once.
+const int IO_THREAD_WORKERS = 4;
 
 #define SCE_STM_FDIR 0x1000
 #define SCE_STM_FREG 0x2000
@@ -657,6 +659,7 @@ void __IoInit() {
 	if (ioManagerThreadEnabled) {
 		Core_ListenLifecycle(&__IoWakeManager);
 		ioManagerThread = new std::thread(&__IoManagerThread);
+		ioManager.StartWorkers(IO_THREAD_WORKERS);
 	}
 
 	__KernelRegisterWaitTypeFuncs(WAITTYPE_ASYNCIO, __IoAsyncBeginCallback, __IoAsyncEndCallback);
@@ -1031,6 +1034,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 			if (f->npdrm) {
 				result = npdrmRead(f, data, size);
 				currentMIPS->InvalidateICache(data_addr, size);
+				Memory::MarkDirty(data_addr, size);
 				return true;
 			}
 
@@ -1057,6 +1061,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 					result = (int) pspFileSystem.ReadFile(f->handle, data, size, us);
 				}
 				currentMIPS->InvalidateICache(data_addr, size);
+				Memory::MarkDirty(data_addr, size);
 				return true;
 			}
 		} else {
@@ -556,6 +556,7 @@ struct KernelStats {
 		summedMsInSyscalls.clear();
 		summedSlowestSyscallTime = 0;
 		summedSlowestSyscallName = 0;
+		msInAudioUpdate = 0;
 	}
 
 	double msInSyscalls;
@@ -564,6 +565,7 @@ struct KernelStats {
 	std::map<KernelStatsSyscall, double> summedMsInSyscalls;
 	double summedSlowestSyscallTime;
 	const char *summedSlowestSyscallName;
+	double msInAudioUpdate;
 };
 
 extern KernelStats kernelStats;
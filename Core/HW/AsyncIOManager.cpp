@@ -22,6 +22,7 @@
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeMap.h"
 #include "Common/Serialize/SerializeSet.h"
+#include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
@@ -49,9 +50,32 @@ void AsyncIOManager::ScheduleOperation(AsyncIOEvent ev) {
 }
 
 void AsyncIOManager::Shutdown() {
+	if (workers_) {
+		// Workers post their results, so let them finish before taking the lock.
+		workers_->WaitUntilIdle();
+		workers_.reset();
+	}
+
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	resultsPending_.clear();
 	results_.clear();
+	inFlight_ = 0;
+}
+
+void AsyncIOManager::StartWorkers(int count) {
+	if (!workers_ && count > 0)
+		workers_.reset(new WorkerPool(count, "IOWorker"));
+}
+
+void AsyncIOManager::SyncThread(bool force) {
+	IOThreadEventQueue::SyncThread(force);
+	if (workers_)
+		workers_->WaitUntilIdle();
+}
+
+bool AsyncIOManager::IsBusy() {
+	// Must hold resultsLock_.
+	return inFlight_ > 0 || HasEvents();
 }
 
 bool AsyncIOManager::HasResult(u32 handle) {
@@ -67,6 +91,7 @@ bool AsyncIOManager::PopResult(u32 handle, AsyncIOResult &result) {
 
 		if (result.invalidateAddr && result.result > 0) {
 			currentMIPS->InvalidateICache(result.invalidateAddr, (int)result.result);
+			Memory::MarkDirty(result.invalidateAddr, (u32)result.result);
 		}
 		return true;
 	} else {
@@ -86,7 +111,7 @@ bool AsyncIOManager::ReadResult(u32 handle, AsyncIOResult &result) {
 bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while (IsBusy() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (PopResult(handle, result)) {
 			return true;
 		}
@@ -100,7 +125,7 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while (IsBusy() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (ReadResult(handle, result)) {
 			return result.finishTicks;
 		}
@@ -114,6 +139,27 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 }
 
 void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
+	if (!workers_ || (ev.type != IO_EVENT_READ && ev.type != IO_EVENT_WRITE)) {
+		RunOperation(ev);
+		return;
+	}
+
+	// Only one operation per file is ever pending, so these can run in any order.
+	// Completion order is still up to CoreTiming, via the notify events in sceIo.
+	{
+		std::lock_guard<std::mutex> guard(resultsLock_);
+		inFlight_++;
+	}
+	workers_->Run([this, ev] {
+		RunOperation(ev);
+
+		std::lock_guard<std::mutex> guard(resultsLock_);
+		inFlight_--;
+		resultsWait_.notify_one();
+	});
+}
+
+void AsyncIOManager::RunOperation(const AsyncIOEvent &ev) {
 	switch (ev.type) {
 	case IO_EVENT_READ:
 		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
@@ -16,9 +16,11 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <map>
+#include <memory>
 #include <set>
 #include <mutex>
 
+#include "Common/Thread/WorkerPool.h"
 #include "Core/ThreadEventQueue.h"
 
 class NoBase {
@@ -88,6 +90,12 @@ class AsyncIOManager : public IOThreadEventQueue {
 	bool WaitResult(u32 handle, AsyncIOResult &result);
 	u64 ResultFinishTicks(u32 handle);
 
+	// Reads and writes are handed off to these, so operations on different files overlap.
+	// Only used with the thread enabled.
+	void StartWorkers(int count);
+	// Like IOThreadEventQueue::SyncThread(), but also waits for operations already on a worker.
+	void SyncThread(bool force = false);
+
 protected:
 	void ProcessEvent(AsyncIOEvent ref) override;
 	bool ShouldExitEventLoop() override {
@@ -101,6 +109,12 @@ class AsyncIOManager : public IOThreadEventQueue {
 	void Write(u32 handle, u8 *buf, size_t bytes);
 
 	void EventResult(u32 handle, AsyncIOResult result);
+	void RunOperation(const AsyncIOEvent &ev);
+	bool IsBusy();
+
+	std::unique_ptr<WorkerPool> workers_;
+	// Operations handed to workers and not yet finished, protected by resultsLock_.
+	int inFlight_ = 0;
 
 	std::mutex resultsLock_;
 	std::condition_variable resultsWait_;
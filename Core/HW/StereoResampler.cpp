@@ -32,6 +32,7 @@
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32.0f
 
+#include <algorithm>
 #include <cstring>
 #include <atomic>
 
@@ -47,17 +48,6 @@
 #include "Core/Util/AudioFormat.h"  // for clamp_u8
 #include "Core/System.h"
 
-#ifdef _M_SSE
-#include <emmintrin.h>
-#endif
-#if PPSSPP_ARCH(ARM_NEON)
-#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
-#include <arm64_neon.h>
-#else
-#include <arm_neon.h>
-#endif
-#endif
-
 StereoResampler::StereoResampler()
 		: m_maxBufsize(MAX_BUFSIZE_DEFAULT)
 	  , m_targetBufsize(TARGET_BUFSIZE_DEFAULT) {
@@ -100,46 +90,6 @@ void StereoResampler::UpdateBufferSize() {
 	}
 }
 
-template<bool useShift>
-inline void ClampBufferToS16(s16 *out, const s32 *in, size_t size, s8 volShift) {
-#ifdef _M_SSE
-	// Size will always be 16-byte aligned as the hwBlockSize is.
-	while (size >= 8) {
-		__m128i in1 = _mm_loadu_si128((__m128i *)in);
-		__m128i in2 = _mm_loadu_si128((__m128i *)(in + 4));
-		__m128i packed = _mm_packs_epi32(in1, in2);
-		if (useShift) {
-			packed = _mm_srai_epi16(packed, volShift);
-		}
-		_mm_storeu_si128((__m128i *)out, packed);
-		out += 8;
-		in += 8;
-		size -= 8;
-	}
-#elif PPSSPP_ARCH(ARM_NEON)
-	int16x4_t signedVolShift = vdup_n_s16 (-volShift); // Can only dynamic-shift right, but by a signed integer
-	while (size >= 8) {
-		int32x4_t in1 = vld1q_s32(in);
-		int32x4_t in2 = vld1q_s32(in + 4);
-		int16x4_t packed1 = vqmovn_s32(in1);
-		int16x4_t packed2 = vqmovn_s32(in2);
-		if (useShift) {
-			packed1 = vshl_s16(packed1, signedVolShift);
-			packed2 = vshl_s16(packed2, signedVolShift);
-		}
-		vst1_s16(out, packed1);
-		vst1_s16(out + 4, packed2);
-		out += 8;
-		in += 8;
-		size -= 8;
-	}
-#endif
-	// This does the remainder if SIMD was used, otherwise it does it all.
-	for (size_t i = 0; i < size; i++) {
-		out[i] = clamp_s16(useShift ? (in[i] >> volShift) : in[i]);
-	}
-}
-
 inline void ClampBufferToS16WithVolume(s16 *out, const s32 *in, size_t size) {
 	int volume = g_Config.iGlobalVolume;
 	if (PSP_CoreParameter().fpsLimit != FPSLimit::NORMAL || PSP_CoreParameter().unthrottle) {
@@ -149,11 +99,11 @@ inline void ClampBufferToS16WithVolume(s16 *out, const s32 *in, size_t size) {
 	}
 
 	if (volume >= VOLUME_MAX) {
-		ClampBufferToS16<false>(out, in, size, 0);
+		ClampBufferToS16(out, in, size, 0);
 	} else if (volume <= VOLUME_OFF) {
 		memset(out, 0, size * sizeof(s16));
 	} else {
-		ClampBufferToS16<true>(out, in, size, VOLUME_MAX - (s8)volume);
+		ClampBufferToS16(out, in, size, VOLUME_MAX - (s8)volume);
 	}
 }
 
@@ -206,30 +156,38 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 	output_sample_rate_ = (float)(m_input_sample_rate + offset);
 	const u32 ratio = (u32)(65536.0 * output_sample_rate_ / (double)sample_rate);
 	ratio_ = ratio;
-	// TODO: consider a higher-quality resampling algorithm.
 	// TODO: Add a fast path for 1:1.
+	const bool highQuality = g_Config.bHighQualityResampler;
+	// The polyphase filter also reads frames before and after the current one.
+	const u32 before = highQuality ? RESAMPLE_FIR_TAPS / 2 - 1 : 0;
+	const u32 after = highQuality ? RESAMPLE_FIR_TAPS / 2 : 1;
+
+	// Copy out what we'll need, so the kernels don't need to care about wrapping.
+	u32 available = ((indexW - indexR) & INDEX_MASK) / 2;
+	u32 needed = (u32)(((u64)numSamples * ratio + m_frac) >> 16) + after + 1;
+	u32 frames = before + std::min(available, needed);
+	// Never copy more than the ring holds, minus the history PushSamples keeps clear.
+	frames = std::min(frames, (u32)m_maxBufsize - before);
+	if (staging_.size() < frames * 2)
+		staging_.resize(frames * 2);
+	u32 start = (indexR - before * 2) & INDEX_MASK;
+	u32 firstPart = std::min(frames * 2, (u32)INDEX_MASK + 1 - start);
+	memcpy(staging_.data(), &m_buffer[start], firstPart * sizeof(s16));
+	memcpy(staging_.data() + firstPart, &m_buffer[0], (frames * 2 - firstPart) * sizeof(s16));
+
+	size_t pos = 0;
 	u32 frac = m_frac;
-	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
-		if (((indexW - indexR) & INDEX_MASK) <= 2) {
-			// Ran out!
-			// int missing = numSamples * 2 - currentSample;
-			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
-			underrunCount_++;
-			break;
-		}
-		u32 indexR2 = indexR + 2; //next sample
-		s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-		s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-		s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
-		s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
-		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)frac) >> 16;
-		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)frac) >> 16;
-		samples[currentSample] = sampleL;
-		samples[currentSample + 1] = sampleR;
-		frac += ratio;
-		indexR += 2 * (frac >> 16);
-		frac &= 0xffff;
+	const s16 *in = staging_.data() + before * 2;
+	if (highQuality) {
+		currentSample = 2 * (u32)ResamplePolyphaseStereo(samples, numSamples, in, frames - before, &pos, &frac, ratio);
+	} else {
+		currentSample = 2 * (u32)ResampleLinearStereo(samples, numSamples, in, frames - before, &pos, &frac, ratio);
+	}
+	if (currentSample < numSamples * 2) {
+		// Ran out!
+		underrunCount_++;
 	}
+	indexR += (u32)pos * 2;
 	m_frac = frac;
 
 	// Let's not count the underrun padding here.
@@ -262,7 +220,8 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 	// needs to get updates to not deadlock.
 	u32 indexW = m_indexW.load();
 
-	u32 cap = m_maxBufsize * 2;
+	// Keep the frames before indexR intact, Mix reads them as polyphase history.
+	u32 cap = m_maxBufsize * 2 - RESAMPLE_FIR_TAPS;
 	// If unthrottling, no need to fill up the entire buffer, just screws up timing after releasing unthrottle.
 	if (PSP_CoreParameter().unthrottle) {
 		cap = m_targetBufsize * 2;
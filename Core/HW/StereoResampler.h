@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <atomic>
+#include <vector>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/CommonTypes.h"
@@ -54,6 +55,8 @@ class StereoResampler {
 
 	unsigned int m_input_sample_rate = 44100;
 	int16_t *m_buffer;
+	// Contiguous copy of what Mix() reads from m_buffer.
+	std::vector<int16_t> staging_;
 	std::atomic<u32> m_indexW;
 	std::atomic<u32> m_indexR;
 	float m_numLeftI = 0.0f;
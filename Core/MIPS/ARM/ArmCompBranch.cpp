@@ -539,8 +539,17 @@ void ArmJit::Comp_JumpReg(MIPSOpcode op)
 		MovToPC(gpr.R(rs));  // For syscall to be able to return.
 		if (andLink)
 			gpr.SetImm(rd, GetCompilerPC() + 8);
+		js.jumpRegSyscall = true;
 		CompileDelaySlot(DELAYSLOT_FLUSH);
-		return;  // Syscall wrote exit code.
+		js.jumpRegSyscall = false;
+
+		// Syscall wrote exit code, unless it was fast and didn't need to.
+		if (js.compiling) {
+			MovFromPC(SCRATCHREG1);
+			WriteExitDestInR(SCRATCHREG1);
+			js.compiling = false;
+		}
+		return;
 	} else if (delaySlotIsNice) {
 		if (andLink)
 			gpr.SetImm(rd, GetCompilerPC() + 8);
@@ -637,6 +646,25 @@ void ArmJit::Comp_Syscall(MIPSOpcode op)
 	gpr.SetRegImm(R0, op.encoding);
 	QuickCallFunction(R1, (void *)&CallSyscall);
 #else
+	// Some hot syscalls can be called directly, and we keep going if they didn't reschedule.
+	const HLEFunction *fastFunc = nullptr;
+	if ((!js.inDelaySlot || js.jumpRegSyscall) && !jo.Disabled(JitDisable::FAST_SYSCALL))
+		fastFunc = GetFastSyscallFunc(op);
+	if (fastFunc)
+	{
+		MOVP2R(R0, fastFunc);
+		QuickCallFunction(R1, (void *)&CallFastSyscall);
+		CMP(R0, 0);
+		FixupBranch skipExit = B_CC(CC_EQ);
+		ApplyRoundingMode();
+		RestoreDowncount();
+		WriteSyscallExit();
+		SetJumpTarget(skipExit);
+		ApplyRoundingMode();
+		RestoreDowncount();
+		return;
+	}
+
 	// Skip the CallSyscall where possible.
 	void *quickFunc = GetQuickSyscallFunc(op);
 	if (quickFunc)
@@ -267,7 +267,9 @@ void Arm64Jit::GenerateFixedCode(const JitOptions &jo) {
 			ApplyRoundingMode(true);
 			LoadStaticRegisters();
 
-			B(dispatcherNoCheck); // no point in special casing this
+			// Usually we'll now enter the new block, but when tiered JitAt may have run cold code instead.
+			CMP(DOWNCOUNTREG, 0);
+			B(dispatcherCheckCoreState);
 
 		SetJumpTarget(bail);
 		SetJumpTarget(bailCoreState);
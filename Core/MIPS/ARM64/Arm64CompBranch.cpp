@@ -554,8 +554,17 @@ void Arm64Jit::Comp_JumpReg(MIPSOpcode op)
 		MovToPC(gpr.R(rs));  // For syscall to be able to return.
 		if (andLink)
 			gpr.SetImm(rd, GetCompilerPC() + 8);
+		js.jumpRegSyscall = true;
 		CompileDelaySlot(DELAYSLOT_FLUSH);
-		return;  // Syscall (delay slot) wrote exit code.
+		js.jumpRegSyscall = false;
+
+		// Syscall (delay slot) wrote exit code, unless it was fast and didn't need to.
+		if (js.compiling) {
+			MovFromPC(SCRATCH1);
+			WriteExitDestInR(SCRATCH1);
+			js.compiling = false;
+		}
+		return;
 	} else if (delaySlotIsNice) {
 		if (andLink)
 			gpr.SetImm(rd, GetCompilerPC() + 8);
@@ -653,6 +662,22 @@ void Arm64Jit::Comp_Syscall(MIPSOpcode op)
 	MOVI2R(W0, op.encoding);
 	QuickCallFunction(X1, (void *)&CallSyscall);
 #else
+	// Some hot syscalls can be called directly, and we keep going if they didn't reschedule.
+	const HLEFunction *fastFunc = nullptr;
+	if ((!js.inDelaySlot || js.jumpRegSyscall) && !jo.Disabled(JitDisable::FAST_SYSCALL))
+		fastFunc = GetFastSyscallFunc(op);
+	if (fastFunc) {
+		MOVP2R(X0, fastFunc);
+		QuickCallFunction(X1, (void *)&CallFastSyscall);
+		LoadStaticRegisters();
+		FixupBranch skipExit = CBZ(W0);
+		ApplyRoundingMode();
+		WriteSyscallExit();
+		SetJumpTarget(skipExit);
+		ApplyRoundingMode();
+		return;
+	}
+
 	// Skip the CallSyscall where possible.
 	void *quickFunc = GetQuickSyscallFunc(op);
 	if (quickFunc) {
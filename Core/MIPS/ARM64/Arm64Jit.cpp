@@ -37,6 +37,7 @@
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSInt.h"
 #include "Core/MIPS/MIPSTables.h"
+#include "Core/MIPS/IR/IRTierCache.h"
 #include "Core/HLE/ReplaceTables.h"
 #include "Core/MIPS/ARM64/Arm64RegCache.h"
 #include "Core/MIPS/ARM64/Arm64RegCacheFPU.h"
@@ -113,6 +114,8 @@ Arm64Jit::Arm64Jit(MIPSState *mips) : blocks(mips, this), gpr(mips, &js, &jo), f
 	GenerateFixedCode(jo);
 	js.startDefaultPrefix = mips_->HasDefaultPrefix();
 	js.currentRoundingFunc = convertS0ToSCRATCH1[mips_->fcr31 & 3];
+	if (g_Config.iJitTierThreshold > 0)
+		tier_.reset(new IRTierCache(mips, g_Config.iJitTierThreshold));
 
 	// The debugger sets this so that "go" on a breakpoint will actually... go.
 	// But if they reset, we can end up hitting it by mistake, since it's based on PC and ticks.
@@ -177,10 +180,15 @@ void Arm64Jit::ClearCache() {
 	blocks.Clear();
 	ClearCodeSpace(jitStartOffset);
 	FlushIcacheSection(region + jitStartOffset, region + region_size - jitStartOffset);
+	// Everything starts cold again, so only code that's still hot comes back.
+	if (tier_)
+		tier_->ClearCache();
 }
 
 void Arm64Jit::InvalidateCacheAt(u32 em_address, int length) {
 	blocks.InvalidateICache(em_address, length);
+	if (tier_)
+		tier_->InvalidateCacheAt(em_address, length);
 }
 
 void Arm64Jit::EatInstruction(MIPSOpcode op) {
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "Common/CPUDetect.h"
 #include "Common/ArmCommon.h"
 #include "Common/Arm64Emitter.h"
@@ -179,6 +181,7 @@ class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MI
 	void ClearCache() override;
 	void InvalidateCacheAt(u32 em_address, int length = 4) override;
 	void UpdateFCR31() override;
+	IRTierCache *GetTierCache() override { return tier_.get(); }
 
 	void EatPrefix() override { js.EatPrefix(); }
 
@@ -262,6 +265,8 @@ class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MI
 	
 	MIPSState *mips_;
 
+	std::unique_ptr<IRTierCache> tier_;
+
 	int dontLogBlocks;
 	int logBlocks;
 
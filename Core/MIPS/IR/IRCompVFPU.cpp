@@ -72,6 +72,25 @@ namespace MIPSComp {
 			     regs[3] == regs[2] + 1;
 	}
 
+	// For the Mat4 ops (see IRMatrixFlags), checks that regs[j * 4 + i] == regs[0] + i * iStride + j * jStride.
+	static bool IsMatrixLayout(const u8 regs[16], int n, int iStride, int jStride) {
+		for (int j = 0; j < n; j++) {
+			for (int i = 0; i < n; i++) {
+				if (regs[j * 4 + i] != regs[0] + i * iStride + j * jStride)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	static bool IsVectorLayout(const u8 regs[4], int n, int stride) {
+		for (int i = 1; i < n; i++) {
+			if (regs[i] != regs[0] + i * stride)
+				return false;
+		}
+		return true;
+	}
+
 	// Vector regs can overlap in all sorts of swizzled ways.
 	// This does allow a single overlap in sregs[i].
 	static bool IsOverlapSafeAllowS(int dreg, int di, int sn, u8 sregs[], int tn = 0, u8 tregs[] = NULL) {
@@ -797,6 +816,10 @@ namespace MIPSComp {
 		case 0:  // vmov
 		case 1:  // vabs
 		case 2:  // vneg
+		case 16:  // vrcp
+		case 17:  // vrsq
+		case 18:  // vsin
+		case 19:  // vcos
 			canSIMD = true;
 			break;
 		}
@@ -812,6 +835,18 @@ namespace MIPSComp {
 			case 2:  // vneg
 				ir.Write(IROp::Vec4Neg, dregs[0], sregs[0]);
 				break;
+			case 16:  // vrcp
+				ir.Write(IROp::Vec4Recip, dregs[0], sregs[0]);
+				break;
+			case 17:  // vrsq
+				ir.Write(IROp::Vec4RSqrt, dregs[0], sregs[0]);
+				break;
+			case 18:  // vsin
+				ir.Write(IROp::Vec4Sin, dregs[0], sregs[0]);
+				break;
+			case 19:  // vcos
+				ir.Write(IROp::Vec4Cos, dregs[0], sregs[0]);
+				break;
 			}
 			ApplyPrefixD(dregs, sz);
 			return;
@@ -1282,39 +1317,24 @@ namespace MIPSComp {
 			DISABLE;
 		}
 
-		// dregs are always consecutive, thanks to our transpose trick.
-		// However, not sure this is always worth it.
-		if (sz == M_4x4 && IsConsecutive4(dregs)) {
-			// TODO: The interpreter would like proper matrix ops better. Can generate those, and
-			// expand them like this as needed on "real" architectures.
-			int s0 = IRVTEMP_0;
-			int s1 = IRVTEMP_PFX_T;
-			if (!IsConsecutive4(sregs)) {
-				// METHOD 1: Handles AbC and Abc
-				for (int j = 0; j < 4; j++) {
-					ir.Write(IROp::Vec4Scale, s0, sregs[0], tregs[j * 4]);
-					for (int i = 1; i < 4; i++) {
-						ir.Write(IROp::Vec4Scale, s1, sregs[i], tregs[j * 4 + i]);
-						ir.Write(IROp::Vec4Add, s0, s0, s1);
-					}
-					ir.Write(IROp::Vec4Mov, dregs[j * 4], s0);
-				}
+		// dregs are usually consecutive columns, thanks to our transpose trick.
+		// Then the common layouts are a single op, with the same result as the expansion below.
+		if (IsMatrixLayout(dregs, n, 1, 4)) {
+			u32 flags = n;
+			bool supported = true;
+			if (IsMatrixLayout(sregs, n, 1, 4))
+				flags |= IRMATRIX_S_TRANSPOSED;
+			else if (!IsMatrixLayout(sregs, n, 4, 1))
+				supported = false;
+			if (IsMatrixLayout(tregs, n, 4, 1))
+				flags |= IRMATRIX_T_TRANSPOSED;
+			else if (!IsMatrixLayout(tregs, n, 1, 4))
+				supported = false;
+
+			if (supported) {
+				ir.AddConstant(flags);
+				ir.Write(IROp::Mat4Mul, dregs[0], sregs[0], tregs[0]);
 				return;
-			} else if (IsConsecutive4(tregs)) {
-				// METHOD 2: Handles ABC only. Not efficient on CPUs that don't do fast dots.
-				// Dots only work if tregs are consecutive.
-				// TODO: Skip this and resort to method one and transpose the output?
-				for (int j = 0; j < 4; j++) {
-					for (int i = 0; i < 4; i++) {
-						ir.Write(IROp::Vec4Dot, s0 + i, sregs[i * 4], tregs[j * 4]);
-					}
-					ir.Write(IROp::Vec4Mov, dregs[j * 4], s0);
-				}
-				return;
-			} else {
-				// ABc - s consecutive, t not.
-				// Tekken uses this.
-				// logBlocks = 1;
 			}
 		}
 
@@ -1365,52 +1385,25 @@ namespace MIPSComp {
 		GetVectorRegs(tregs, sz, _VT);
 		GetVectorRegs(dregs, sz, _VD);
 
-		// SIMD-optimized implementations - if sregs[0..3] is non-consecutive, it's transposed.
-		if (msz == M_4x4 && !IsConsecutive4(sregs)) {
-			int s0 = IRVTEMP_0;
-			int s1 = IRVTEMP_PFX_S;
-			// For this algorithm, we don't care if tregs are consecutive or not,
-			// they are accessed one at a time. This handles homogenous transforms correctly, as well.
-			// We take advantage of sregs[0] + 1 being sregs[4] here.
-			ir.Write(IROp::Vec4Scale, s0, sregs[0], tregs[0]);
-			for (int i = 1; i < 4; i++) {
-				if (!homogenous || (i != n - 1)) {
-					ir.Write(IROp::Vec4Scale, s1, sregs[i], tregs[i]);
-					ir.Write(IROp::Vec4Add, s0, s0, s1);
-				} else {
-					ir.Write(IROp::Vec4Add, s0, s0, sregs[i]);
-				}
-			}
-			if (IsConsecutive4(dregs)) {
-				ir.Write(IROp::Vec4Mov, dregs[0], s0);
-			} else {
-				for (int i = 0; i < 4; i++) {
-					ir.Write(IROp::FMov, dregs[i], s0 + i);
-				}
-			}
-			return;
-		} else if (msz == M_4x4 && IsConsecutive4(sregs)) {
-			// Consecutive, which is harder.
-			DISABLE;
-			int s0 = IRVTEMP_0;
-			int s1 = IRVTEMP_PFX_S;
-			// Doesn't make complete sense to me why this works.... (because it doesn't.)
-			ir.Write(IROp::Vec4Scale, s0, sregs[0], tregs[0]);
-			for (int i = 1; i < 4; i++) {
-				if (!homogenous || (i != n - 1)) {
-					ir.Write(IROp::Vec4Scale, s1, sregs[i], tregs[i]);
-					ir.Write(IROp::Vec4Add, s0, s0, s1);
-				} else {
-					ir.Write(IROp::Vec4Add, s0, s0, sregs[i]);
-				}
-			}
-			if (IsConsecutive4(dregs)) {
-				ir.Write(IROp::Vec4Mov, dregs[0], s0);
-			} else {
-				for (int i = 0; i < 4; i++) {
-					ir.Write(IROp::FMov, dregs[i], s0 + i);
-				}
-			}
+		// Usually this can be a single op.  Note that t[n - 1] isn't used when homogenous.
+		u32 flags = n | (homogenous ? IRMATRIX_HOMOGENOUS : 0);
+		bool supported = true;
+		if (IsMatrixLayout(sregs, n, 1, 4))
+			flags |= IRMATRIX_S_TRANSPOSED;
+		else if (!IsMatrixLayout(sregs, n, 4, 1))
+			supported = false;
+		int tn = homogenous ? n - 1 : n;
+		if (!IsVectorLayout(tregs, tn, 1)) {
+			flags |= IRMATRIX_T_TRANSPOSED;
+			supported = supported && IsVectorLayout(tregs, tn, 4);
+		}
+		if (!IsVectorLayout(dregs, n, 1)) {
+			flags |= IRMATRIX_D_TRANSPOSED;
+			supported = supported && IsVectorLayout(dregs, n, 4);
+		}
+		if (supported) {
+			ir.AddConstant(flags);
+			ir.Write(IROp::Mat4Transform, dregs[0], sregs[0], tregs[0]);
 			return;
 		}
 
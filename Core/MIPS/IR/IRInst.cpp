@@ -12,6 +12,7 @@
 //  F = FPR register, single
 //  V = FPR register, Vec4. Reg number always divisible by 4.
 //  2 = FPR register, Vec2 (uncommon)
+//  M = FPR register, matrix of up to 4x4, see IRMatrixFlags.
 //  v = Vec4Init constant, chosen by immediate
 //  s = Shuffle immediate (4 2-bit fields, choosing a xyzw shuffle)
 
@@ -130,6 +131,12 @@ static const IRMeta irMeta[] = {
 	{ IROp::Vec4Dot, "Vec4Dot", "FVV" },
 	{ IROp::Vec4Neg, "Vec4Neg", "VV" },
 	{ IROp::Vec4Abs, "Vec4Abs", "VV" },
+	{ IROp::Vec4Recip, "Vec4Recip", "VV" },
+	{ IROp::Vec4RSqrt, "Vec4RSqrt", "VV" },
+	{ IROp::Vec4Sin, "Vec4Sin", "VV" },
+	{ IROp::Vec4Cos, "Vec4Cos", "VV" },
+	{ IROp::Mat4Mul, "Mat4Mul", "MMM" },
+	{ IROp::Mat4Transform, "Mat4Transform", "FMF" },
 
 		// Pack/Unpack
 	{ IROp::Vec2Unpack16To31, "Vec2Unpack16To31", "2F" },  // Note that the result is shifted down by 1, hence 31
@@ -270,6 +277,13 @@ void DisassembleParam(char *buf, int bufSize, u8 param, char type, u32 constant)
 			snprintf(buf, bufSize, "f%d..f%d", param, param + 3);
 		}
 		break;
+	case 'M':
+		if (param >= 32) {
+			snprintf(buf, bufSize, "m(v%d)", param - 32);
+		} else {
+			snprintf(buf, bufSize, "m(f%d)", param);
+		}
+		break;
 	case '2':
 		if (param >= 32) {
 			snprintf(buf, bufSize, "v%d,v%d", param - 32, param - 32 + 1);
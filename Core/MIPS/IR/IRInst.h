@@ -167,6 +167,14 @@ enum class IROp : u8 {
 	Vec4Dot,
 	Vec4Neg,
 	Vec4Abs,
+	Vec4Recip,
+	Vec4RSqrt,
+	Vec4Sin,
+	Vec4Cos,
+
+	// Whole matrix ops, see IRMatrixFlags for the layouts (in the constant.)
+	Mat4Mul,  // d[4a + b] = sum(S(b, c) * T(a, c)), like vmmul
+	Mat4Transform,  // d[i] = sum(S(i, k) * t[k]), like vtfm/vhtfm
 
 	// vx2i
 	Vec2Unpack16To31,  // Note that the result is shifted down by 1, hence 31
@@ -238,6 +246,17 @@ enum class Vec4Init {
 	Set_0001,
 };
 
+// For Mat4Mul and Mat4Transform.  By default S(i, j) = s[i + 4 * j], so the columns are SIMD friendly,
+// and T(i, j) = t[4 * i + j].  Vectors (transform t and d) are consecutive by default.
+// The sums are always done in order, so they match a series of FMul/FAdd exactly.
+enum IRMatrixFlags {
+	IRMATRIX_SIZE_MASK = 0x07,  // 2-4
+	IRMATRIX_S_TRANSPOSED = 0x10,
+	IRMATRIX_T_TRANSPOSED = 0x20,  // For a vector, stride 4.
+	IRMATRIX_D_TRANSPOSED = 0x40,  // For a vector, stride 4.
+	IRMATRIX_HOMOGENOUS = 0x80,  // Transform only, the last t is 1.0.
+};
+
 // Hm, unused
 inline IRComparison Invert(IRComparison comp) {
 	switch (comp) {
@@ -72,6 +72,168 @@ u32 RunMemCheck(u32 pc, u32 addr) {
 	return coreState != CORE_RUNNING ? 1 : 0;
 }
 
+// See IRMatrixFlags.  Sums are done in order, so the result matches the FMul/FAdd expansion exactly.
+static void Mat4Mul(MIPSState *mips, const IRInst *inst) {
+	const float *s = &mips->f[inst->src1];
+	const float *t = &mips->f[inst->src2];
+	float *d = &mips->f[inst->dest];
+	const int n = inst->constant & IRMATRIX_SIZE_MASK;
+	// T(a, c) = t[a * ta + c * tc]
+	const int ta = (inst->constant & IRMATRIX_T_TRANSPOSED) ? 1 : 4;
+	const int tc = 5 - ta;
+
+#if defined(_M_SSE)
+	if (n == 4) {
+		__m128 cols[4];
+		for (int c = 0; c < 4; c++)
+			cols[c] = _mm_loadu_ps(s + 4 * c);
+		if (inst->constant & IRMATRIX_S_TRANSPOSED)
+			_MM_TRANSPOSE4_PS(cols[0], cols[1], cols[2], cols[3]);
+
+		// Compute everything first, d may be the same matrix as s or t.
+		__m128 result[4];
+		for (int a = 0; a < 4; a++) {
+			__m128 sum = _mm_mul_ps(cols[0], _mm_set1_ps(t[a * ta]));
+			for (int c = 1; c < 4; c++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(cols[c], _mm_set1_ps(t[a * ta + c * tc])));
+			result[a] = sum;
+		}
+		for (int a = 0; a < 4; a++)
+			_mm_storeu_ps(d + 4 * a, result[a]);
+		return;
+	}
+#elif PPSSPP_ARCH(ARM64)
+	if (n == 4) {
+		float32x4_t cols[4];
+		if (inst->constant & IRMATRIX_S_TRANSPOSED) {
+			// This deinterleaves, which is exactly the transpose.
+			float32x4x4_t rows = vld4q_f32(s);
+			for (int c = 0; c < 4; c++)
+				cols[c] = rows.val[c];
+		} else {
+			for (int c = 0; c < 4; c++)
+				cols[c] = vld1q_f32(s + 4 * c);
+		}
+
+		float32x4_t result[4];
+		for (int a = 0; a < 4; a++) {
+			float32x4_t sum = vmulq_n_f32(cols[0], t[a * ta]);
+			for (int c = 1; c < 4; c++) {
+				// Separately, not fused, to match the FMul/FAdd rounding.
+				float32x4_t prod = vmulq_n_f32(cols[c], t[a * ta + c * tc]);
+				sum = vaddq_f32(sum, prod);
+			}
+			result[a] = sum;
+		}
+		for (int a = 0; a < 4; a++)
+			vst1q_f32(d + 4 * a, result[a]);
+		return;
+	}
+#endif
+
+	// S(b, c) = s[b * sb + c * sc]
+	const int sb = (inst->constant & IRMATRIX_S_TRANSPOSED) ? 4 : 1;
+	const int sc = 5 - sb;
+	float result[16];
+	for (int a = 0; a < n; a++) {
+		for (int b = 0; b < n; b++) {
+			float sum = s[b * sb] * t[a * ta];
+			for (int c = 1; c < n; c++) {
+				float prod = s[b * sb + c * sc] * t[a * ta + c * tc];
+				sum += prod;
+			}
+			result[a * 4 + b] = sum;
+		}
+	}
+	for (int a = 0; a < n; a++) {
+		for (int b = 0; b < n; b++)
+			d[a * 4 + b] = result[a * 4 + b];
+	}
+}
+
+static void Mat4Transform(MIPSState *mips, const IRInst *inst) {
+	const float *s = &mips->f[inst->src1];
+	const float *t = &mips->f[inst->src2];
+	float *d = &mips->f[inst->dest];
+	const int n = inst->constant & IRMATRIX_SIZE_MASK;
+	const bool homogenous = (inst->constant & IRMATRIX_HOMOGENOUS) != 0;
+	const int tk = (inst->constant & IRMATRIX_T_TRANSPOSED) ? 4 : 1;
+	const int di = (inst->constant & IRMATRIX_D_TRANSPOSED) ? 4 : 1;
+
+	alignas(16) float result[4];
+#if defined(_M_SSE)
+	if (n == 4) {
+		__m128 cols[4];
+		for (int k = 0; k < 4; k++)
+			cols[k] = _mm_loadu_ps(s + 4 * k);
+		if (inst->constant & IRMATRIX_S_TRANSPOSED)
+			_MM_TRANSPOSE4_PS(cols[0], cols[1], cols[2], cols[3]);
+
+		__m128 sum = _mm_mul_ps(cols[0], _mm_set1_ps(t[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(cols[1], _mm_set1_ps(t[tk])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(cols[2], _mm_set1_ps(t[2 * tk])));
+		// Not multiplying by 1.0 for homogenous, just in case of NaNs.
+		sum = _mm_add_ps(sum, homogenous ? cols[3] : _mm_mul_ps(cols[3], _mm_set1_ps(t[3 * tk])));
+		if (di == 1) {
+			_mm_storeu_ps(d, sum);
+			return;
+		}
+		_mm_store_ps(result, sum);
+		for (int i = 0; i < 4; i++)
+			d[i * di] = result[i];
+		return;
+	}
+#elif PPSSPP_ARCH(ARM64)
+	if (n == 4) {
+		float32x4_t cols[4];
+		if (inst->constant & IRMATRIX_S_TRANSPOSED) {
+			float32x4x4_t rows = vld4q_f32(s);
+			for (int k = 0; k < 4; k++)
+				cols[k] = rows.val[k];
+		} else {
+			for (int k = 0; k < 4; k++)
+				cols[k] = vld1q_f32(s + 4 * k);
+		}
+
+		float32x4_t sum = vmulq_n_f32(cols[0], t[0]);
+		for (int k = 1; k < 4; k++) {
+			if (homogenous && k == 3) {
+				sum = vaddq_f32(sum, cols[k]);
+			} else {
+				float32x4_t prod = vmulq_n_f32(cols[k], t[k * tk]);
+				sum = vaddq_f32(sum, prod);
+			}
+		}
+		if (di == 1) {
+			vst1q_f32(d, sum);
+			return;
+		}
+		vst1q_f32(result, sum);
+		for (int i = 0; i < 4; i++)
+			d[i * di] = result[i];
+		return;
+	}
+#endif
+
+	// S(i, k) = s[i * si + k * sk]
+	const int si = (inst->constant & IRMATRIX_S_TRANSPOSED) ? 4 : 1;
+	const int sk = 5 - si;
+	for (int i = 0; i < n; i++) {
+		float sum = s[i * si] * t[0];
+		for (int k = 1; k < n; k++) {
+			if (homogenous && k == n - 1) {
+				sum += s[i * si + k * sk];
+			} else {
+				float prod = s[i * si + k * sk] * t[k * tk];
+				sum += prod;
+			}
+		}
+		result[i] = sum;
+	}
+	for (int i = 0; i < n; i++)
+		d[i * di] = result[i];
+}
+
 // We cannot use NEON on ARM32 here until we make it a hard dependency. We can, however, on ARM64.
 u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 	const IRInst *end = inst + count;
@@ -302,6 +464,8 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_div_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2])));
+#elif PPSSPP_ARCH(ARM64)
+			vst1q_f32(&mips->f[inst->dest], vdivq_f32(vld1q_f32(&mips->f[inst->src1]), vld1q_f32(&mips->f[inst->src2])));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = mips->f[inst->src1 + i] / mips->f[inst->src2 + i];
@@ -313,6 +477,8 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		{
 #if defined(_M_SSE)
 			_mm_store_ps(&mips->f[inst->dest], _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_set1_ps(mips->f[inst->src2])));
+#elif PPSSPP_ARCH(ARM64)
+			vst1q_f32(&mips->f[inst->dest], vmulq_n_f32(vld1q_f32(&mips->f[inst->src1]), mips->f[inst->src2]));
 #else
 			for (int i = 0; i < 4; i++)
 				mips->f[inst->dest + i] = mips->f[inst->src1 + i] * mips->f[inst->src2];
@@ -346,6 +512,52 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 			break;
 		}
 
+		case IROp::Vec4Recip:
+		{
+			// Division is exactly rounded, so this matches FRecip.
+#if defined(_M_SSE)
+			_mm_store_ps(&mips->f[inst->dest], _mm_div_ps(_mm_set1_ps(1.0f), _mm_load_ps(&mips->f[inst->src1])));
+#elif PPSSPP_ARCH(ARM64)
+			vst1q_f32(&mips->f[inst->dest], vdivq_f32(vdupq_n_f32(1.0f), vld1q_f32(&mips->f[inst->src1])));
+#else
+			for (int i = 0; i < 4; i++)
+				mips->f[inst->dest + i] = 1.0f / mips->f[inst->src1 + i];
+#endif
+			break;
+		}
+
+		case IROp::Vec4RSqrt:
+		{
+			// Not using rsqrtps, it's only an estimate.
+#if defined(_M_SSE)
+			_mm_store_ps(&mips->f[inst->dest], _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_load_ps(&mips->f[inst->src1]))));
+#elif PPSSPP_ARCH(ARM64)
+			vst1q_f32(&mips->f[inst->dest], vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(vld1q_f32(&mips->f[inst->src1]))));
+#else
+			for (int i = 0; i < 4; i++)
+				mips->f[inst->dest + i] = 1.0f / sqrtf(mips->f[inst->src1 + i]);
+#endif
+			break;
+		}
+
+		case IROp::Vec4Sin:
+			for (int i = 0; i < 4; i++)
+				mips->f[inst->dest + i] = vfpu_sin(mips->f[inst->src1 + i]);
+			break;
+
+		case IROp::Vec4Cos:
+			for (int i = 0; i < 4; i++)
+				mips->f[inst->dest + i] = vfpu_cos(mips->f[inst->src1 + i]);
+			break;
+
+		case IROp::Mat4Mul:
+			Mat4Mul(mips, inst);
+			break;
+
+		case IROp::Mat4Transform:
+			Mat4Transform(mips, inst);
+			break;
+
 		case IROp::Vec2Unpack16To31:
 		{
 			mips->fi[inst->dest] = (mips->fi[inst->src1] << 16) >> 1;
@@ -505,10 +717,25 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 		// Not quickly implementable on all platforms, unfortunately.
 		case IROp::Vec4Dot:
 		{
+			// The adds must stay in order to match the FMul/FAdd version, only the multiply is wide.
+#if defined(_M_SSE)
+			__m128 prod = _mm_mul_ps(_mm_load_ps(&mips->f[inst->src1]), _mm_load_ps(&mips->f[inst->src2]));
+			__m128 dot = _mm_add_ss(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(1, 1, 1, 1)));
+			dot = _mm_add_ss(dot, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(2, 2, 2, 2)));
+			dot = _mm_add_ss(dot, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(3, 3, 3, 3)));
+			_mm_store_ss(&mips->f[inst->dest], dot);
+#elif PPSSPP_ARCH(ARM64)
+			float32x4_t prod = vmulq_f32(vld1q_f32(&mips->f[inst->src1]), vld1q_f32(&mips->f[inst->src2]));
+			float dot = vgetq_lane_f32(prod, 0) + vgetq_lane_f32(prod, 1);
+			dot += vgetq_lane_f32(prod, 2);
+			dot += vgetq_lane_f32(prod, 3);
+			mips->f[inst->dest] = dot;
+#else
 			float dot = mips->f[inst->src1] * mips->f[inst->src2];
 			for (int i = 1; i < 4; i++)
 				dot += mips->f[inst->src1 + i] * mips->f[inst->src2 + i];
 			mips->f[inst->dest] = dot;
+#endif
 			break;
 		}
 
@@ -233,7 +233,8 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 				}
 			} else {
 				// RestoreRoundingMode(true);
-				Compile(mips_->pc);
+				// Through JitAt, so the compile is counted in the stats.
+				JitAt();
 				// ApplyRoundingMode(true);
 			}
 		}
@@ -265,24 +266,16 @@ void IRBlockCache::Clear() {
 		blocks_[i].Destroy(i);
 	}
 	blocks_.clear();
-	byPage_.clear();
+	byPage_.Clear();
 }
 
 void IRBlockCache::InvalidateICache(u32 address, u32 length) {
-	u32 startPage = AddressToPage(address);
-	u32 endPage = AddressToPage(address + length);
-
-	for (u32 page = startPage; page <= endPage; ++page) {
-		const auto iter = byPage_.find(page);
-		if (iter == byPage_.end())
-			continue;
-
-		const std::vector<int> &blocksInPage = iter->second;
-		for (int i : blocksInPage) {
-			if (blocks_[i].OverlapsRange(address, length)) {
-				// Not removing from the page, hopefully doesn't build up with small recompiles.
-				blocks_[i].Destroy(i);
-			}
+	std::vector<int> candidates;
+	byPage_.GetBlocksInRange(address, length, &candidates);
+	for (int i : candidates) {
+		if (blocks_[i].OverlapsRange(address, length)) {
+			// Not removing from the page, hopefully doesn't build up with small recompiles.
+			blocks_[i].Destroy(i);
 		}
 	}
 }
@@ -294,28 +287,15 @@ void IRBlockCache::FinalizeBlock(int i, bool preload) {
 
 	u32 startAddr, size;
 	blocks_[i].GetRange(startAddr, size);
-
-	u32 startPage = AddressToPage(startAddr);
-	u32 endPage = AddressToPage(startAddr + size);
-
-	for (u32 page = startPage; page <= endPage; ++page) {
-		byPage_[page].push_back(i);
-	}
-}
-
-u32 IRBlockCache::AddressToPage(u32 addr) const {
-	// Use relatively small pages since basic blocks are typically small.
-	return (addr & 0x3FFFFFFF) >> 10;
+	byPage_.Add(startAddr, size, i);
 }
 
 int IRBlockCache::FindPreloadBlock(u32 em_address) {
-	u32 page = AddressToPage(em_address);
-	auto iter = byPage_.find(page);
-	if (iter == byPage_.end())
+	const std::vector<int> *blocksInPage = byPage_.GetBlocksOnPage(em_address);
+	if (!blocksInPage)
 		return -1;
 
-	const std::vector<int> &blocksInPage = iter->second;
-	for (int i : blocksInPage) {
+	for (int i : *blocksInPage) {
 		u32 start, mipsBytes;
 		blocks_[i].GetRange(start, mipsBytes);
 
@@ -414,15 +394,12 @@ void IRBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 }
 
 int IRBlockCache::GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly) const {
-	u32 page = AddressToPage(em_address);
-
-	const auto iter = byPage_.find(page);
-	if (iter == byPage_.end())
+	const std::vector<int> *blocksInPage = byPage_.GetBlocksOnPage(em_address);
+	if (!blocksInPage)
 		return -1;
 
-	const std::vector<int> &blocksInPage = iter->second;
 	int best = -1;
-	for (int i : blocksInPage) {
+	for (int i : *blocksInPage) {
 		uint32_t start, size;
 		blocks_[i].GetRange(start, size);
 		if (start == em_address) {
@@ -460,8 +437,10 @@ void IRBlock::Finalize(int number) {
 
 void IRBlock::Destroy(int number) {
 	if (origAddr_) {
+		// Blocks that were never finalized (preloaded, or the tier cache's) aren't valid and didn't write
+		// an emuhack. Any emuhack there belongs to someone else, like a native block with the same number.
 		MIPSOpcode opcode = MIPSOpcode(MIPS_EMUHACK_OPCODE | number);
-		if (Memory::ReadUnchecked_U32(origAddr_) == opcode.encoding)
+		if (IsValid() && Memory::ReadUnchecked_U32(origAddr_) == opcode.encoding)
 			Memory::Write_Opcode_JIT(origAddr_, origFirstOpcode_);
 
 		// Let's mark this invalid so we don't try to clear it again.
@@ -127,10 +127,8 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 	int GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly = true) const override;
 
 private:
-	u32 AddressToPage(u32 addr) const;
-
 	std::vector<IRBlock> blocks_;
-	std::unordered_map<u32, std::vector<int>> byPage_;
+	JitBlockPageIndex byPage_;
 };
 
 class IRJit : public JitInterface {
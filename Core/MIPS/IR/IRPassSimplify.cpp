@@ -684,6 +684,12 @@ bool PropagateConstants(const IRWriter &in, IRWriter &out, const IROptions &opts
 		case IROp::Vec4Shuffle:
 		case IROp::Vec4Neg:
 		case IROp::Vec4Abs:
+		case IROp::Vec4Recip:
+		case IROp::Vec4RSqrt:
+		case IROp::Vec4Sin:
+		case IROp::Vec4Cos:
+		case IROp::Mat4Mul:
+		case IROp::Mat4Transform:
 		case IROp::Vec4Pack31To8:
 		case IROp::Vec4Pack32To8:
 		case IROp::Vec2Pack32To16:
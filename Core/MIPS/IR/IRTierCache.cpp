@@ -0,0 +1,126 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <vector>
+
+#include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
+#include "Core/Config.h"
+#include "Core/Core.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/IR/IRTierCache.h"
+
+namespace MIPSComp {
+
+IRTierCache::IRTierCache(MIPSState *mips, int threshold) : frontend_(mips->HasDefaultPrefix()), mips_(mips), threshold_(threshold) {
+	InitIR();
+
+	IROptions opts{};
+	opts.disableFlags = g_Config.uJitDisableFlags;
+	opts.unalignedLoadStore = opts.disableFlags & (uint32_t)JitDisable::LSU_UNALIGNED;
+	frontend_.SetOptions(opts);
+}
+
+void IRTierCache::ClearCache() {
+	blocks_.Clear();
+	byAddress_.clear();
+}
+
+void IRTierCache::InvalidateCacheAt(u32 em_address, int length) {
+	// This just marks them destroyed, GetBlock() notices and recompiles.
+	blocks_.InvalidateICache(em_address, length);
+}
+
+IRTierCache::TierBlock *IRTierCache::GetBlock(u32 em_address, u32 op) {
+	auto it = byAddress_.find(em_address);
+	if (it != byAddress_.end()) {
+		TierBlock &tb = it->second;
+		u32 start, size;
+		blocks_.GetBlock(tb.irBlock)->GetRange(start, size);
+		if (start != 0 && tb.firstOp == op)
+			return &tb;
+		// Stale, keep the run count though - it's probably the same code reloaded.
+	}
+
+	PROFILE_THIS_SCOPE("jitc");
+	std::vector<IRInst> instructions;
+	u32 mipsBytes;
+	frontend_.DoJit(em_address, instructions, mipsBytes, false);
+	if (frontend_.CheckRounding(em_address)) {
+		// Same as IRJit, our assumptions were wrong so start over.
+		ClearCache();
+		instructions.clear();
+		frontend_.DoJit(em_address, instructions, mipsBytes, false);
+		it = byAddress_.end();
+	}
+	if (instructions.empty())
+		return nullptr;
+
+	if (blocks_.GetNumBlocks() >= MIPS_EMUHACK_VALUE_MASK) {
+		// Not really a limit for us since we don't write emuhacks, but let's not grow forever.
+		INFO_LOG(JIT, "IRTierCache: Clearing the cache!");
+		ClearCache();
+		it = byAddress_.end();
+	}
+
+	int block_num = blocks_.AllocateBlock(em_address);
+	IRBlock *b = blocks_.GetBlock(block_num);
+	b->SetInstructions(instructions);
+	b->SetOriginalSize(mipsBytes);
+	// As if preloaded, so it only gets indexed for invalidation and doesn't write an emuhack.
+	blocks_.FinalizeBlock(block_num, true);
+
+	if (it != byAddress_.end()) {
+		it->second.irBlock = block_num;
+		it->second.firstOp = op;
+		return &it->second;
+	}
+
+	TierBlock &tb = byAddress_[em_address];
+	tb.irBlock = block_num;
+	tb.firstOp = op;
+	tb.runCount = 0;
+	return &tb;
+}
+
+bool IRTierCache::RunColdBlocks() {
+	while (true) {
+		u32 pc = mips_->pc;
+		u32 op = Memory::ReadUnchecked_U32(pc);
+		if (MIPS_IS_RUNBLOCK(op)) {
+			// Already hot, let the dispatcher jump in.
+			return true;
+		}
+
+		TierBlock *tb = GetBlock(pc, op);
+		if (!tb || ++tb->runCount >= threshold_)
+			return false;
+
+		IRBlock *block = blocks_.GetBlock(tb->irBlock);
+		mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+		if (!Memory::IsValidAddress(mips_->pc)) {
+			Core_ExecException(mips_->pc, mips_->pc, ExecExceptionType::JUMP);
+			return true;
+		}
+		if (mips_->downcount < 0 || coreState != CORE_RUNNING)
+			return true;
+	}
+}
+
+}  // namespace MIPSComp
@@ -0,0 +1,67 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <unordered_map>
+
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRFrontend.h"
+#include "Core/MIPS/IR/IRJit.h"
+
+class MIPSState;
+
+namespace MIPSComp {
+
+// The cold tier for the native jits (see JitTierThreshold in the ini.)
+// Blocks are first run through the IR interpreter, and only handed to the native
+// jit once they've run enough times, so the code space only holds hot code.
+// No emuhacks are written for these blocks, the native blocks own those.
+class IRTierCache {
+public:
+	IRTierCache(MIPSState *mips, int threshold);
+
+	// Interprets blocks starting at the current pc.  Returns true when it stopped because the
+	// downcount ran out, the core state changed, or a native block was reached - in that case
+	// the dispatcher should just continue.  Returns false if the block at pc just got hot and
+	// should be compiled natively now.
+	bool RunColdBlocks();
+
+	void ClearCache();
+	void InvalidateCacheAt(u32 em_address, int length);
+
+	JitBlockCacheDebugInterface *GetBlockCacheDebugInterface() { return &blocks_; }
+
+private:
+	struct TierBlock {
+		int irBlock;
+		// To catch code that was overwritten without an icache invalidate, like the emuhacks do.
+		u32 firstOp;
+		int runCount;
+	};
+
+	TierBlock *GetBlock(u32 em_address, u32 op);
+
+	IRFrontend frontend_;
+	IRBlockCache blocks_;
+	std::unordered_map<u32, TierBlock> byAddress_;
+
+	MIPSState *mips_;
+	int threshold_;
+};
+
+}  // namespace MIPSComp
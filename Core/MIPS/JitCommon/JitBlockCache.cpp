@@ -59,6 +59,96 @@ op_agent_t agent;
 
 const u32 INVALID_EXIT = 0xFFFFFFFF;
 
+void JitBlockPageIndex::PageRange(u32 address, u32 size, u32 &first, u32 &last) {
+	const u32 pAddr = address & 0x1FFFFFFF;
+	// Clamp to the end of the address space, and always include the first page.
+	const u32 pLast = size == 0 ? pAddr : std::min(pAddr + (size - 1), (u32)0x1FFFFFFF);
+	first = pAddr >> PAGE_SHIFT;
+	last = std::max(pLast, pAddr) >> PAGE_SHIFT;
+}
+
+JitBlockPageIndex::Page *JitBlockPageIndex::GetPage(u32 page) {
+	std::unique_ptr<Page[]> &table = tables_[page >> LEVEL2_BITS];
+	if (!table)
+		table.reset(new Page[1 << LEVEL2_BITS]);
+	return &table[page & ((1 << LEVEL2_BITS) - 1)];
+}
+
+const JitBlockPageIndex::Page *JitBlockPageIndex::GetPage(u32 page) const {
+	const std::unique_ptr<Page[]> &table = tables_[page >> LEVEL2_BITS];
+	if (!table)
+		return nullptr;
+	return &table[page & ((1 << LEVEL2_BITS) - 1)];
+}
+
+void JitBlockPageIndex::Add(u32 address, u32 size, int blockNum) {
+	u32 first, last;
+	PageRange(address, size, first, last);
+	for (u32 page = first; page <= last; ++page)
+		GetPage(page)->push_back(blockNum);
+}
+
+bool JitBlockPageIndex::Remove(u32 address, u32 size, int blockNum) {
+	u32 first, last;
+	PageRange(address, size, first, last);
+	bool found = false;
+	for (u32 page = first; page <= last; ++page) {
+		if (!tables_[page >> LEVEL2_BITS])
+			continue;
+		Page *blocks = GetPage(page);
+		auto it = std::find(blocks->begin(), blocks->end(), blockNum);
+		if (it != blocks->end()) {
+			// Order doesn't matter, so avoid moving the rest.
+			*it = blocks->back();
+			blocks->pop_back();
+			found = true;
+		}
+	}
+	return found;
+}
+
+void JitBlockPageIndex::RemoveFromAllPages(int blockNum) {
+	for (auto &table : tables_) {
+		if (!table)
+			continue;
+		for (int i = 0; i < (1 << LEVEL2_BITS); ++i) {
+			Page &blocks = table[i];
+			blocks.erase(std::remove(blocks.begin(), blocks.end(), blockNum), blocks.end());
+		}
+	}
+}
+
+void JitBlockPageIndex::Clear() {
+	for (auto &table : tables_)
+		table.reset();
+}
+
+void JitBlockPageIndex::GetBlocksInRange(u32 address, u32 size, std::vector<int> *blockNums) const {
+	u32 first, last;
+	PageRange(address, size, first, last);
+	const size_t start = blockNums->size();
+	for (u32 page = first; page <= last; ++page) {
+		const Page *blocks = GetPage(page);
+		if (!blocks) {
+			// Skip the rest of the missing table.
+			page |= (1 << LEVEL2_BITS) - 1;
+			continue;
+		}
+		blockNums->insert(blockNums->end(), blocks->begin(), blocks->end());
+	}
+
+	// Blocks that span pages are on each of them.
+	if (first != last) {
+		std::sort(blockNums->begin() + start, blockNums->end());
+		blockNums->erase(std::unique(blockNums->begin() + start, blockNums->end()), blockNums->end());
+	}
+}
+
+const std::vector<int> *JitBlockPageIndex::GetBlocksOnPage(u32 address) const {
+	const Page *blocks = GetPage((address & 0x1FFFFFFF) >> PAGE_SHIFT);
+	return blocks && !blocks->empty() ? blocks : nullptr;
+}
+
 JitBlockCache::JitBlockCache(MIPSState *mips, CodeBlockCommon *codeBlock) :
 	codeBlock_(codeBlock), blocks_(nullptr), num_blocks_(0) {
 }
@@ -102,7 +192,7 @@ void JitBlockCache::Shutdown() {
 // This clears the JIT cache. It's called from JitCache.cpp when the JIT cache
 // is full and when saving and loading states.
 void JitBlockCache::Clear() {
-	block_map_.clear();
+	pageIndex_.Clear();
 	proxyBlockMap_.clear();
 	for (int i = 0; i < num_blocks_; i++)
 		DestroyBlock(i, DestroyType::CLEAR);
@@ -195,10 +285,7 @@ void JitBlockCache::ProxyBlock(u32 rootAddress, u32 startAddress, u32 size, cons
 
 void JitBlockCache::AddBlockMap(int block_num) {
 	const JitBlock &b = blocks_[block_num];
-	// Convert the logical address to a physical address for the block map
-	// Yeah, this'll work fine for PSP too I think.
-	u32 pAddr = b.originalAddress & 0x1FFFFFFF;
-	block_map_[std::make_pair(pAddr + 4 * b.originalSize, pAddr)] = block_num;
+	pageIndex_.Add(b.originalAddress, 4 * b.originalSize, block_num);
 }
 
 void JitBlockCache::RemoveBlockMap(int block_num) {
@@ -207,18 +294,9 @@ void JitBlockCache::RemoveBlockMap(int block_num) {
 		return;
 	}
 
-	const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
-	auto it = block_map_.find(std::make_pair(pAddr + 4 * b.originalSize, pAddr));
-	if (it != block_map_.end() && it->second == (u32)block_num) {
-		block_map_.erase(it);
-	} else {
-		// It wasn't in there, or it has the wrong key.  Let's search...
-		for (auto it = block_map_.begin(); it != block_map_.end(); ++it) {
-			if (it->second == (u32)block_num) {
-				block_map_.erase(it);
-				break;
-			}
-		}
+	if (!pageIndex_.Remove(b.originalAddress, 4 * b.originalSize, block_num)) {
+		// It wasn't in there, or its size changed.  Let's search...
+		pageIndex_.RemoveFromAllPages(block_num);
 	}
 }
 
@@ -356,7 +434,10 @@ int JitBlockCache::GetBlockNumberFromStartAddress(u32 addr, bool realBlocksOnly)
 }
 
 void JitBlockCache::GetBlockNumbersFromAddress(u32 em_address, std::vector<int> *block_numbers) {
-	for (int i = 0; i < num_blocks_; i++)
+	const std::vector<int> *onPage = pageIndex_.GetBlocksOnPage(em_address);
+	if (!onPage)
+		return;
+	for (int i : *onPage)
 		if (blocks_[i].ContainsAddress(em_address))
 			block_numbers->push_back(i);
 }
@@ -484,8 +565,9 @@ void JitBlockCache::DestroyBlock(int block_num, DestroyType type) {
 		return;
 	}
 	JitBlock *b = &blocks_[block_num];
-	// No point it being in there anymore.
-	RemoveBlockMap(block_num);
+	// No point it being in there anymore.  When clearing, the whole index was already cleared.
+	if (type != DestroyType::CLEAR)
+		RemoveBlockMap(block_num);
 
 	// Pure proxy blocks always point directly to a real block, there should be no chains of
 	// proxy-only blocks pointing to proxy-only blocks.
@@ -564,25 +646,20 @@ void JitBlockCache::InvalidateICache(u32 address, const u32 length) {
 		return;
 	}
 
-	// Blocks may start and end in overlapping ways, and destroying one invalidates iterators.
-	// So after destroying one, we start over.
-	do {
-	restart:
-		auto next = block_map_.lower_bound(std::make_pair(pAddr, 0));
-		auto last = block_map_.upper_bound(std::make_pair(pEnd + MAX_BLOCK_INSTRUCTIONS, 0));
-		// Note that if next is end(), last will be end() too (equal.)
-		for (; next != last; ++next) {
-			const u32 blockStart = next->first.second;
-			const u32 blockEnd = next->first.first;
-			if (blockStart < pEnd && blockEnd > pAddr) {
-				DestroyBlock(next->second, DestroyType::INVALIDATE);
-				// Our iterator is now invalid.  Break and search again.
-				// Most of the time there shouldn't be a bunch of matching blocks.
-				goto restart;
-			}
+	// Copy them out first, since destroying a block removes it from the index.
+	std::vector<int> candidates;
+	pageIndex_.GetBlocksInRange(pAddr, pEnd - pAddr, &candidates);
+	for (int block_num : candidates) {
+		const JitBlock &b = blocks_[block_num];
+		// Destroying one block can destroy others (proxies), so check again.
+		if (b.invalid)
+			continue;
+		const u32 blockStart = b.originalAddress & 0x1FFFFFFF;
+		const u32 blockEnd = blockStart + 4 * b.originalSize;
+		if (blockStart < pEnd && blockEnd > pAddr) {
+			DestroyBlock(block_num, DestroyType::INVALIDATE);
 		}
-		// We got here - it wasn't in the map at all (or anymore.)
-	} while (false);
+	}
 }
 
 void JitBlockCache::InvalidateChangedBlocks() {
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -101,6 +102,40 @@ struct JitBlockDebugInfo {
 	std::vector<std::string> targetDisasm;
 };
 
+// Lists the blocks touching each 1KB page of PSP memory, so invalidating a range only has to
+// look at the blocks on its pages.  The pages are in a two-level table, like a page table,
+// and the second level is only allocated where there's code.
+class JitBlockPageIndex {
+public:
+	void Add(u32 address, u32 size, int blockNum);
+	// Returns false if the block wasn't found on those pages.
+	bool Remove(u32 address, u32 size, int blockNum);
+	// Slow, for when the range a block was added with isn't known.
+	void RemoveFromAllPages(int blockNum);
+	void Clear();
+
+	// Each block is only listed once, but may not actually overlap the range.
+	void GetBlocksInRange(u32 address, u32 size, std::vector<int> *blockNums) const;
+	// Returns nullptr if there are no blocks on the page.
+	const std::vector<int> *GetBlocksOnPage(u32 address) const;
+
+private:
+	enum {
+		PAGE_SHIFT = 10,
+		// The address space is masked to 29 bits, like with physical addresses.
+		PAGE_COUNT_BITS = 29 - PAGE_SHIFT,
+		LEVEL2_BITS = 10,
+		LEVEL1_BITS = PAGE_COUNT_BITS - LEVEL2_BITS,
+	};
+	typedef std::vector<int> Page;
+
+	Page *GetPage(u32 page);
+	const Page *GetPage(u32 page) const;
+	static void PageRange(u32 address, u32 size, u32 &first, u32 &last);
+
+	std::unique_ptr<Page[]> tables_[1 << LEVEL1_BITS];
+};
+
 class JitBlockCacheDebugInterface {
 public:
 	virtual int GetNumBlocks() const = 0;
@@ -139,7 +174,6 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	// slower, but can get numbers from within blocks, not just the first instruction.
 	// WARNING! WILL NOT WORK WITH JIT INLINING ENABLED (not yet a feature but will be soon)
 	// Returns a list of block numbers - only one block can start at a particular address, but they CAN overlap.
-	// This one is slow so should only be used for one-shots from the debugger UI, not for anything during runtime.
 	void GetBlockNumbersFromAddress(u32 em_address, std::vector<int> *block_numbers);
 	int GetBlockNumberFromEmuHackOp(MIPSOpcode inst, bool ignoreBad = false) const;
 
@@ -185,7 +219,7 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 
 	int num_blocks_;
 	std::unordered_multimap<u32, int> links_to_;
-	std::map<std::pair<u32,u32>, u32> block_map_; // (end_addr, start_addr) -> number
+	JitBlockPageIndex pageIndex_;
 
 	enum {
 		JITBLOCK_RANGE_SCRATCH = 0,
@@ -21,15 +21,18 @@
 #include "ext/udis86/udis86.h"
 
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 
 #include "Core/Util/DisArm64.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
 #include "Core/MIPS/IR/IRJit.h"
+#include "Core/MIPS/IR/IRTierCache.h"
 
 #if PPSSPP_ARCH(ARM)
 #include "../ARM/ArmJit.h"
@@ -45,8 +48,23 @@
 
 namespace MIPSComp {
 	JitInterface *jit;
+	JitCompileStats jitCompileStats;
+
 	void JitAt() {
+		// When tiered, cold code runs through IR, and we only compile once it's hot.
+		IRTierCache *tier = jit->GetTierCache();
+		if (tier && tier->RunColdBlocks())
+			return;
+
+		if (!coreCollectDebugStats) {
+			jit->Compile(currentMIPS->pc);
+			return;
+		}
+
+		double start = time_now_d();
 		jit->Compile(currentMIPS->pc);
+		jitCompileStats.blocksCompiled++;
+		jitCompileStats.msCompiling += (time_now_d() - start) * 1000.0;
 	}
 
 	void DoDummyJitState(PointerWrap &p) {
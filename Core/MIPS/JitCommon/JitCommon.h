@@ -41,8 +41,22 @@ class PointerWrap;
 class MIPSState;
 
 namespace MIPSComp {
+	class IRTierCache;
+
 	void JitAt();
 
+	// Only counted while coreCollectDebugStats is on, reset along with the other frame stats.
+	struct JitCompileStats {
+		void Reset() {
+			blocksCompiled = 0;
+			msCompiling = 0.0;
+		}
+
+		int blocksCompiled;
+		double msCompiling;
+	};
+	extern JitCompileStats jitCompileStats;
+
 	class MIPSFrontendInterface {
 	public:
 		virtual ~MIPSFrontendInterface() {}
@@ -134,6 +148,8 @@ namespace MIPSComp {
 		virtual void CompileFunction(u32 start_address, u32 length) { }
 		virtual void ClearCache() = 0;
 		virtual void UpdateFCR31() = 0;
+		// Only when tiered, see JitTierThreshold.
+		virtual IRTierCache *GetTierCache() { return nullptr; }
 		virtual MIPSOpcode GetOriginalOp(MIPSOpcode op) = 0;
 
 		// No jit operations may be run between these calls.
@@ -64,6 +64,8 @@ namespace MIPSComp {
 		int nextExit;
 		bool cancel;
 		bool inDelaySlot;
+		// Compiling the syscall in a jr/jalr delay slot, which can skip the exit (see HLE_JIT_FAST_CALL.)
+		bool jumpRegSyscall = false;
 		// See JitState::AfterOp for values.
 		int afterOp;
 		int downcountAmount;
@@ -201,6 +203,8 @@ namespace MIPSComp {
 		LSU_FPU = 0x4000,
 		LSU_VFPU = 0x8000,
 
+		FAST_SYSCALL = 0x00010000,
+
 		SIMD = 0x00100000,
 		BLOCKLINK = 0x00200000,
 		POINTERIFY = 0x00400000,
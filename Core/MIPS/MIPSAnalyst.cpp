@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -30,6 +32,7 @@
 #include "Core/Config.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
+#include "Core/ThreadPools.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "Core/MIPS/MIPSTables.h"
@@ -49,6 +52,10 @@ std::recursive_mutex functions_lock;
 // One function can appear in multiple copies in memory, and they will all have 
 // the same hash and should all be replaced if possible.
 static std::unordered_multimap<u64, MIPSAnalyst::AnalyzedFunction *> hashToFunction;
+// Functions (start, length) waiting to be precompiled between frames.
+static std::deque<std::pair<u32, u32>> precompileQueue;
+static int precompileCount;
+static double precompileTime;
 
 struct HashMapFunc {
 	char name[64];
@@ -751,6 +758,7 @@ namespace MIPSAnalyst {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 		functions.clear();
 		hashToFunction.clear();
+		precompileQueue.clear();
 	}
 
 	void UpdateHashToFunctionMap() {
@@ -875,40 +883,44 @@ namespace MIPSAnalyst {
 		return DetermineRegisterUsage(reg, addr, instrs) == USAGE_CLOBBERED;
 	}
 
-	void HashFunctions() {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-		std::vector<u32> buffer;
+	static void HashFunction(AnalyzedFunction &f, std::vector<u32> &buffer) {
+		if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
+			return;
+		}
 
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			AnalyzedFunction &f = *iter;
-			if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
-				continue;
+		// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
+		buffer.resize((f.end - f.start + 4) / 4);
+		size_t pos = 0;
+		for (u32 addr = f.start; addr <= f.end; addr += 4) {
+			u32 validbits = 0xFFFFFFFF;
+			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
+			if (MIPS_IS_EMUHACK(instr)) {
+				f.hasHash = false;
+				return;
 			}
 
-			// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
-			buffer.resize((f.end - f.start + 4) / 4);
-			size_t pos = 0;
-			for (u32 addr = f.start; addr <= f.end; addr += 4) {
-				u32 validbits = 0xFFFFFFFF;
-				MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
-				if (MIPS_IS_EMUHACK(instr)) {
-					f.hasHash = false;
-					goto skip;
-				}
+			MIPSInfo flags = MIPSGetInfo(instr);
+			if (flags & IN_IMM16)
+				validbits &= ~0xFFFF;
+			if (flags & IN_IMM26)
+				validbits &= ~0x03FFFFFF;
+			buffer[pos++] = instr & validbits;
+		}
 
-				MIPSInfo flags = MIPSGetInfo(instr);
-				if (flags & IN_IMM16)
-					validbits &= ~0xFFFF;
-				if (flags & IN_IMM26)
-					validbits &= ~0x03FFFFFF;
-				buffer[pos++] = instr & validbits;
-			}
+		f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
+		f.hasHash = true;
+	}
 
-			f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
-			f.hasHash = true;
-skip:
-			;
-		}
+	void HashFunctions() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		// Every function is hashed separately, so just split them up.
+		GlobalThreadPool::Loop([&](int lower, int upper) {
+			std::vector<u32> buffer;
+			for (int i = lower; i < upper; ++i) {
+				HashFunction(functions[i], buffer);
+			}
+		}, 0, (int)functions.size());
 	}
 
 	void PrecompileFunction(u32 startAddr, u32 length) {
@@ -926,15 +938,43 @@ namespace MIPSAnalyst {
 
 		// TODO: Load from cache file if available instead.
 
-		double st = time_now_d();
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			const AnalyzedFunction &f = *iter;
+		// This can take seconds for a big module, so only do a bit now and the rest between frames.
+		precompileQueue.clear();
+		for (const AnalyzedFunction &f : functions) {
+			precompileQueue.push_back(std::make_pair(f.start, f.end - f.start + 4));
+		}
+		precompileCount = 0;
+		precompileTime = 0.0;
+		PrecompileQueuedFunctions();
+	}
 
-			PrecompileFunction(f.start, f.end - f.start + 4);
+	void PrecompileQueuedFunctions() {
+		// How long to spend each time we're called, in seconds.
+		static const double PRECOMPILE_BUDGET = 0.002;
+
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		if (precompileQueue.empty()) {
+			return;
+		}
+		if (!MIPSComp::jit) {
+			precompileQueue.clear();
+			return;
 		}
-		double et = time_now_d();
 
-		NOTICE_LOG(JIT, "Precompiled %d MIPS functions in %0.2f milliseconds", (int)functions.size(), (et - st) * 1000.0);
+		double st = time_now_d();
+		double et = st;
+		while (!precompileQueue.empty() && et - st < PRECOMPILE_BUDGET) {
+			auto func = precompileQueue.front();
+			precompileQueue.pop_front();
+			PrecompileFunction(func.first, func.second);
+			precompileCount++;
+			et = time_now_d();
+		}
+		precompileTime += et - st;
+
+		if (precompileQueue.empty()) {
+			NOTICE_LOG(JIT, "Precompiled %d MIPS functions in %0.2f milliseconds", precompileCount, precompileTime * 1000.0);
+		}
 	}
 
 	static const char *DefaultFunctionName(char buffer[256], u32 startAddr) {
@@ -1021,12 +1061,19 @@ namespace MIPSAnalyst {
 		return furthestJumpbackAddr;
 	}
 
-	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-
-		FunctionsVector new_functions;
+	struct FunctionScan {
+		FunctionsVector functions;
+		// Where the scan of each function began, before skipping nop padding.
+		std::vector<u32> scanStarts;
+		// Where the scan of the next function would begin.
+		u32 next = 0;
+	};
 
+	// startAddr must be right after the end of a function (or the start of code.)  Stops before a function that
+	// would begin at or past stopAddr, or at any of the (sorted) resync addresses, or when it runs past endAddr.
+	static void ScanFunctionsFrom(u32 startAddr, u32 endAddr, u32 stopAddr, const std::vector<u32> *resync, FunctionScan &scan) {
 		AnalyzedFunction currentFunction = {startAddr};
+		u32 scanStart = startAddr;
 
 		u32 furthestBranch = 0;
 		bool looking = false;
@@ -1130,23 +1177,8 @@ namespace MIPSAnalyst {
 			if (end) {
 				currentFunction.end = addr + 4;
 				currentFunction.isStraightLeaf = isStraightLeaf;
-
-				// Check if we already have symbol info starting here.  If so, skip insertion.
-				// We used to use the symbols to find the functions, but sometimes we'd find
-				// wrong ones due to two modules with the same name.
-				u32 existingSize = g_symbolMap->GetFunctionSize(currentFunction.start);
-				if (existingSize != SymbolMap::INVALID_ADDRESS) {
-					currentFunction.foundInSymbolMap = true;
-
-					// If we run into a func with a different size, skip updating the hash map.
-					// This will prevent us saving incorrectly named funcs with wrong hashes.
-					u32 detectedSize = currentFunction.end - currentFunction.start + 4;
-					if (existingSize != detectedSize) {
-						insertSymbols = false;
-					}
-				}
-
-				new_functions.push_back(currentFunction);
+				scan.functions.push_back(currentFunction);
+				scan.scanStarts.push_back(scanStart);
 
 				furthestBranch = 0;
 				addr += 4;
@@ -1155,17 +1187,110 @@ namespace MIPSAnalyst {
 				isStraightLeaf = true;
 				decreasedSp = false;
 				currentFunction.start = addr + 4;
-				currentFunction.foundInSymbolMap = false;
+
+				// Nothing carries over between functions, so from here on we'd match any scan that starts here.
+				scanStart = addr + 4;
+				if (scanStart >= stopAddr || (resync && std::binary_search(resync->begin(), resync->end(), scanStart))) {
+					scan.next = scanStart;
+					return;
+				}
+			}
+		}
+
+		// The last function didn't end in range, so it's dropped.
+		scan.next = addr;
+	}
+
+	// Looks for a likely place for a function to start near addr, to split up a scan.
+	static u32 GuessFunctionStart(u32 addr, u32 endAddr) {
+		static const u32 MAX_GUESS_SCAN = 0x1000;
+		for (u32 ahead = addr; ahead < addr + MAX_GUESS_SCAN && ahead + 8 <= endAddr; ahead += 4) {
+			if (Memory::Read_Instruction(ahead, true) == MIPS_MAKE_JR_RA()) {
+				return ahead + 8;
+			}
+		}
+		return addr;
+	}
+
+	static void ScanRangeForFunctions(u32 startAddr, u32 endAddr, FunctionsVector &found) {
+		static const u32 SCAN_CHUNK_SIZE = 0x10000;
+
+		if (endAddr < startAddr || endAddr - startAddr < SCAN_CHUNK_SIZE * 2) {
+			FunctionScan scan;
+			ScanFunctionsFrom(startAddr, endAddr, 0xFFFFFFFF, nullptr, scan);
+			found.insert(found.end(), scan.functions.begin(), scan.functions.end());
+			return;
+		}
+
+		// Functions only depend on where they start, so scan chunks in parallel from guessed starts.
+		std::vector<u32> chunkStarts;
+		chunkStarts.push_back(startAddr);
+		for (u32 addr = startAddr + SCAN_CHUNK_SIZE; addr < endAddr - SCAN_CHUNK_SIZE / 2; addr += SCAN_CHUNK_SIZE) {
+			u32 guess = GuessFunctionStart(addr, endAddr);
+			if (guess > chunkStarts.back()) {
+				chunkStarts.push_back(guess);
 			}
 		}
 
-		if (addr <= endAddr) {
-			currentFunction.end = addr + 4;
-			new_functions.push_back(currentFunction);
+		const int numChunks = (int)chunkStarts.size();
+		auto chunkStop = [&](int i) {
+			return i + 1 < numChunks ? chunkStarts[i + 1] : 0xFFFFFFFF;
+		};
+		std::vector<FunctionScan> guesses(numChunks);
+		GlobalThreadPool::Loop([&](int lower, int upper) {
+			for (int i = lower; i < upper; ++i) {
+				ScanFunctionsFrom(chunkStarts[i], endAddr, chunkStop(i), nullptr, guesses[i]);
+			}
+		}, 0, numChunks);
+
+		// Now follow the real scan.  Once it reaches a function a guess found, the rest of that guess is right.
+		// Otherwise, rescan until it does, which usually doesn't take more than a function or two.
+		u32 addr = startAddr;
+		for (int i = 0; i < numChunks && addr <= endAddr; ++i) {
+			const FunctionScan &guess = guesses[i];
+			auto joined = std::lower_bound(guess.scanStarts.begin(), guess.scanStarts.end(), addr);
+			if (joined == guess.scanStarts.end() || *joined != addr) {
+				FunctionScan scan;
+				ScanFunctionsFrom(addr, endAddr, chunkStop(i), &guess.scanStarts, scan);
+				found.insert(found.end(), scan.functions.begin(), scan.functions.end());
+				addr = scan.next;
+
+				joined = std::lower_bound(guess.scanStarts.begin(), guess.scanStarts.end(), addr);
+				if (joined == guess.scanStarts.end() || *joined != addr) {
+					continue;
+				}
+			}
+
+			found.insert(found.end(), guess.functions.begin() + (joined - guess.scanStarts.begin()), guess.functions.end());
+			addr = guess.next;
 		}
+	}
+
+	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		FunctionsVector new_functions;
+		ScanRangeForFunctions(startAddr, endAddr, new_functions);
 
 		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
 			iter->size = iter->end - iter->start + 4;
+
+			// Check if we already have symbol info starting here.  If so, skip insertion.
+			// We used to use the symbols to find the functions, but sometimes we'd find
+			// wrong ones due to two modules with the same name.
+			u32 existingSize = g_symbolMap->GetFunctionSize(iter->start);
+			if (existingSize != SymbolMap::INVALID_ADDRESS) {
+				iter->foundInSymbolMap = true;
+
+				// If we run into a func with a different size, skip updating the hash map.
+				// This will prevent us saving incorrectly named funcs with wrong hashes.
+				if (existingSize != iter->size) {
+					insertSymbols = false;
+				}
+			}
+		}
+
+		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
 			if (insertSymbols && !iter->foundInSymbolMap) {
 				char temp[256];
 				g_symbolMap->AddFunction(DefaultFunctionName(temp, iter->start), iter->start, iter->end - iter->start + 4);
@@ -1259,6 +1384,10 @@ namespace MIPSAnalyst {
 
 		RestoreReplacedInstructions(startAddr, endAddr);
 
+		precompileQueue.erase(std::remove_if(precompileQueue.begin(), precompileQueue.end(), [&](const std::pair<u32, u32> &func) {
+			return func.first >= startAddr && func.first <= endAddr;
+		}), precompileQueue.end());
+
 		if (functions.empty()) {
 			hashToFunction.clear();
 		} else if (originalSize != functions.size()) {
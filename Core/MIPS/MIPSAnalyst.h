@@ -109,7 +109,10 @@ namespace MIPSAnalyst
 	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols);
 	void FinalizeScan(bool insertSymbols);
 	void ForgetFunctions(u32 startAddr, u32 endAddr);
+	// Queues all functions to precompile, and starts on them.
 	void PrecompileFunctions();
+	// Continues precompiling for a short while, if there's anything left.  Call between frames.
+	void PrecompileQueuedFunctions();
 	void PrecompileFunction(u32 startAddr, u32 length);
 
 	void SetHashMapFilename(const std::string& filename = "");
@@ -193,7 +193,9 @@ void Jit::GenerateFixedCode(JitOptions &jo) {
 			RestoreRoundingMode(true);
 			ABI_CallFunction(&MIPSComp::JitAt);
 			ApplyRoundingMode(true);
-			JMP(dispatcherNoCheck, true); // Let's just dispatch again, we'll enter the block since we know it's there.
+			// Usually we'll now enter the new block, but when tiered JitAt may have run cold code instead.
+			CMP(32, MIPSSTATE_VAR(downcount), Imm8(0));
+			JMP(dispatcherCheckCoreState, true);
 
 		SetJumpTarget(bail);
 		SetJumpTarget(bailCoreState);
@@ -696,10 +696,16 @@ void Jit::Comp_JumpReg(MIPSOpcode op)
 		MOV(32, MIPSSTATE_VAR(pc), gpr.R(rs));
 		if (andLink)
 			gpr.SetImm(rd, GetCompilerPC() + 8);
+		js.jumpRegSyscall = true;
 		CompileDelaySlot(DELAYSLOT_FLUSH);
+		js.jumpRegSyscall = false;
 
-		// Syscalls write the exit code for us.
-		_dbg_assert_msg_(!js.compiling, "Expected syscall to write an exit code.");
+		// Syscalls write the exit code for us, unless it was fast and didn't need to.
+		if (js.compiling) {
+			MOV(32, R(EAX), MIPSSTATE_VAR(pc));
+			WriteExitDestInReg(EAX);
+			js.compiling = false;
+		}
 		return;
 	}
 	else if (delaySlotIsNice)
@@ -799,6 +805,21 @@ void Jit::Comp_Syscall(MIPSOpcode op)
 	// When profiling, we can't skip CallSyscall, since it times syscalls.
 	ABI_CallFunctionC(&CallSyscall, op.encoding);
 #else
+	// Some hot syscalls can be called directly, and we keep going if they didn't reschedule.
+	const HLEFunction *fastFunc = nullptr;
+	if ((!js.inDelaySlot || js.jumpRegSyscall) && !jo.Disabled(JitDisable::FAST_SYSCALL))
+		fastFunc = GetFastSyscallFunc(op);
+	if (fastFunc) {
+		ABI_CallFunctionP((const void *)&CallFastSyscall, (void *)fastFunc);
+		TEST(32, R(EAX), R(EAX));
+		FixupBranch skipExit = J_CC(CC_Z, true);
+		ApplyRoundingMode();
+		WriteSyscallExit();
+		SetJumpTarget(skipExit);
+		ApplyRoundingMode();
+		return;
+	}
+
 	// Skip the CallSyscall where possible.
 	void *quickFunc = GetQuickSyscallFunc(op);
 	if (quickFunc)
@@ -37,6 +37,7 @@
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSInt.h"
 #include "Core/MIPS/MIPSTables.h"
+#include "Core/MIPS/IR/IRTierCache.h"
 #include "Core/HLE/ReplaceTables.h"
 
 #include "RegCache.h"
@@ -116,6 +117,8 @@ Jit::Jit(MIPSState *mips)
 	safeMemFuncs.Init(&thunks);
 
 	js.startDefaultPrefix = mips_->HasDefaultPrefix();
+	if (g_Config.iJitTierThreshold > 0)
+		tier_.reset(new IRTierCache(mips, g_Config.iJitTierThreshold));
 
 	// The debugger sets this so that "go" on a breakpoint will actually... go.
 	// But if they reset, we can end up hitting it by mistake, since it's based on PC and ticks.
@@ -212,6 +215,18 @@ void Jit::ClearCache()
 	blocks.Clear();
 	ClearCodeSpace(0);
 	GenerateFixedCode(jo);
+	// Everything starts cold again, so only code that's still hot comes back.
+	if (tier_)
+		tier_->ClearCache();
+}
+
+void Jit::InvalidateCacheAt(u32 em_address, int length) {
+	if (blocks.RangeMayHaveEmuHacks(em_address, em_address + length)) {
+		blocks.InvalidateICache(em_address, length);
+	}
+	// Cold blocks have no emuhacks, so always check those.
+	if (tier_)
+		tier_->InvalidateCacheAt(em_address, length);
 }
 
 void Jit::SaveFlags() {
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "Common/CommonTypes.h"
 #include "Common/Thunk.h"
 #include "Common/x64Emitter.h"
@@ -168,12 +170,9 @@ class Jit : public Gen::XCodeBlock, public JitInterface, public MIPSFrontendInte
 	void RestoreSavedEmuHackOps(std::vector<u32> saved) override { blocks.RestoreSavedEmuHackOps(saved); }
 
 	void ClearCache() override;
-	void InvalidateCacheAt(u32 em_address, int length = 4) override {
-		if (blocks.RangeMayHaveEmuHacks(em_address, em_address + length)) {
-			blocks.InvalidateICache(em_address, length);
-		}
-	}
+	void InvalidateCacheAt(u32 em_address, int length = 4) override;
 	void UpdateFCR31() override;
+	IRTierCache *GetTierCache() override { return tier_.get(); }
 
 	const u8 *GetDispatcher() const override {
 		return dispatcher;
@@ -313,6 +312,7 @@ class Jit : public Gen::XCodeBlock, public JitInterface, public MIPSFrontendInte
 
 	MIPSState *mips_;
 
+	std::unique_ptr<IRTierCache> tier_;
 
 	const u8 *enterDispatcher;
 
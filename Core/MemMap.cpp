@@ -22,6 +22,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 
 #include "Common/Common.h"
@@ -319,6 +320,9 @@ void DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+	if (p.mode == PointerWrap::MODE_READ)
+		MarkAllDirty();
+
 	if (s < 2) {
 		if (!g_RemasterMode)
 			g_MemorySize = RAM_NORMAL_SIZE;
@@ -364,6 +368,7 @@ void Shutdown() {
 }
 
 void Clear() {
+	MarkAllDirty();
 	if (m_pPhysicalRAM)
 		memset(GetPointerUnchecked(PSP_GetKernelMemoryBase()), 0, g_MemorySize);
 	if (m_pPhysicalScratchPad)
@@ -468,7 +473,81 @@ void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength) {
 			Write_U8(_iValue, (u32)(_Address + i));
 	}
 
+	MarkDirty(_Address, _iLength);
 	CBreakPoints::ExecMemCheck(_Address, true, _iLength, currentMIPS->pc);
 }
 
+// VRAM (with mirrors folded) and up to 64MB of RAM are tracked.
+static const u32 DIRTY_PAGE_SHIFT = 12;
+static const u32 DIRTY_TRACK_BASE = 0x04000000;
+static const u32 DIRTY_TRACK_END = 0x0C000000;
+// The emu, GPU and IO threads all mark memory dirty, so these are atomics too (also avoids torn
+// 64-bit stamps on 32-bit hosts.) Only the stamp values matter, so relaxed ordering is fine for the pages.
+static std::atomic<u64> dirtyPageStamps[(DIRTY_TRACK_END - DIRTY_TRACK_BASE) >> DIRTY_PAGE_SHIFT];
+static std::atomic<u64> dirtyAllStamp{ 1 };
+static std::atomic<u64> dirtyNextStamp{ 2 };
+
+// Returns false if the range isn't tracked.
+static bool GetDirtyPageRange(u32 address, u32 size, u32 &firstPage, u32 &lastPage) {
+	address &= 0x3FFFFFFF;
+	u32 end = address + size;
+	if ((address & 0x3F800000) == 0x04000000) {
+		address &= 0x041FFFFF;
+		end = address + size;
+		// Wraps around a mirror, just take all of VRAM.
+		if (end > 0x04000000 + VRAM_SIZE || end < address) {
+			address = 0x04000000;
+			end = 0x04000000 + VRAM_SIZE;
+		}
+	}
+	if (address < DIRTY_TRACK_BASE || end > DIRTY_TRACK_END || end < address) {
+		return false;
+	}
+	firstPage = (address - DIRTY_TRACK_BASE) >> DIRTY_PAGE_SHIFT;
+	lastPage = (end - 1 - DIRTY_TRACK_BASE) >> DIRTY_PAGE_SHIFT;
+	return true;
+}
+
+void MarkDirty(u32 address, u32 size) {
+	if (size == 0)
+		return;
+	u32 firstPage, lastPage;
+	if (!GetDirtyPageRange(address, size, firstPage, lastPage)) {
+		return;
+	}
+	const u64 stamp = dirtyNextStamp.fetch_add(1);
+	for (u32 page = firstPage; page <= lastPage; ++page) {
+		// Another thread may have stored a newer stamp in the meantime, don't go backwards.
+		u64 prev = dirtyPageStamps[page].load(std::memory_order_relaxed);
+		while (prev < stamp && !dirtyPageStamps[page].compare_exchange_weak(prev, stamp, std::memory_order_relaxed)) {
+			continue;
+		}
+	}
+}
+
+void MarkAllDirty() {
+	dirtyAllStamp = dirtyNextStamp.fetch_add(1);
+}
+
+u64 GetDirtyStamp() {
+	// Anything written from now on gets a higher stamp.
+	return dirtyNextStamp - 1;
+}
+
+bool IsDirtySince(u32 address, u32 size, u64 stamp) {
+	if (dirtyAllStamp > stamp)
+		return true;
+	if (size == 0)
+		return false;
+	u32 firstPage, lastPage;
+	if (!GetDirtyPageRange(address, size, firstPage, lastPage)) {
+		return true;
+	}
+	for (u32 page = firstPage; page <= lastPage; ++page) {
+		if (dirtyPageStamps[page].load(std::memory_order_relaxed) > stamp)
+			return true;
+	}
+	return false;
+}
+
 } // namespace
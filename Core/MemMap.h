@@ -334,6 +334,16 @@ inline bool IsValidRange(const u32 address, const u32 size) {
 	return IsValidAddress(address) && ValidSize(address, size) == size;
 }
 
+// Coarse, per-page tracking of writes made by HLE (Memcpy, Memset, file reads, replaced memcpy)
+// and of cache writebacks reported by the game, for caches of guest memory like the texture cache.
+// Plain CPU stores are not seen, so this can only be used as a hint.
+void MarkDirty(u32 address, u32 size);
+void MarkAllDirty();
+// Take this before reading memory, and pass it to IsDirtySince() later.
+u64 GetDirtyStamp();
+// Also returns true for anything outside RAM and VRAM.
+bool IsDirtySince(u32 address, u32 size, u64 stamp);
+
 }  // namespace Memory
 
 template <typename T>
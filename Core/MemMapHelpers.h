@@ -33,6 +33,7 @@ inline void Memcpy(const u32 to_address, const void *from_data, const u32 len)
 	u8 *to = GetPointer(to_address);
 	if (to) {
 		memcpy(to, from_data, len);
+		MarkDirty(to_address, len);
 		CBreakPoints::ExecMemCheck(to_address, true, len, currentMIPS->pc);
 	}
 	// if not, GetPointer will log.
@@ -51,6 +52,7 @@ inline void Memcpy(void *to_data, const u32 from_address, const u32 len)
 inline void Memcpy(const u32 to_address, const u32 from_address, const u32 len)
 {
 	Memcpy(GetPointer(to_address), from_address, len);
+	MarkDirty(to_address, len);
 	CBreakPoints::ExecMemCheck(to_address, true, len, currentMIPS->pc);
 }
 
@@ -121,6 +121,7 @@ static size_t replayExecPos = 0;
 static bool replaySaveWroteHeader = false;
 static ReplayState replayState = ReplayState::IDLE;
 static bool replaySawGameDirWrite = false;
+static uint64_t replayRtcBaseSeconds = 0;
 
 static size_t replayCtrlPos = 0;
 static uint32_t lastButtons = 0;
@@ -172,6 +173,7 @@ bool ReplayExecuteFile(const std::string &filename) {
 	}
 
 	std::vector<u8> data;
+	ReplayFileHeader fh;
 	auto loadData = [&]() {
 		// TODO: Maybe stream instead.
 		size_t sz = File::GetFileSize(fp);
@@ -180,7 +182,6 @@ bool ReplayExecuteFile(const std::string &filename) {
 			return false;
 		}
 
-		ReplayFileHeader fh;
 		if (fread(&fh, sizeof(fh), 1, fp) != 1) {
 			ERROR_LOG(SYSTEM, "Could not read replay file header");
 			return false;
@@ -212,6 +213,7 @@ bool ReplayExecuteFile(const std::string &filename) {
 	if (loadData()) {
 		fclose(fp);
 		ReplayExecuteBlob(data);
+		replayRtcBaseSeconds = fh.rtcBaseSeconds;
 		return true;
 	}
 
@@ -223,6 +225,11 @@ bool ReplayHasMoreEvents() {
 	return replayExecPos < replayItems.size();
 }
 
+void ReplaySyncRtc() {
+	if (replayState == ReplayState::EXECUTE && replayRtcBaseSeconds != 0)
+		RtcSetBaseTime((int32_t)replayRtcBaseSeconds);
+}
+
 void ReplayBeginSave() {
 	if (replayState != ReplayState::EXECUTE) {
 		// Restart any save operation.
@@ -303,6 +310,7 @@ void ReplayAbort() {
 	replaySaveWroteHeader = false;
 	replayState = ReplayState::IDLE;
 	replaySawGameDirWrite = false;
+	replayRtcBaseSeconds = 0;
 
 	replayCtrlPos = 0;
 	lastButtons = 0;
@@ -52,6 +52,9 @@ void ReplayExecuteBlob(const std::vector<u8> &data);
 bool ReplayExecuteFile(const std::string &filename);
 // Returns whether there are unexected events to replay.
 bool ReplayHasMoreEvents();
+// Sets the RTC to when the file being executed was recorded, so the game sees the same dates.
+// Call after the RTC is initialized.  Does nothing for data from ReplayExecuteBlob().
+void ReplaySyncRtc();
 
 // Begin recording.  If currently executing, discards unexecuted events.
 void ReplayBeginSave();
@@ -17,11 +17,9 @@
 
 #include <algorithm>
 #include <vector>
-#include <thread>
 #include <mutex>
 
 #include "Common/Data/Text/I18n.h"
-#include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Text/Parsers.h"
 
 #include "Common/File/FileUtil.h"
@@ -89,8 +87,8 @@ namespace SaveState
 	CChunkFileReader::Error SaveToRam(std::vector<u8> &data) {
 		SaveStart state;
 		size_t sz = CChunkFileReader::MeasurePtr(state);
-		if (data.size() < sz)
-			data.resize(sz);
+		// Keep it exact, rewind compares against it.  Shrinking won't reallocate.
+		data.resize(sz);
 		return CChunkFileReader::SavePtr(&data[0], state);
 	}
 
@@ -115,8 +113,6 @@ namespace SaveState
 			if ((next_ % size_) == first_)
 				++first_;
 
-			static std::vector<u8> buffer;
-			std::vector<u8> *compressBuffer = &buffer;
 			CChunkFileReader::Error err;
 
 			if (base_ == -1 || ++baseUsage_ > BASE_USAGE_INTERVAL)
@@ -124,15 +120,14 @@ namespace SaveState
 				base_ = (base_ + 1) % ARRAY_SIZE(bases_);
 				baseUsage_ = 0;
 				err = SaveToRam(bases_[base_]);
-				// Let's not bother savestating twice.
-				compressBuffer = &bases_[base_];
+				// Let's not bother savestating twice, every block is the same as the base.
+				if (err == CChunkFileReader::ERROR_NONE)
+					states_[n].assign((bases_[base_].size() + BLOCK_SIZE - 1) / BLOCK_SIZE, 0);
 			}
 			else
-				err = SaveToRam(buffer);
+				err = SaveDelta(states_[n], bases_[base_]);
 
-			if (err == CChunkFileReader::ERROR_NONE)
-				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_]);
-			else
+			if (err != CChunkFileReader::ERROR_NONE)
 				states_[n].clear();
 			baseMapping_[n] = base_;
 			return err;
@@ -155,35 +150,30 @@ namespace SaveState
 			return LoadFromRam(buffer, errorString);
 		}
 
-		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base)
-		{
-			if (compressThread_.joinable())
-				compressThread_.join();
-			compressThread_ = std::thread([=]{
-				setCurrentThreadName("SaveStateCompress");
-				Compress(*result, *state, *base);
-			});
-		}
-
-		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base)
+		CChunkFileReader::Error SaveDelta(std::vector<u8> &result, const std::vector<u8> &base)
 		{
-			std::lock_guard<std::mutex> guard(lock_);
-			// Bail if we were cleared before locking.
-			if (first_ == 0 && next_ == 0)
-				return;
+			// Most of the state is RAM and VRAM that hasn't changed since the base.  Rather than
+			// writing it all out and diffing later, compare each block while it's still in cache.
+			ChunkedOutput output(BLOCK_SIZE, false);
+			output.SetReference(base.data(), base.size());
+			SaveStart state;
+			CChunkFileReader::Error err = CChunkFileReader::SaveToOutput(output, state);
+			if (err != CChunkFileReader::ERROR_NONE)
+				return err;
 
 			result.clear();
-			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
+			for (size_t i = 0; i < output.NumBlocks(); ++i)
 			{
-				int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
-				if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0)
+				if (output.BlockChanged(i))
 				{
+					const std::vector<u8> &block = output.Block(i);
 					result.push_back(1);
-					result.insert(result.end(), state.begin() + i, state.begin() +i + blockSize);
+					result.insert(result.end(), block.begin(), block.end());
 				}
 				else
 					result.push_back(0);
 			}
+			return err;
 		}
 
 		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
@@ -213,9 +203,6 @@ namespace SaveState
 
 		void Clear()
 		{
-			if (compressThread_.joinable())
-				compressThread_.join();
-
 			// This lock is mainly for shutdown.
 			std::lock_guard<std::mutex> guard(lock_);
 			first_ = 0;
@@ -241,7 +228,6 @@ namespace SaveState
 		StateBuffer bases_[2];
 		std::vector<int> baseMapping_;
 		std::mutex lock_;
-		std::thread compressThread_;
 
 		int base_;
 		int baseUsage_;
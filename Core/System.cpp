@@ -44,6 +44,7 @@
 #include "Core/HDRemaster.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAnalyst.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Host.h"
@@ -388,6 +389,7 @@ void Core_UpdateDebugStats(bool collectStats) {
 
 	kernelStats.ResetFrame();
 	gpuStats.ResetFrame();
+	MIPSComp::jitCompileStats.Reset();
 }
 
 bool PSP_InitStart(const CoreParameter &coreParam, std::string *error_string) {
@@ -553,6 +555,7 @@ void PSP_RunLoopUntil(u64 globalticks) {
 		return;
 	}
 
+	MIPSAnalyst::PrecompileQueuedFunctions();
 	mipsr4k.RunLoopUntil(globalticks);
 	gpu->CleanupBeforeUI();
 }
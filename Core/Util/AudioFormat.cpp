@@ -15,6 +15,10 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
 #include "Core/Util/AudioFormat.h"
@@ -23,6 +27,13 @@
 #ifdef _M_SSE
 #include <emmintrin.h>
 #endif
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
 
 void AdjustVolumeBlockStandard(s16 *out, s16 *in, size_t size, int leftVol, int rightVol) {
 #ifdef _M_SSE
@@ -110,14 +121,228 @@ void ConvertS16ToF32(float *out, const s16 *in, size_t size) {
 	}
 }
 
+template<bool useShift>
+inline void ClampBufferToS16(s16 *out, const s32 *in, size_t size, int volShift) {
+#ifdef _M_SSE
+	// Size will always be 16-byte aligned as the hwBlockSize is.
+	while (size >= 8) {
+		__m128i in1 = _mm_loadu_si128((__m128i *)in);
+		__m128i in2 = _mm_loadu_si128((__m128i *)(in + 4));
+		// Shift before saturating, like the remainder loop below.
+		if (useShift) {
+			in1 = _mm_srai_epi32(in1, volShift);
+			in2 = _mm_srai_epi32(in2, volShift);
+		}
+		_mm_storeu_si128((__m128i *)out, _mm_packs_epi32(in1, in2));
+		out += 8;
+		in += 8;
+		size -= 8;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	int32x4_t signedVolShift = vdupq_n_s32(-volShift); // Can only dynamic-shift right, but by a signed integer
+	while (size >= 8) {
+		int32x4_t in1 = vld1q_s32(in);
+		int32x4_t in2 = vld1q_s32(in + 4);
+		if (useShift) {
+			in1 = vshlq_s32(in1, signedVolShift);
+			in2 = vshlq_s32(in2, signedVolShift);
+		}
+		vst1_s16(out, vqmovn_s32(in1));
+		vst1_s16(out + 4, vqmovn_s32(in2));
+		out += 8;
+		in += 8;
+		size -= 8;
+	}
+#endif
+	// This does the remainder if SIMD was used, otherwise it does it all.
+	for (size_t i = 0; i < size; i++) {
+		out[i] = clamp_s16(useShift ? (in[i] >> volShift) : in[i]);
+	}
+}
+
+void ClampBufferToS16(s16 *out, const s32 *in, size_t size, int volShift) {
+	if (volShift == 0) {
+		ClampBufferToS16<false>(out, in, size, 0);
+	} else {
+		ClampBufferToS16<true>(out, in, size, volShift);
+	}
+}
+
+#ifdef _M_SSE
+// Full 32-bit products of signed a and unsigned b.
+static inline void MulS16U16(__m128i a, __m128i b, __m128i *lo, __m128i *hi) {
+	__m128i prodLo = _mm_mullo_epi16(a, b);
+	// mulhi_epu16 treats a as unsigned, which adds b * 65536 when a is negative.
+	__m128i prodHi = _mm_sub_epi16(_mm_mulhi_epu16(a, b), _mm_and_si128(_mm_srai_epi16(a, 15), b));
+	*lo = _mm_unpacklo_epi16(prodLo, prodHi);
+	*hi = _mm_unpackhi_epi16(prodLo, prodHi);
+}
+#endif
+
+size_t ResampleLinearStereoStandard(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio) {
+	size_t p = *pos;
+	u32 f = *frac;
+	size_t written = 0;
+
+#ifdef _M_SSE
+	const __m128i ramp = _mm_setr_epi32(0, ratio, ratio * 2, ratio * 3);
+	const __m128i fracMask = _mm_set1_epi32(0xFFFF);
+	while (written + 4 <= outFrames) {
+		// Work out where the four frames come from, and stop if we'd run out.
+		const size_t p1 = p + ((f + ratio) >> 16);
+		const size_t p2 = p + ((f + ratio * 2) >> 16);
+		const size_t p3 = p + ((f + ratio * 3) >> 16);
+		if (p3 + 1 >= inFrames)
+			break;
+
+		// Each load gets l1 r1 l2 r2 for one output frame.
+		__m128i x01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(in + p * 2)), _mm_loadl_epi64((const __m128i *)(in + p1 * 2)));
+		__m128i x23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(in + p2 * 2)), _mm_loadl_epi64((const __m128i *)(in + p3 * 2)));
+		__m128i s1 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(x01), _mm_castsi128_ps(x23), _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i s2 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(x01), _mm_castsi128_ps(x23), _MM_SHUFFLE(3, 1, 3, 1)));
+		// The same fraction for both channels of each frame.
+		__m128i fracs = _mm_and_si128(_mm_add_epi32(_mm_set1_epi32(f), ramp), fracMask);
+		fracs = _mm_or_si128(fracs, _mm_slli_epi32(fracs, 16));
+
+		// ((s1 << 16) + (s2 - s1) * frac) >> 16, which can wrap in the middle just like the scalar path.
+		__m128i p1lo, p1hi, p2lo, p2hi;
+		MulS16U16(s1, fracs, &p1lo, &p1hi);
+		MulS16U16(s2, fracs, &p2lo, &p2hi);
+		__m128i s1lo = _mm_unpacklo_epi16(_mm_setzero_si128(), s1);
+		__m128i s1hi = _mm_unpackhi_epi16(_mm_setzero_si128(), s1);
+		__m128i lo = _mm_srai_epi32(_mm_sub_epi32(_mm_add_epi32(s1lo, p2lo), p1lo), 16);
+		__m128i hi = _mm_srai_epi32(_mm_sub_epi32(_mm_add_epi32(s1hi, p2hi), p1hi), 16);
+		_mm_storeu_si128((__m128i *)(out + written * 2), _mm_packs_epi32(lo, hi));
+
+		written += 4;
+		f += ratio * 4;
+		p += f >> 16;
+		f &= 0xFFFF;
+	}
+#endif
+
+	while (written < outFrames && p + 1 < inFrames) {
+		s16 l1 = in[p * 2];
+		s16 r1 = in[p * 2 + 1];
+		s16 l2 = in[p * 2 + 2];
+		s16 r2 = in[p * 2 + 3];
+		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)f) >> 16;
+		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)f) >> 16;
+		out[written * 2] = sampleL;
+		out[written * 2 + 1] = sampleR;
+		written++;
+		f += ratio;
+		p += f >> 16;
+		f &= 0xFFFF;
+	}
+
+	*pos = p;
+	*frac = f;
+	return written;
+}
+
+struct ResampleFIR {
+	ResampleFIR() {
+		const double PI = 3.14159265358979323846;
+		// Pass a bit less than the input's Nyquist frequency, to leave room for the transition.
+		const double cutoff = 0.9;
+		const int half = RESAMPLE_FIR_TAPS / 2;
+
+		for (int phase = 0; phase < RESAMPLE_FIR_PHASES; ++phase) {
+			double t = (double)phase / RESAMPLE_FIR_PHASES;
+			double taps[RESAMPLE_FIR_TAPS];
+			double sum = 0.0;
+			for (int i = 0; i < RESAMPLE_FIR_TAPS; ++i) {
+				// Tap i is the frame at pos - (half - 1) + i.
+				double x = (i - (half - 1)) - t;
+				double sinc = x == 0.0 ? 1.0 : sin(PI * cutoff * x) / (PI * cutoff * x);
+				// Blackman window over the whole span of the filter.
+				double w = x / half;
+				double window = w <= -1.0 || w >= 1.0 ? 0.0 : 0.42 + 0.5 * cos(PI * w) + 0.08 * cos(2.0 * PI * w);
+				taps[i] = sinc * window;
+				sum += taps[i];
+			}
+
+			// Normalize so DC passes exactly, putting any rounding error on the largest tap.
+			int total = 0;
+			int largest = 0;
+			for (int i = 0; i < RESAMPLE_FIR_TAPS; ++i) {
+				coefs[phase][i] = (s16)floor(taps[i] / sum * 32768.0 + 0.5);
+				total += coefs[phase][i];
+				if (coefs[phase][i] > coefs[phase][largest])
+					largest = i;
+			}
+			coefs[phase][largest] += 32768 - total;
+		}
+	}
+
+	alignas(16) s16 coefs[RESAMPLE_FIR_PHASES][RESAMPLE_FIR_TAPS];
+};
+
+const s16 *GetResampleFIRPhase(u32 frac) {
+	static const ResampleFIR fir;
+	return fir.coefs[(frac & 0xFFFF) / (65536 / RESAMPLE_FIR_PHASES)];
+}
+
+size_t ResamplePolyphaseStereoStandard(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio) {
+	const int before = RESAMPLE_FIR_TAPS / 2 - 1;
+	const int after = RESAMPLE_FIR_TAPS / 2;
+	size_t p = *pos;
+	u32 f = *frac;
+	size_t written = 0;
+
+	while (written < outFrames && p + after < inFrames) {
+		const s16 *src = in + ((ptrdiff_t)p - before) * 2;
+		const s16 *coefs = GetResampleFIRPhase(f);
+#ifdef _M_SSE
+		__m128i acc = _mm_setzero_si128();
+		for (int i = 0; i < RESAMPLE_FIR_TAPS; i += 4) {
+			// l0 r0 l1 r1 l2 r2 l3 r3 -> l0 l1 r0 r1 l2 l3 r2 r3, so madd can sum pairs per channel.
+			__m128i x = _mm_loadu_si128((const __m128i *)(src + i * 2));
+			x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+			// c0 c1 c0 c1 c2 c3 c2 c3.
+			__m128i c = _mm_loadl_epi64((const __m128i *)(coefs + i));
+			c = _mm_unpacklo_epi32(c, c);
+			acc = _mm_add_epi32(acc, _mm_madd_epi16(x, c));
+		}
+		// Now we have L R L R, add them up.
+		acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << 14)), 15);
+		s32 lr = _mm_cvtsi128_si32(_mm_packs_epi32(acc, acc));
+		memcpy(out + written * 2, &lr, 4);
+#else
+		s32 sumL = 0;
+		s32 sumR = 0;
+		for (int i = 0; i < RESAMPLE_FIR_TAPS; ++i) {
+			sumL += src[i * 2] * coefs[i];
+			sumR += src[i * 2 + 1] * coefs[i];
+		}
+		out[written * 2] = clamp_s16((sumL + (1 << 14)) >> 15);
+		out[written * 2 + 1] = clamp_s16((sumR + (1 << 14)) >> 15);
+#endif
+		written++;
+		f += ratio;
+		p += f >> 16;
+		f &= 0xFFFF;
+	}
+
+	*pos = p;
+	*frac = f;
+	return written;
+}
+
 #if !defined(_M_SSE) && !PPSSPP_ARCH(ARM64)
 AdjustVolumeBlockFunc AdjustVolumeBlock = &AdjustVolumeBlockStandard;
+ResampleStereoFunc ResampleLinearStereo = &ResampleLinearStereoStandard;
+ResampleStereoFunc ResamplePolyphaseStereo = &ResamplePolyphaseStereoStandard;
 
 // This has to be done after CPUDetect has done its magic.
 void SetupAudioFormats() {
 #if PPSSPP_ARCH(ARM_NEON) && !PPSSPP_ARCH(ARM64)
 	if (cpu_info.bNEON) {
 		AdjustVolumeBlock = &AdjustVolumeBlockNEON;
+		ResampleLinearStereo = &ResampleLinearStereoNEON;
+		ResamplePolyphaseStereo = &ResamplePolyphaseStereoNEON;
 	}
 #endif
 }
@@ -66,15 +66,40 @@ static inline s16 ApplySampleVolume20Bit(s16 sample, int vol20) {
 	return clamp_s16((sample * (vol20 >> 4)) >> 12);
 }
 
+// The polyphase resampler reads RESAMPLE_FIR_TAPS / 2 - 1 frames before each position,
+// and RESAMPLE_FIR_TAPS / 2 after it.
+enum {
+	RESAMPLE_FIR_TAPS = 16,
+	RESAMPLE_FIR_PHASES = 128,
+};
+
 void SetupAudioFormats();
 void AdjustVolumeBlockStandard(s16 *out, s16 *in, size_t size, int leftVol, int rightVol);
 void ConvertS16ToF32(float *ou, const s16 *in, size_t size);
+// Shifts right by volShift, then saturates.
+void ClampBufferToS16(s16 *out, const s32 *in, size_t size, int volShift = 0);
+// Q15 coefficients for the phase nearest frac (0-0xFFFF), RESAMPLE_FIR_TAPS of them.
+const s16 *GetResampleFIRPhase(u32 frac);
+
+// These resample interleaved stereo from in, starting at frame *pos and *frac / 65536, stepping
+// by ratio / 65536 frames per output frame.  They stop when the next frame would need data past
+// inFrames, update pos and frac, and return how many frames were written.
+size_t ResampleLinearStereoStandard(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio);
+// Also reads the RESAMPLE_FIR_TAPS / 2 - 1 frames before in, which must be valid.
+size_t ResamplePolyphaseStereoStandard(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio);
 
 #ifdef _M_SSE
 #define AdjustVolumeBlock AdjustVolumeBlockStandard
+#define ResampleLinearStereo ResampleLinearStereoStandard
+#define ResamplePolyphaseStereo ResamplePolyphaseStereoStandard
 #elif PPSSPP_ARCH(ARM64)
 #define AdjustVolumeBlock AdjustVolumeBlockNEON
+#define ResampleLinearStereo ResampleLinearStereoNEON
+#define ResamplePolyphaseStereo ResamplePolyphaseStereoNEON
 #else
 typedef void (*AdjustVolumeBlockFunc)(s16 *out, s16 *in, size_t size, int leftVol, int rightVol);
+typedef size_t (*ResampleStereoFunc)(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio);
 extern AdjustVolumeBlockFunc AdjustVolumeBlock;
+extern ResampleStereoFunc ResampleLinearStereo;
+extern ResampleStereoFunc ResamplePolyphaseStereo;
 #endif
@@ -23,6 +23,9 @@
 #else
 #include <arm_neon.h>
 #endif
+#include <cstddef>
+#include <cstring>
+
 #include "Common/Common.h"
 #include "Core/Util/AudioFormat.h"
 #include "Core/Util/AudioFormatNEON.h"
@@ -75,4 +78,91 @@ void AdjustVolumeBlockNEON(s16 *out, s16 *in, size_t size, int leftVol, int righ
 	}
 }
 
+size_t ResampleLinearStereoNEON(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio) {
+	size_t p = *pos;
+	u32 f = *frac;
+	size_t written = 0;
+
+	const u32 rampValues[4] = { 0, ratio, ratio * 2, ratio * 3 };
+	const uint32x4_t ramp = vld1q_u32(rampValues);
+	while (written + 4 <= outFrames) {
+		// Work out where the four frames come from, and stop if we'd run out.
+		const size_t p1 = p + ((f + ratio) >> 16);
+		const size_t p2 = p + ((f + ratio * 2) >> 16);
+		const size_t p3 = p + ((f + ratio * 3) >> 16);
+		if (p3 + 1 >= inFrames)
+			break;
+
+		// Each load gets l1 r1 l2 r2 for one output frame.
+		int32x2_t x0 = vld1_s32((const int32_t *)(in + p * 2));
+		int32x2_t x1 = vld1_s32((const int32_t *)(in + p1 * 2));
+		int32x2_t x2 = vld1_s32((const int32_t *)(in + p2 * 2));
+		int32x2_t x3 = vld1_s32((const int32_t *)(in + p3 * 2));
+		int32x2x2_t x01 = vzip_s32(x0, x1);
+		int32x2x2_t x23 = vzip_s32(x2, x3);
+		int16x8_t s1 = vreinterpretq_s16_s32(vcombine_s32(x01.val[0], x23.val[0]));
+		int16x8_t s2 = vreinterpretq_s16_s32(vcombine_s32(x01.val[1], x23.val[1]));
+		// The same fraction for both channels of each frame.
+		uint32x4_t fracs = vandq_u32(vaddq_u32(vdupq_n_u32(f), ramp), vdupq_n_u32(0xFFFF));
+		uint32x4x2_t fracPairs = vzipq_u32(fracs, fracs);
+
+		// ((s1 << 16) + (s2 - s1) * frac) >> 16, wrapping in the middle just like the scalar path.
+		int32x4_t s1lo = vmovl_s16(vget_low_s16(s1));
+		int32x4_t s1hi = vmovl_s16(vget_high_s16(s1));
+		int32x4_t dlo = vsubq_s32(vmovl_s16(vget_low_s16(s2)), s1lo);
+		int32x4_t dhi = vsubq_s32(vmovl_s16(vget_high_s16(s2)), s1hi);
+		int32x4_t lo = vmlaq_s32(vshlq_n_s32(s1lo, 16), dlo, vreinterpretq_s32_u32(fracPairs.val[0]));
+		int32x4_t hi = vmlaq_s32(vshlq_n_s32(s1hi, 16), dhi, vreinterpretq_s32_u32(fracPairs.val[1]));
+		vst1q_s16(out + written * 2, vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+
+		written += 4;
+		f += ratio * 4;
+		p += f >> 16;
+		f &= 0xFFFF;
+	}
+
+	*pos = p;
+	*frac = f;
+	return written + ResampleLinearStereoStandard(out + written * 2, outFrames - written, in, inFrames, pos, frac, ratio);
+}
+
+size_t ResamplePolyphaseStereoNEON(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio) {
+	const int before = RESAMPLE_FIR_TAPS / 2 - 1;
+	const int after = RESAMPLE_FIR_TAPS / 2;
+	size_t p = *pos;
+	u32 f = *frac;
+	size_t written = 0;
+
+	while (written < outFrames && p + after < inFrames) {
+		const s16 *src = in + ((ptrdiff_t)p - before) * 2;
+		const s16 *coefs = GetResampleFIRPhase(f);
+		int32x4_t accL = vdupq_n_s32(0);
+		int32x4_t accR = vdupq_n_s32(0);
+		for (int i = 0; i < RESAMPLE_FIR_TAPS; i += 8) {
+			// Loads 8 frames, split into left and right.
+			int16x8x2_t x = vld2q_s16(src + i * 2);
+			int16x8_t c = vld1q_s16(coefs + i);
+			accL = vmlal_s16(accL, vget_low_s16(x.val[0]), vget_low_s16(c));
+			accL = vmlal_s16(accL, vget_high_s16(x.val[0]), vget_high_s16(c));
+			accR = vmlal_s16(accR, vget_low_s16(x.val[1]), vget_low_s16(c));
+			accR = vmlal_s16(accR, vget_high_s16(x.val[1]), vget_high_s16(c));
+		}
+		int32x2_t sumL = vpadd_s32(vget_low_s32(accL), vget_high_s32(accL));
+		int32x2_t sumR = vpadd_s32(vget_low_s32(accR), vget_high_s32(accR));
+		// L R L R, rounded and saturated like the C version.
+		int32x2_t lr = vpadd_s32(sumL, sumR);
+		int16x4_t result = vqrshrn_n_s32(vcombine_s32(lr, lr), 15);
+		vst1_lane_s32((int32_t *)(out + written * 2), vreinterpret_s32_s16(result), 0);
+
+		written++;
+		f += ratio;
+		p += f >> 16;
+		f &= 0xFFFF;
+	}
+
+	*pos = p;
+	*frac = f;
+	return written;
+}
+
 #endif // PPSSPP_ARCH(ARM_NEON)
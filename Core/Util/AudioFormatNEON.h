@@ -20,3 +20,5 @@
 #include "Common/CommonTypes.h"
 
 void AdjustVolumeBlockNEON(s16 *out, s16 *in, size_t size, int leftVol, int rightVol);
+size_t ResampleLinearStereoNEON(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio);
+size_t ResamplePolyphaseStereoNEON(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio);
@@ -25,6 +25,7 @@
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"
+#include "GPU/GPU.h"
 
 #define QUAD_INDICES_MAX 65536
 
@@ -32,7 +33,14 @@ enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
 
-DrawEngineCommon::DrawEngineCommon() : decoderMap_(16) {
+enum {
+	// Smaller draws are cheaper to just decode than to hash and copy.
+	DECODED_VERTEX_CACHE_MIN_VERTS = 32,
+	DECODED_VERTEX_CACHE_MAX_BYTES = 16 * 1024 * 1024,
+	DECODED_VERTEX_CACHE_MAX_ENTRIES = 8192,
+};
+
+DrawEngineCommon::DrawEngineCommon() : decoderMap_(16), decodedVertexCache_(1024) {
 	decJitCache_ = new VertexDecoderJitCache();
 	transformed = (TransformedVertex *)AllocateMemoryPages(TRANSFORMED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
 	transformedExpanded = (TransformedVertex *)AllocateMemoryPages(3 * TRANSFORMED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
@@ -48,6 +56,7 @@ DrawEngineCommon::~DrawEngineCommon() {
 		delete decoder;
 	});
 	ClearSplineBezierWeights();
+	ClearDecodedVertexCache();
 }
 
 VertexDecoder *DrawEngineCommon::GetVertexDecoder(u32 vtype) {
@@ -172,6 +181,7 @@ void DrawEngineCommon::Resized() {
 	});
 	decoderMap_.Clear();
 	ClearTrackedVertexArrays();
+	ClearDecodedVertexCache();
 
 	useHWTransform_ = g_Config.bHardwareTransform;
 	useHWTessellation_ = UpdateUseHWTessellation(g_Config.bHardwareTessellation);
@@ -521,7 +531,7 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 	void *inds = dc.inds;
 	if (dc.indexType == GE_VTYPE_IDX_NONE >> GE_VTYPE_IDX_SHIFT) {
 		// Decode the verts and apply morphing. Simple.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
+		DecodeVertsCached(dec_, dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
 			dc.verts, indexLowerBound, indexUpperBound);
 		decodedVerts += indexUpperBound - indexLowerBound + 1;
 		
@@ -588,7 +598,7 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 		}
 
 		// 3. Decode that range of vertex data.
-		dec_->DecodeVerts(dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
+		DecodeVertsCached(dec_, dest + decodedVerts * (int)dec_->GetDecVtxFmt().stride,
 			dc.verts, indexLowerBound, indexUpperBound);
 		decodedVerts += vertexCount;
 
@@ -598,6 +608,140 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 	}
 }
 
+// The decoders fold each vertex into these, so cached results must do the same.
+static void MergeDecodedVertexState(bool fullAlpha, const KnownVertexBounds &bounds) {
+	gstate_c.vertexFullAlpha = gstate_c.vertexFullAlpha && fullAlpha;
+	gstate_c.vertBounds.minU = std::min(gstate_c.vertBounds.minU, bounds.minU);
+	gstate_c.vertBounds.minV = std::min(gstate_c.vertBounds.minV, bounds.minV);
+	gstate_c.vertBounds.maxU = std::max(gstate_c.vertBounds.maxU, bounds.maxU);
+	gstate_c.vertBounds.maxV = std::max(gstate_c.vertBounds.maxV, bounds.maxV);
+}
+
+void DrawEngineCommon::DecodeVertsCached(VertexDecoder *dec, u8 *dest, const void *verts, int indexLowerBound, int indexUpperBound) {
+	const u32 vertType = dec->VertexType();
+	const int count = indexUpperBound - indexLowerBound + 1;
+	// Morphing and skinning depend on state outside the vertex data, so never cache those.
+	if (!g_Config.bVertexCache || count < DECODED_VERTEX_CACHE_MIN_VERTS || (vertType & (GE_VTYPE_MORPHCOUNT_MASK | GE_VTYPE_WEIGHT_MASK)) != 0) {
+		dec->DecodeVerts(dest, verts, indexLowerBound, indexUpperBound);
+		return;
+	}
+
+	DecodedVertexCacheKey key;
+	key.verts = verts;
+	// The decoder's type includes the UV gen mode, see GetVertTypeID().
+	key.vertTypeID = vertType;
+	key.indexLowerBound = indexLowerBound;
+	key.indexUpperBound = indexUpperBound;
+	key.uvScale = gstate_c.uv;
+
+	const u32 size = count * dec->GetDecVtxFmt().stride;
+	const u8 *src = (const u8 *)verts + indexLowerBound * dec->VertexSize();
+	const u64 hash = XXH3_64bits(src, count * dec->VertexSize());
+
+	DecodedVertexCacheEntry *entry = decodedVertexCache_.Get(key);
+	if (entry) {
+		TouchDecodedVertexCacheEntry(entry);
+		if (entry->hash == hash && entry->data && entry->size == size) {
+			memcpy(dest, entry->data, size);
+			MergeDecodedVertexState(entry->fullAlpha, entry->bounds);
+			gpuStats.numDecodedVertexCacheHits++;
+			return;
+		}
+	} else {
+		if (decodedVertexCache_.size() >= DECODED_VERTEX_CACHE_MAX_ENTRIES) {
+			RemoveDecodedVertexCacheEntry(decodedVertexCacheOldest_);
+		}
+		entry = new DecodedVertexCacheEntry{ key, hash ^ 1, nullptr, 0, true, {}, nullptr, nullptr };
+		decodedVertexCache_.Insert(key, entry);
+		TouchDecodedVertexCacheEntry(entry);
+	}
+
+	// Decode from a clean state to see what this range alone contributes.
+	const bool prevFullAlpha = gstate_c.vertexFullAlpha;
+	const KnownVertexBounds prevBounds = gstate_c.vertBounds;
+	gstate_c.vertexFullAlpha = true;
+	gstate_c.vertBounds.minU = 0xFFFF;
+	gstate_c.vertBounds.minV = 0xFFFF;
+	gstate_c.vertBounds.maxU = 0;
+	gstate_c.vertBounds.maxV = 0;
+	dec->DecodeVerts(dest, verts, indexLowerBound, indexUpperBound);
+	entry->fullAlpha = gstate_c.vertexFullAlpha;
+	entry->bounds = gstate_c.vertBounds;
+	gstate_c.vertexFullAlpha = prevFullAlpha;
+	gstate_c.vertBounds = prevBounds;
+	MergeDecodedVertexState(entry->fullAlpha, entry->bounds);
+	gpuStats.numDecodedVertexCacheMisses++;
+
+	if (entry->hash == hash) {
+		// Second time we see this data unchanged, keep the result.
+		entry->data = new u8[size];
+		entry->size = size;
+		memcpy(entry->data, dest, size);
+		decodedVertexCacheBytes_ += size;
+		while (decodedVertexCacheBytes_ > DECODED_VERTEX_CACHE_MAX_BYTES && decodedVertexCacheOldest_ != entry) {
+			RemoveDecodedVertexCacheEntry(decodedVertexCacheOldest_);
+		}
+	} else {
+		if (entry->data) {
+			delete[] entry->data;
+			entry->data = nullptr;
+			decodedVertexCacheBytes_ -= entry->size;
+			entry->size = 0;
+		}
+		entry->hash = hash;
+	}
+	gpuStats.decodedVertexCacheBytes = (int)decodedVertexCacheBytes_;
+}
+
+void DrawEngineCommon::TouchDecodedVertexCacheEntry(DecodedVertexCacheEntry *entry) {
+	if (entry == decodedVertexCacheNewest_)
+		return;
+
+	// Unlink, if linked.
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	if (entry == decodedVertexCacheOldest_)
+		decodedVertexCacheOldest_ = entry->prev;
+
+	entry->prev = nullptr;
+	entry->next = decodedVertexCacheNewest_;
+	if (decodedVertexCacheNewest_)
+		decodedVertexCacheNewest_->prev = entry;
+	decodedVertexCacheNewest_ = entry;
+	if (!decodedVertexCacheOldest_)
+		decodedVertexCacheOldest_ = entry;
+}
+
+void DrawEngineCommon::RemoveDecodedVertexCacheEntry(DecodedVertexCacheEntry *entry) {
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		decodedVertexCacheNewest_ = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		decodedVertexCacheOldest_ = entry->prev;
+
+	decodedVertexCache_.Remove(entry->key);
+	decodedVertexCacheBytes_ -= entry->size;
+	delete[] entry->data;
+	delete entry;
+}
+
+void DrawEngineCommon::ClearDecodedVertexCache() {
+	decodedVertexCache_.Iterate([&](const DecodedVertexCacheKey &key, DecodedVertexCacheEntry *entry) {
+		delete[] entry->data;
+		delete entry;
+	});
+	decodedVertexCache_.Clear();
+	decodedVertexCacheNewest_ = nullptr;
+	decodedVertexCacheOldest_ = nullptr;
+	decodedVertexCacheBytes_ = 0;
+	gpuStats.decodedVertexCacheBytes = 0;
+}
+
 inline u32 ComputeMiniHashRange(const void *ptr, size_t sz) {
 	// Switch to u32 units.
 	const u32 *p = (const u32 *)ptr;
@@ -681,7 +825,12 @@ uint64_t DrawEngineCommon::ComputeHash() {
 
 // vertTypeID is the vertex type but with the UVGen mode smashed into the top bits.
 void DrawEngineCommon::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim, int vertexCount, u32 vertTypeID, int cullMode, int *bytesRead) {
-	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
+	if (!indexGen.PrimCompatible(prevPrim_, prim)) {
+		if (numDrawCalls)
+			gpuStats.numFlushesPrimChange++;
+		DispatchFlush();
+	} else if (numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
+		gpuStats.numFlushesBufferFull++;
 		DispatchFlush();
 	}
 
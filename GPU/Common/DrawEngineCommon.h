@@ -95,6 +95,10 @@ class DrawEngineCommon {
 
 	VertexDecoder *GetVertexDecoder(u32 vtype);
 
+	// Like dec->DecodeVerts(), but reuses the result of an earlier decode of the same unchanged data.
+	void DecodeVertsCached(VertexDecoder *dec, u8 *dest, const void *verts, int indexLowerBound, int indexUpperBound);
+	void ClearDecodedVertexCache();
+
 protected:
 	virtual bool UpdateUseHWTessellation(bool enabled) { return enabled; }
 	virtual void ClearTrackedVertexArrays() {}
@@ -174,4 +178,36 @@ class DrawEngineCommon {
 
 	// Hardware tessellation
 	TessellationDataTransfer *tessDataTransfer;
+
+private:
+	// Decoded vertex cache, used by every backend (and the software renderer) whenever vertices
+	// get decoded. The source data is hashed on every use, so no invalidation is needed.
+	struct DecodedVertexCacheKey {
+		const void *verts;
+		u32 vertTypeID;
+		u16 indexLowerBound;
+		u16 indexUpperBound;
+		UVScale uvScale;
+	};
+	struct DecodedVertexCacheEntry {
+		DecodedVertexCacheKey key;
+		u64 hash;
+		// Only filled in once the same data has been seen twice, to not waste time on dynamic vertices.
+		u8 *data;
+		u32 size;
+		// What the decoder contributed to gstate_c, repeated on hits.
+		bool fullAlpha;
+		KnownVertexBounds bounds;
+		// Least recently used order, newest first.
+		DecodedVertexCacheEntry *prev;
+		DecodedVertexCacheEntry *next;
+	};
+
+	void TouchDecodedVertexCacheEntry(DecodedVertexCacheEntry *entry);
+	void RemoveDecodedVertexCacheEntry(DecodedVertexCacheEntry *entry);
+
+	DenseHashMap<DecodedVertexCacheKey, DecodedVertexCacheEntry *, nullptr> decodedVertexCache_;
+	DecodedVertexCacheEntry *decodedVertexCacheNewest_ = nullptr;
+	DecodedVertexCacheEntry *decodedVertexCacheOldest_ = nullptr;
+	size_t decodedVertexCacheBytes_ = 0;
 };
@@ -1266,13 +1266,13 @@ static void ReverseColors(void *dstBuf, const void *srcBuf, GETextureFormat fmt,
 static inline void ConvertFormatToRGBA8888(GETextureFormat format, u32 *dst, const u16 *src, u32 numPixels) {
 	switch (format) {
 	case GE_TFMT_4444:
-		ConvertRGBA4444ToRGBA8888(dst, src, numPixels);
+		texDecoderFuncs.convert4444To8888(dst, src, numPixels);
 		break;
 	case GE_TFMT_5551:
-		ConvertRGBA5551ToRGBA8888(dst, src, numPixels);
+		texDecoderFuncs.convert5551To8888(dst, src, numPixels);
 		break;
 	case GE_TFMT_5650:
-		ConvertRGB565ToRGBA8888(dst, src, numPixels);
+		texDecoderFuncs.convert565To8888(dst, src, numPixels);
 		break;
 	default:
 		_dbg_assert_msg_(false, "Incorrect texture format.");
@@ -1307,6 +1307,23 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		const bool mipmapShareClut = gstate.isClutSharedForMipmaps();
 		const int clutSharingOffset = mipmapShareClut ? 0 : level * 16;
 
+		if (swizzled && w <= bufw && gstate.isClutIndexSimple() && !(clutAlphaLinear_ && mipmapShareClut && !expandTo32bit)) {
+			// Common case, we can skip the temp buffer.
+			if (clutformat == GE_CMODE_32BIT_ABGR8888) {
+				UnswizzleDeIndexTexture4((u32 *)out, outPitch / 4, texptr, bufw, w, h, GetCurrentClut<u32>() + clutSharingOffset);
+				break;
+			} else if (clutformat == GE_CMODE_16BIT_BGR5650 || clutformat == GE_CMODE_16BIT_ABGR5551 || clutformat == GE_CMODE_16BIT_ABGR4444) {
+				const u16 *clut = GetCurrentClut<u16>() + clutSharingOffset;
+				if (expandTo32bit && !reverseColors) {
+					ConvertFormatToRGBA8888(clutformat, expandClut_, clut, 16);
+					UnswizzleDeIndexTexture4((u32 *)out, outPitch / 4, texptr, bufw, w, h, expandClut_);
+				} else {
+					UnswizzleDeIndexTexture4((u16 *)out, outPitch / 2, texptr, bufw, w, h, clut);
+				}
+				break;
+			}
+		}
+
 		if (swizzled) {
 			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
 			UnswizzleFromMem(tmpTexBuf32_.data(), bufw / 2, texptr, bufw, h, 0);
@@ -1530,12 +1547,6 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 	int w = gstate.getTextureWidth(level);
 	int h = gstate.getTextureHeight(level);
 
-	if (gstate.isTextureSwizzled()) {
-		tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-		UnswizzleFromMem(tmpTexBuf32_.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
-		texptr = (u8 *)tmpTexBuf32_.data();
-	}
-
 	int palFormat = gstate.getClutPaletteFormat();
 
 	const u16 *clut16 = (const u16 *)clutBuf_;
@@ -1547,6 +1558,23 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 		palFormat = GE_CMODE_32BIT_ABGR8888;
 	}
 
+	if (gstate.isTextureSwizzled() && bytesPerIndex == 1 && w <= bufw && gstate.isClutIndexSimple()) {
+		// Common case, we can skip the temp buffer.
+		if (palFormat == GE_CMODE_32BIT_ABGR8888) {
+			UnswizzleDeIndexTexture8((u32 *)out, outPitch / 4, texptr, bufw, w, h, clut32);
+			return;
+		} else if (palFormat == GE_CMODE_16BIT_BGR5650 || palFormat == GE_CMODE_16BIT_ABGR5551 || palFormat == GE_CMODE_16BIT_ABGR4444) {
+			UnswizzleDeIndexTexture8((u16 *)out, outPitch / 2, texptr, bufw, w, h, clut16);
+			return;
+		}
+	}
+
+	if (gstate.isTextureSwizzled()) {
+		tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
+		UnswizzleFromMem(tmpTexBuf32_.data(), bufw * bytesPerIndex, texptr, bufw, h, bytesPerIndex);
+		texptr = (u8 *)tmpTexBuf32_.data();
+	}
+
 	switch (palFormat) {
 	case GE_CMODE_16BIT_BGR5650:
 	case GE_CMODE_16BIT_ABGR5551:
@@ -1635,6 +1663,7 @@ void TextureCacheCommon::ApplyTexture() {
 			// Update the hash on the texture.
 			int w = gstate.getTextureWidth(0);
 			int h = gstate.getTextureHeight(0);
+			entry->fullhashDirtyStamp = Memory::GetDirtyStamp();
 			entry->fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 
 			// TODO: Here we could check the secondary cache; maybe the texture is in there?
@@ -1700,13 +1729,21 @@ void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
-	u32 fullhash;
-	{
+	u64 fullhash;
+	u64 dirtyStamp = Memory::GetDirtyStamp();
+	// Replacement hashes may cover a different range, so always hash those.
+	const u32 sizeInRAM = (textureBitsPerPixel[entry->format] * entry->bufw * h) / 8;
+	if (g_Config.bTextureDirtyPageTracking && !replacer_.Enabled() && !Memory::IsDirtySince(entry->addr, sizeInRAM, entry->fullhashDirtyStamp)) {
+		// Nothing we know of wrote there since the last hash.
+		gpuStats.numTextureHashesSkipped++;
+		fullhash = entry->fullhash;
+	} else {
 		PROFILE_THIS_SCOPE("texhash");
 		fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 	}
 
 	if (fullhash == entry->fullhash) {
+		entry->fullhashDirtyStamp = dirtyStamp;
 		if (g_Config.bTextureBackoffCache) {
 			if (entry->GetHashStatus() != TexCacheEntry::STATUS_HASHING && entry->numFrames > TexCacheEntry::FRAMES_REGAIN_TRUST) {
 				// Reset to STATUS_HASHING.
@@ -1729,7 +1766,7 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 		// In that case, skip.
 		if (entry->numInvalidated > 2 && entry->numInvalidated < 128 && !lowMemoryMode_) {
 			// We have a new hash: look for that hash in the secondary cache.
-			u64 secondKey = fullhash | (u64)entry->cluthash << 32;
+			u64 secondKey = fullhash ^ ((u64)entry->cluthash << 32);
 			TexCache::iterator secondIter = secondCache_.find(secondKey);
 			if (secondIter != secondCache_.end()) {
 				// Found it, but does it match our current params?  If not, abort.
@@ -1741,13 +1778,14 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 					}
 
 					// Now just use our archived texture, instead of entry.
+					secondEntry->fullhashDirtyStamp = dirtyStamp;
 					nextTexture_ = secondEntry;
 					return true;
 				}
 			} else {
 				// It wasn't found, so we're about to throw away the entry and rebuild a texture.
 				// Let's save this in the secondary cache in case it gets used again.
-				secondKey = entry->fullhash | ((u64)entry->cluthash << 32);
+				secondKey = entry->fullhash ^ ((u64)entry->cluthash << 32);
 				secondCacheSizeEstimate_ += EstimateTexMemoryUsage(entry);
 
 				// If the entry already exists in the secondary texture cache, drop it nicely.
@@ -1769,6 +1807,7 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 
 	// We know it failed, so update the full hash right away.
 	entry->fullhash = fullhash;
+	entry->fullhashDirtyStamp = dirtyStamp;
 	return false;
 }
 
@@ -163,7 +163,10 @@ struct TexCacheEntry {
 	int numFrames;
 	int numInvalidated;
 	u32 framesUntilNextFullHash;
-	u32 fullhash;
+	// Only 32 bits are used when texture replacement is enabled, to match the filenames.
+	u64 fullhash;
+	// Memory::GetDirtyStamp() from when fullhash was computed.
+	u64 fullhashDirtyStamp;
 	u32 cluthash;
 	u16 maxSeenV;
 
@@ -303,7 +306,7 @@ class TextureCacheCommon {
 
 	void DecimateVideos();
 
-	inline u32 QuickTexHash(TextureReplacer &replacer, u32 addr, int bufw, int w, int h, GETextureFormat format, TexCacheEntry *entry) const {
+	inline u64 QuickTexHash(TextureReplacer &replacer, u32 addr, int bufw, int w, int h, GETextureFormat format, TexCacheEntry *entry) const {
 		if (replacer.Enabled()) {
 			return replacer.ComputeHash(addr, bufw, w, h, format, entry->maxSeenV);
 		}
@@ -318,7 +321,7 @@ class TextureCacheCommon {
 		gpuStats.numTextureDataBytesHashed += sizeInRAM;
 
 		if (Memory::IsValidAddress(addr + sizeInRAM)) {
-			return DoQuickTexHash(checkp, sizeInRAM);
+			return DoQuickTexHash64(checkp, sizeInRAM);
 		} else {
 			return 0;
 		}
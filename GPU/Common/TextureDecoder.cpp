@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+
 #include "ext/xxhash.h"
 #include "Common/CPUDetect.h"
 #include "Common/ColorConv.h"
@@ -24,6 +26,8 @@
 #include "GPU/Common/TextureDecoder.h"
 // NEON is in a separate file so that it can be compiled with a runtime check.
 #include "GPU/Common/TextureDecoderNEON.h"
+// Same for the SSE4.1 / AVX2 kernels.
+#include "GPU/Common/TextureDecoderX86.h"
 
 // TODO: Move some common things into here.
 
@@ -313,6 +317,183 @@ QuickTexHashFunc StableQuickTexHash = &QuickTexHashNonSSE;
 UnswizzleTex16Func DoUnswizzleTex16 = &DoUnswizzleTex16Basic;
 #endif
 
+void DeIndexTexture4To16Basic(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	for (int i = 0; i < length; i += 2) {
+		u8 index = *indexed++;
+		dest[i + 0] = clut[(index >> 0) & 0xf];
+		dest[i + 1] = clut[(index >> 4) & 0xf];
+	}
+}
+
+void DeIndexTexture4To32Basic(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	for (int i = 0; i < length; i += 2) {
+		u8 index = *indexed++;
+		dest[i + 0] = clut[(index >> 0) & 0xf];
+		dest[i + 1] = clut[(index >> 4) & 0xf];
+	}
+}
+
+void DeIndexTexture8To16Basic(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	for (int i = 0; i < length; ++i) {
+		dest[i] = clut[indexed[i]];
+	}
+}
+
+void DeIndexTexture8To32Basic(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	for (int i = 0; i < length; ++i) {
+		dest[i] = clut[indexed[i]];
+	}
+}
+
+TextureDecoderFuncs texDecoderFuncs = {
+	TextureDecoderLevel::BASIC,
+	&DeIndexTexture4To16Basic,
+	&DeIndexTexture4To32Basic,
+	&DeIndexTexture8To16Basic,
+	&DeIndexTexture8To32Basic,
+	&ConvertRGBA4444ToRGBA8888,
+	&ConvertRGBA5551ToRGBA8888,
+	&ConvertRGB565ToRGBA8888,
+};
+
+bool GetTextureDecoderFuncs(TextureDecoderLevel level, TextureDecoderFuncs *funcs) {
+	TextureDecoderFuncs f = {
+		TextureDecoderLevel::BASIC,
+		&DeIndexTexture4To16Basic,
+		&DeIndexTexture4To32Basic,
+		&DeIndexTexture8To16Basic,
+		&DeIndexTexture8To32Basic,
+		&ConvertRGBA4444ToRGBA8888,
+		&ConvertRGBA5551ToRGBA8888,
+		&ConvertRGB565ToRGBA8888,
+	};
+
+	switch (level) {
+	case TextureDecoderLevel::BASIC:
+		break;
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	case TextureDecoderLevel::AVX2:
+		if (!cpu_info.bAVX2 || !cpu_info.bSSE4_1 || !cpu_info.bSSSE3)
+			return false;
+		f.deIndex4To16 = &DeIndexTexture4To16AVX2;
+		f.deIndex4To32 = &DeIndexTexture4To32AVX2;
+		f.deIndex8To32 = &DeIndexTexture8To32AVX2;
+		f.convert4444To8888 = &ConvertRGBA4444ToRGBA8888AVX2;
+		f.convert5551To8888 = &ConvertRGBA5551ToRGBA8888AVX2;
+		f.convert565To8888 = &ConvertRGB565ToRGBA8888AVX2;
+		break;
+
+	case TextureDecoderLevel::SSE4_1:
+		if (!cpu_info.bSSE4_1 || !cpu_info.bSSSE3)
+			return false;
+		f.deIndex4To16 = &DeIndexTexture4To16SSE4;
+		f.deIndex4To32 = &DeIndexTexture4To32SSE4;
+		break;
+#endif
+
+	default:
+		return false;
+	}
+
+	f.level = level;
+	*funcs = f;
+	return true;
+}
+
+const char *TextureDecoderLevelName(TextureDecoderLevel level) {
+	switch (level) {
+	case TextureDecoderLevel::BASIC: return "Basic";
+	case TextureDecoderLevel::SSE4_1: return "SSE4.1";
+	case TextureDecoderLevel::AVX2: return "AVX2";
+	default: return "N/A";
+	}
+}
+
+const u64 quickTexHash64Keys[8] = {
+	0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL,
+	0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL, 0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+};
+
+static inline void QuickTexHash64Block(u64 acc[8], const u8 *p) {
+	for (int j = 0; j < 8; ++j) {
+		u64 data;
+		memcpy(&data, p + j * 8, sizeof(data));
+		const u64 keyed = data ^ quickTexHash64Keys[j];
+		acc[j] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+		// Adding the data to the neighbor keeps a zero multiply from losing it.
+		acc[j ^ 1] += data;
+	}
+}
+
+u64 QuickTexHash64Finish(u64 acc[8], const u8 *tail, u32 size) {
+	if (size & 63) {
+		u8 block[64]{};
+		memcpy(block, tail, size & 63);
+		QuickTexHash64Block(acc, block);
+	}
+
+	u64 hash = size * 0x9E3779B185EBCA87ULL;
+	for (int j = 0; j < 8; ++j) {
+		hash ^= acc[j] + quickTexHash64Keys[7 - j];
+		hash *= 0xC2B2AE3D27D4EB4FULL;
+		hash ^= hash >> 31;
+	}
+	hash ^= hash >> 37;
+	hash *= 0x165667919E3779F9ULL;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+u64 QuickTexHash64Basic(const void *checkp, u32 size) {
+	u64 acc[8]{};
+	const u8 *p = (const u8 *)checkp;
+	for (u32 i = 0; i < size / 64; ++i) {
+		QuickTexHash64Block(acc, p);
+		p += 64;
+	}
+	return QuickTexHash64Finish(acc, p, size);
+}
+
+#ifdef _M_SSE
+static inline __m128i QuickTexHash64Accumulate(__m128i acc, __m128i data, __m128i keys) {
+	const __m128i keyed = _mm_xor_si128(data, keys);
+	acc = _mm_add_epi64(acc, _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32)));
+	return _mm_add_epi64(acc, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+u64 QuickTexHash64SSE2(const void *checkp, u32 size) {
+	const __m128i *p = (const __m128i *)checkp;
+	const __m128i keys0 = _mm_loadu_si128((const __m128i *)&quickTexHash64Keys[0]);
+	const __m128i keys1 = _mm_loadu_si128((const __m128i *)&quickTexHash64Keys[2]);
+	const __m128i keys2 = _mm_loadu_si128((const __m128i *)&quickTexHash64Keys[4]);
+	const __m128i keys3 = _mm_loadu_si128((const __m128i *)&quickTexHash64Keys[6]);
+	__m128i acc0 = _mm_setzero_si128();
+	__m128i acc1 = _mm_setzero_si128();
+	__m128i acc2 = _mm_setzero_si128();
+	__m128i acc3 = _mm_setzero_si128();
+
+	for (u32 i = 0; i < size / 64; ++i) {
+		acc0 = QuickTexHash64Accumulate(acc0, _mm_loadu_si128(p + 0), keys0);
+		acc1 = QuickTexHash64Accumulate(acc1, _mm_loadu_si128(p + 1), keys1);
+		acc2 = QuickTexHash64Accumulate(acc2, _mm_loadu_si128(p + 2), keys2);
+		acc3 = QuickTexHash64Accumulate(acc3, _mm_loadu_si128(p + 3), keys3);
+		p += 4;
+	}
+
+	u64 result[8];
+	_mm_storeu_si128((__m128i *)&result[0], acc0);
+	_mm_storeu_si128((__m128i *)&result[2], acc1);
+	_mm_storeu_si128((__m128i *)&result[4], acc2);
+	_mm_storeu_si128((__m128i *)&result[6], acc3);
+	return QuickTexHash64Finish(result, (const u8 *)p, size);
+}
+
+QuickTexHash64Func DoQuickTexHash64 = &QuickTexHash64SSE2;
+#else
+QuickTexHash64Func DoQuickTexHash64 = &QuickTexHash64Basic;
+#endif
+
 // This has to be done after CPUDetect has done its magic.
 void SetupTextureDecoder() {
 #if PPSSPP_ARCH(ARM_NEON) && !PPSSPP_ARCH(ARM64)
@@ -322,6 +503,64 @@ void SetupTextureDecoder() {
 		DoUnswizzleTex16 = &DoUnswizzleTex16NEON;
 	}
 #endif
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	if (cpu_info.bAVX2) {
+		DoQuickTexHash64 = &QuickTexHash64AVX2;
+	}
+#endif
+
+	// Pick the best level available.
+	for (int i = (int)TextureDecoderLevel::COUNT - 1; i >= 0; --i) {
+		if (GetTextureDecoderFuncs((TextureDecoderLevel)i, &texDecoderFuncs))
+			break;
+	}
+}
+
+// Swizzled textures are stored as blocks of 16 bytes by 8 rows, see UnswizzleFromMem().
+// Each 16 byte block row is deindexed straight into place.
+template <typename ClutT, typename Func>
+static void UnswizzleDeIndex(ClutT *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const ClutT *clut, int pixelsPerRow, Func func) {
+	const int rowBytes = pixelsPerRow == 32 ? bufw / 2 : bufw;
+	const int bxc = rowBytes / 16;
+	const int byc = (h + 7) / 8;
+
+	const u8 *src = texptr;
+	for (int by = 0; by < byc; by++) {
+		const int rows = std::min(8, h - by * 8);
+		ClutT *ydest = dest + by * 8 * destPitch;
+		for (int bx = 0; bx < bxc; bx++) {
+			const int x = bx * pixelsPerRow;
+			if (x >= w) {
+				// The rest of this block row is outside the texture, skip it.
+				src += 128 * (bxc - bx);
+				break;
+			}
+			const int pixels = std::min(pixelsPerRow, w - x);
+			ClutT *xdest = ydest + x;
+			for (int n = 0; n < rows; n++) {
+				func(xdest, src + n * 16, pixels, clut);
+				xdest += destPitch;
+			}
+			src += 128;
+		}
+	}
+}
+
+void UnswizzleDeIndexTexture4(u16 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u16 *clut) {
+	UnswizzleDeIndex(dest, destPitch, texptr, bufw, w, h, clut, 32, texDecoderFuncs.deIndex4To16);
+}
+
+void UnswizzleDeIndexTexture4(u32 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u32 *clut) {
+	UnswizzleDeIndex(dest, destPitch, texptr, bufw, w, h, clut, 32, texDecoderFuncs.deIndex4To32);
+}
+
+void UnswizzleDeIndexTexture8(u16 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u16 *clut) {
+	UnswizzleDeIndex(dest, destPitch, texptr, bufw, w, h, clut, 16, texDecoderFuncs.deIndex8To16);
+}
+
+void UnswizzleDeIndexTexture8(u32 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u32 *clut) {
+	UnswizzleDeIndex(dest, destPitch, texptr, bufw, w, h, clut, 16, texDecoderFuncs.deIndex8To32);
 }
 
 // S3TC / DXT Decoder
@@ -449,6 +688,7 @@ void DXTDecoder::WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int
 }
 
 // This could probably be done faster by decoding two or four blocks at a time with SSE/NEON.
+// Just doing a block row per pshufb didn't help: the time goes into building the palette, not the writes.
 void DecodeDXT1Block(u32 *dst, const DXT1Block *src, int pitch, int height, bool ignore1bitAlpha) {
 	DXTDecoder dxt;
 	dxt.DecodeColors(src, ignore1bitAlpha);
@@ -25,6 +25,7 @@ enum CheckAlphaResult {
 
 #include "ppsspp_config.h"
 #include "Common/Common.h"
+#include "Common/ColorConv.h"
 #include "Common/Swap.h"
 #include "Core/MemMap.h"
 #include "GPU/ge_constants.h"
@@ -60,6 +61,17 @@ typedef void (*UnswizzleTex16Func)(const u8 *texptr, u32 *ydestp, int bxc, int b
 extern UnswizzleTex16Func DoUnswizzleTex16;
 #endif
 
+// 64-bit hash used by the texture cache to detect changes, much less likely to collide than
+// the 32-bit QuickTexHash. Each 64-bit lane uses the XXH3 accumulate step (a 32x32->64 multiply),
+// and all versions give the same result, so it's safe to switch between them.
+typedef u64 (*QuickTexHash64Func)(const void *checkp, u32 size);
+extern QuickTexHash64Func DoQuickTexHash64;
+u64 QuickTexHash64Basic(const void *checkp, u32 size);
+
+// Shared with the SIMD versions, which only handle whole 64 byte blocks.
+extern const u64 quickTexHash64Keys[8];
+u64 QuickTexHash64Finish(u64 acc[8], const u8 *tail, u32 size);
+
 CheckAlphaResult CheckAlphaRGBA8888Basic(const u32 *pixelData, int stride, int w, int h);
 CheckAlphaResult CheckAlphaABGR4444Basic(const u32 *pixelData, int stride, int w, int h);
 CheckAlphaResult CheckAlphaRGBA4444Basic(const u32 *pixelData, int stride, int w, int h);
@@ -91,6 +103,49 @@ void DecodeDXT1Block(u32 *dst, const DXT1Block *src, int pitch, int height, bool
 void DecodeDXT3Block(u32 *dst, const DXT3Block *src, int pitch, int height);
 void DecodeDXT5Block(u32 *dst, const DXT5Block *src, int pitch, int height);
 
+// These assume a naked index (see gstate.isClutIndexSimple().)
+// Like the rest of the CLUT4 paths, the 4-bit versions always write an even number of pixels.
+void DeIndexTexture4To16Basic(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+void DeIndexTexture4To32Basic(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+void DeIndexTexture8To16Basic(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+void DeIndexTexture8To32Basic(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+
+enum class TextureDecoderLevel {
+	BASIC,
+	SSE4_1,
+	AVX2,
+	COUNT,
+};
+
+typedef void (*DeIndexTo16Func)(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+typedef void (*DeIndexTo32Func)(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+
+// All functions in a set produce bit-identical output, only the speed differs.
+struct TextureDecoderFuncs {
+	TextureDecoderLevel level;
+	DeIndexTo16Func deIndex4To16;
+	DeIndexTo32Func deIndex4To32;
+	DeIndexTo16Func deIndex8To16;
+	DeIndexTo32Func deIndex8To32;
+	Convert16bppTo32bppFunc convert4444To8888;
+	Convert16bppTo32bppFunc convert5551To8888;
+	Convert16bppTo32bppFunc convert565To8888;
+};
+
+// Filled in by SetupTextureDecoder() with the best set the CPU supports.
+extern TextureDecoderFuncs texDecoderFuncs;
+
+// Returns false if the CPU doesn't support the level.  Mainly for tests and benchmarks.
+bool GetTextureDecoderFuncs(TextureDecoderLevel level, TextureDecoderFuncs *funcs);
+const char *TextureDecoderLevelName(TextureDecoderLevel level);
+
+// Unswizzle and deindex in one pass, without going through a temp buffer.
+// Assumes a naked index, and that w <= bufw.  destPitch is in pixels.
+void UnswizzleDeIndexTexture4(u16 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u16 *clut);
+void UnswizzleDeIndexTexture4(u32 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u32 *clut);
+void UnswizzleDeIndexTexture8(u16 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u16 *clut);
+void UnswizzleDeIndexTexture8(u32 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u32 *clut);
+
 static const u8 textureBitsPerPixel[16] = {
 	16,  //GE_TFMT_5650,
 	16,  //GE_TFMT_5551,
@@ -112,6 +167,22 @@ static const u8 textureBitsPerPixel[16] = {
 
 u32 GetTextureBufw(int level, u32 texaddr, GETextureFormat format);
 
+inline void DeIndexTexture8Naked(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	texDecoderFuncs.deIndex8To16(dest, indexed, length, clut);
+}
+
+inline void DeIndexTexture8Naked(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	texDecoderFuncs.deIndex8To32(dest, indexed, length, clut);
+}
+
+inline void DeIndexTexture4Naked(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	texDecoderFuncs.deIndex4To16(dest, indexed, length, clut);
+}
+
+inline void DeIndexTexture4Naked(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	texDecoderFuncs.deIndex4To32(dest, indexed, length, clut);
+}
+
 template <typename IndexT, typename ClutT>
 inline void DeIndexTexture(ClutT *dest, const IndexT *indexed, int length, const ClutT *clut) {
 	// Usually, there is no special offset, mask, or shift.
@@ -119,9 +190,7 @@ inline void DeIndexTexture(ClutT *dest, const IndexT *indexed, int length, const
 
 	if (nakedIndex) {
 		if (sizeof(IndexT) == 1) {
-			for (int i = 0; i < length; ++i) {
-				*dest++ = clut[*indexed++];
-			}
+			DeIndexTexture8Naked(dest, (const u8 *)indexed, length, clut);
 		} else {
 			for (int i = 0; i < length; ++i) {
 				*dest++ = clut[(*indexed++) & 0xFF];
@@ -146,11 +215,7 @@ inline void DeIndexTexture4(ClutT *dest, const u8 *indexed, int length, const Cl
 	const bool nakedIndex = gstate.isClutIndexSimple();
 
 	if (nakedIndex) {
-		for (int i = 0; i < length; i += 2) {
-			u8 index = *indexed++;
-			dest[i + 0] = clut[(index >> 0) & 0xf];
-			dest[i + 1] = clut[(index >> 4) & 0xf];
-		}
+		DeIndexTexture4Naked(dest, indexed, length, clut);
 	} else {
 		for (int i = 0; i < length; i += 2) {
 			u8 index = *indexed++;
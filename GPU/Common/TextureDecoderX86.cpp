@@ -0,0 +1,345 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+
+#include <immintrin.h>
+
+#include "Common/ColorConv.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/TextureDecoderX86.h"
+
+// We don't compile the whole file with -msse4.1 / -mavx2, since that would let the compiler
+// use those instructions anywhere. MSVC doesn't need anything to use the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE4 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE4
+#define TARGET_AVX2
+#endif
+
+// CLUT4 lookups: with only 16 entries, each byte of the palette fits in one register, and
+// pshufb does 16 lookups at once. We split the palette into byte planes, look each plane up,
+// and interleave the planes back into pixels.
+
+TARGET_SSE4 void DeIndexTexture4To16SSE4(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	alignas(16) u8 planes[2][16];
+	for (int i = 0; i < 16; ++i) {
+		planes[0][i] = (u8)(clut[i] >> 0);
+		planes[1][i] = (u8)(clut[i] >> 8);
+	}
+	const __m128i plane0 = _mm_load_si128((const __m128i *)planes[0]);
+	const __m128i plane1 = _mm_load_si128((const __m128i *)planes[1]);
+	const __m128i mask4 = _mm_set1_epi8(0x0F);
+
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lo = _mm_and_si128(src, mask4);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(src, 4), mask4);
+		// The low nibble is the first pixel.
+		const __m128i idx0 = _mm_unpacklo_epi8(lo, hi);
+		const __m128i idx1 = _mm_unpackhi_epi8(lo, hi);
+
+		__m128i b0 = _mm_shuffle_epi8(plane0, idx0);
+		__m128i b1 = _mm_shuffle_epi8(plane1, idx0);
+		_mm_storeu_si128((__m128i *)(dest + i + 0), _mm_unpacklo_epi8(b0, b1));
+		_mm_storeu_si128((__m128i *)(dest + i + 8), _mm_unpackhi_epi8(b0, b1));
+		b0 = _mm_shuffle_epi8(plane0, idx1);
+		b1 = _mm_shuffle_epi8(plane1, idx1);
+		_mm_storeu_si128((__m128i *)(dest + i + 16), _mm_unpacklo_epi8(b0, b1));
+		_mm_storeu_si128((__m128i *)(dest + i + 24), _mm_unpackhi_epi8(b0, b1));
+		indexed += 16;
+	}
+
+	if (i < length)
+		DeIndexTexture4To16Basic(dest + i, indexed, length - i, clut);
+}
+
+TARGET_SSE4 static inline void Store4PlanesSSE4(u32 *dest, __m128i b0, __m128i b1, __m128i b2, __m128i b3) {
+	const __m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+	const __m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+	const __m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+	const __m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+	_mm_storeu_si128((__m128i *)(dest + 0), _mm_unpacklo_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)(dest + 4), _mm_unpackhi_epi16(lo01, lo23));
+	_mm_storeu_si128((__m128i *)(dest + 8), _mm_unpacklo_epi16(hi01, hi23));
+	_mm_storeu_si128((__m128i *)(dest + 12), _mm_unpackhi_epi16(hi01, hi23));
+}
+
+TARGET_SSE4 void DeIndexTexture4To32SSE4(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	alignas(16) u8 planes[4][16];
+	for (int i = 0; i < 16; ++i) {
+		planes[0][i] = (u8)(clut[i] >> 0);
+		planes[1][i] = (u8)(clut[i] >> 8);
+		planes[2][i] = (u8)(clut[i] >> 16);
+		planes[3][i] = (u8)(clut[i] >> 24);
+	}
+	const __m128i plane0 = _mm_load_si128((const __m128i *)planes[0]);
+	const __m128i plane1 = _mm_load_si128((const __m128i *)planes[1]);
+	const __m128i plane2 = _mm_load_si128((const __m128i *)planes[2]);
+	const __m128i plane3 = _mm_load_si128((const __m128i *)planes[3]);
+	const __m128i mask4 = _mm_set1_epi8(0x0F);
+
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lo = _mm_and_si128(src, mask4);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(src, 4), mask4);
+		const __m128i idx0 = _mm_unpacklo_epi8(lo, hi);
+		const __m128i idx1 = _mm_unpackhi_epi8(lo, hi);
+
+		Store4PlanesSSE4(dest + i, _mm_shuffle_epi8(plane0, idx0), _mm_shuffle_epi8(plane1, idx0), _mm_shuffle_epi8(plane2, idx0), _mm_shuffle_epi8(plane3, idx0));
+		Store4PlanesSSE4(dest + i + 16, _mm_shuffle_epi8(plane0, idx1), _mm_shuffle_epi8(plane1, idx1), _mm_shuffle_epi8(plane2, idx1), _mm_shuffle_epi8(plane3, idx1));
+		indexed += 16;
+	}
+
+	if (i < length)
+		DeIndexTexture4To32Basic(dest + i, indexed, length - i, clut);
+}
+
+// AVX2 versions of the CLUT4 lookups. vpshufb works within 128-bit lanes, so we put the first
+// half of the pixels in the low lane and the second half in the high lane, and sort the
+// results out with vperm2i128 at the end.
+
+TARGET_AVX2 void DeIndexTexture4To16AVX2(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	alignas(16) u8 planes[2][16];
+	for (int i = 0; i < 16; ++i) {
+		planes[0][i] = (u8)(clut[i] >> 0);
+		planes[1][i] = (u8)(clut[i] >> 8);
+	}
+	const __m256i plane0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)planes[0]));
+	const __m256i plane1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)planes[1]));
+	const __m256i mask4 = _mm256_set1_epi8(0x0F);
+
+	int i = 0;
+	for (; i + 64 <= length; i += 64) {
+		// Reorder the 64-bit halves so that each lane holds 16 consecutive source bytes after unpacking.
+		const __m256i src = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i *)indexed), _MM_SHUFFLE(3, 1, 2, 0));
+		const __m256i lo = _mm256_and_si256(src, mask4);
+		const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(src, 4), mask4);
+		// Lane 0: pixels 0-15, lane 1: pixels 16-31 (and 32-47 / 48-63 for idx1.)
+		const __m256i idx0 = _mm256_unpacklo_epi8(lo, hi);
+		const __m256i idx1 = _mm256_unpackhi_epi8(lo, hi);
+
+		__m256i b0 = _mm256_shuffle_epi8(plane0, idx0);
+		__m256i b1 = _mm256_shuffle_epi8(plane1, idx0);
+		__m256i p0 = _mm256_unpacklo_epi8(b0, b1);
+		__m256i p1 = _mm256_unpackhi_epi8(b0, b1);
+		_mm256_storeu_si256((__m256i *)(dest + i + 0), _mm256_permute2x128_si256(p0, p1, 0x20));
+		_mm256_storeu_si256((__m256i *)(dest + i + 16), _mm256_permute2x128_si256(p0, p1, 0x31));
+
+		b0 = _mm256_shuffle_epi8(plane0, idx1);
+		b1 = _mm256_shuffle_epi8(plane1, idx1);
+		p0 = _mm256_unpacklo_epi8(b0, b1);
+		p1 = _mm256_unpackhi_epi8(b0, b1);
+		_mm256_storeu_si256((__m256i *)(dest + i + 32), _mm256_permute2x128_si256(p0, p1, 0x20));
+		_mm256_storeu_si256((__m256i *)(dest + i + 48), _mm256_permute2x128_si256(p0, p1, 0x31));
+		indexed += 32;
+	}
+
+	// 32 pixel rows are common (fused 4-bit rows are 16 bytes), so do those with 128-bit ops like SSE4.1.
+	if (i + 32 <= length) {
+		const __m128i plane0x = _mm256_castsi256_si128(plane0);
+		const __m128i plane1x = _mm256_castsi256_si128(plane1);
+		const __m128i mask4x = _mm256_castsi256_si128(mask4);
+		const __m128i src = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lo = _mm_and_si128(src, mask4x);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(src, 4), mask4x);
+		const __m128i idx0 = _mm_unpacklo_epi8(lo, hi);
+		const __m128i idx1 = _mm_unpackhi_epi8(lo, hi);
+
+		__m128i b0 = _mm_shuffle_epi8(plane0x, idx0);
+		__m128i b1 = _mm_shuffle_epi8(plane1x, idx0);
+		_mm_storeu_si128((__m128i *)(dest + i + 0), _mm_unpacklo_epi8(b0, b1));
+		_mm_storeu_si128((__m128i *)(dest + i + 8), _mm_unpackhi_epi8(b0, b1));
+		b0 = _mm_shuffle_epi8(plane0x, idx1);
+		b1 = _mm_shuffle_epi8(plane1x, idx1);
+		_mm_storeu_si128((__m128i *)(dest + i + 16), _mm_unpacklo_epi8(b0, b1));
+		_mm_storeu_si128((__m128i *)(dest + i + 24), _mm_unpackhi_epi8(b0, b1));
+		indexed += 16;
+		i += 32;
+	}
+
+	if (i < length)
+		DeIndexTexture4To16Basic(dest + i, indexed, length - i, clut);
+}
+
+TARGET_AVX2 static inline void Store4PlanesAVX2(u32 *dest, __m256i b0, __m256i b1, __m256i b2, __m256i b3) {
+	const __m256i lo01 = _mm256_unpacklo_epi8(b0, b1);
+	const __m256i lo23 = _mm256_unpacklo_epi8(b2, b3);
+	const __m256i hi01 = _mm256_unpackhi_epi8(b0, b1);
+	const __m256i hi23 = _mm256_unpackhi_epi8(b2, b3);
+	// Lane 0 has pixels 0-15 and lane 1 pixels 16-31, in four groups of four.
+	const __m256i p0 = _mm256_unpacklo_epi16(lo01, lo23);
+	const __m256i p1 = _mm256_unpackhi_epi16(lo01, lo23);
+	const __m256i p2 = _mm256_unpacklo_epi16(hi01, hi23);
+	const __m256i p3 = _mm256_unpackhi_epi16(hi01, hi23);
+	_mm256_storeu_si256((__m256i *)(dest + 0), _mm256_permute2x128_si256(p0, p1, 0x20));
+	_mm256_storeu_si256((__m256i *)(dest + 8), _mm256_permute2x128_si256(p2, p3, 0x20));
+	_mm256_storeu_si256((__m256i *)(dest + 16), _mm256_permute2x128_si256(p0, p1, 0x31));
+	_mm256_storeu_si256((__m256i *)(dest + 24), _mm256_permute2x128_si256(p2, p3, 0x31));
+}
+
+TARGET_AVX2 void DeIndexTexture4To32AVX2(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	alignas(16) u8 planes[4][16];
+	for (int i = 0; i < 16; ++i) {
+		planes[0][i] = (u8)(clut[i] >> 0);
+		planes[1][i] = (u8)(clut[i] >> 8);
+		planes[2][i] = (u8)(clut[i] >> 16);
+		planes[3][i] = (u8)(clut[i] >> 24);
+	}
+	const __m256i plane0 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)planes[0]));
+	const __m256i plane1 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)planes[1]));
+	const __m256i plane2 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)planes[2]));
+	const __m256i plane3 = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)planes[3]));
+	const __m128i mask4 = _mm_set1_epi8(0x0F);
+
+	int i = 0;
+	for (; i + 32 <= length; i += 32) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)indexed);
+		const __m128i lo = _mm_and_si128(src, mask4);
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(src, 4), mask4);
+		// Lane 0: pixels 0-15, lane 1: pixels 16-31.
+		const __m256i idx = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(lo, hi)), _mm_unpackhi_epi8(lo, hi), 1);
+
+		Store4PlanesAVX2(dest + i, _mm256_shuffle_epi8(plane0, idx), _mm256_shuffle_epi8(plane1, idx), _mm256_shuffle_epi8(plane2, idx), _mm256_shuffle_epi8(plane3, idx));
+		indexed += 16;
+	}
+
+	if (i < length)
+		DeIndexTexture4To32Basic(dest + i, indexed, length - i, clut);
+}
+
+TARGET_AVX2 void DeIndexTexture8To32AVX2(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)(indexed + i));
+		const __m256i idx0 = _mm256_cvtepu8_epi32(src);
+		const __m256i idx1 = _mm256_cvtepu8_epi32(_mm_srli_si128(src, 8));
+		_mm256_storeu_si256((__m256i *)(dest + i + 0), _mm256_i32gather_epi32((const int *)clut, idx0, 4));
+		_mm256_storeu_si256((__m256i *)(dest + i + 8), _mm256_i32gather_epi32((const int *)clut, idx1, 4));
+	}
+
+	if (i < length)
+		DeIndexTexture8To32Basic(dest + i, indexed + i, length - i, clut);
+}
+
+// 16-bit to 8888 conversions. These work on 16-bit lanes, building RRGG and BBAA halves,
+// then interleave them into pixels.
+
+TARGET_AVX2 static inline void StoreRGBA8888AVX2(u32 *dst, __m256i rg, __m256i ba) {
+	const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+	const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+	_mm256_storeu_si256((__m256i *)(dst + 0), _mm256_permute2x128_si256(lo, hi, 0x20));
+	_mm256_storeu_si256((__m256i *)(dst + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+TARGET_AVX2 static inline __m256i Expand5To8AVX2(__m256i v) {
+	return _mm256_or_si256(_mm256_slli_epi16(v, 3), _mm256_srli_epi16(v, 2));
+}
+
+TARGET_AVX2 void ConvertRGBA4444ToRGBA8888AVX2(u32 *dst, const u16 *src, u32 numPixels) {
+	const __m256i mask4 = _mm256_set1_epi16(0x000F);
+	const __m256i mul17 = _mm256_set1_epi16(0x0011);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+		// Each nibble times 0x11 duplicates it into a full byte.
+		const __m256i r = _mm256_mullo_epi16(_mm256_and_si256(c, mask4), mul17);
+		const __m256i g = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(c, 4), mask4), mul17);
+		const __m256i b = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(c, 8), mask4), mul17);
+		const __m256i a = _mm256_mullo_epi16(_mm256_srli_epi16(c, 12), mul17);
+		StoreRGBA8888AVX2(dst + i, _mm256_or_si256(r, _mm256_slli_epi16(g, 8)), _mm256_or_si256(b, _mm256_slli_epi16(a, 8)));
+	}
+
+	for (; i < numPixels; i++) {
+		dst[i] = RGBA4444ToRGBA8888(src[i]);
+	}
+}
+
+TARGET_AVX2 void ConvertRGBA5551ToRGBA8888AVX2(u32 *dst, const u16 *src, u32 numPixels) {
+	const __m256i mask5 = _mm256_set1_epi16(0x001F);
+	const __m256i maskA = _mm256_set1_epi16((short)0xFF00);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i r = Expand5To8AVX2(_mm256_and_si256(c, mask5));
+		const __m256i g = Expand5To8AVX2(_mm256_and_si256(_mm256_srli_epi16(c, 5), mask5));
+		const __m256i b = Expand5To8AVX2(_mm256_and_si256(_mm256_srli_epi16(c, 10), mask5));
+		// Sign-extend the alpha bit, then keep only the high byte.
+		const __m256i a = _mm256_and_si256(_mm256_srai_epi16(c, 15), maskA);
+		StoreRGBA8888AVX2(dst + i, _mm256_or_si256(r, _mm256_slli_epi16(g, 8)), _mm256_or_si256(b, a));
+	}
+
+	for (; i < numPixels; i++) {
+		dst[i] = RGBA5551ToRGBA8888(src[i]);
+	}
+}
+
+TARGET_AVX2 void ConvertRGB565ToRGBA8888AVX2(u32 *dst, const u16 *src, u32 numPixels) {
+	const __m256i mask5 = _mm256_set1_epi16(0x001F);
+	const __m256i mask6 = _mm256_set1_epi16(0x003F);
+	const __m256i maskA = _mm256_set1_epi16((short)0xFF00);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+		const __m256i r = Expand5To8AVX2(_mm256_and_si256(c, mask5));
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask6);
+		g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+		const __m256i b = Expand5To8AVX2(_mm256_srli_epi16(c, 11));
+		StoreRGBA8888AVX2(dst + i, _mm256_or_si256(r, _mm256_slli_epi16(g, 8)), _mm256_or_si256(b, maskA));
+	}
+
+	for (; i < numPixels; i++) {
+		dst[i] = RGB565ToRGBA8888(src[i]);
+	}
+}
+
+// Same as QuickTexHash64Basic, 64 bytes at a time. vpshufd swaps the 64-bit pairs within each 128-bit lane.
+TARGET_AVX2 u64 QuickTexHash64AVX2(const void *checkp, u32 size) {
+	const __m256i *p = (const __m256i *)checkp;
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	const __m256i keys0 = _mm256_loadu_si256((const __m256i *)&quickTexHash64Keys[0]);
+	const __m256i keys1 = _mm256_loadu_si256((const __m256i *)&quickTexHash64Keys[4]);
+
+	for (u32 i = 0; i < size / 64; ++i) {
+		const __m256i data0 = _mm256_loadu_si256(p);
+		const __m256i data1 = _mm256_loadu_si256(p + 1);
+		const __m256i keyed0 = _mm256_xor_si256(data0, keys0);
+		const __m256i keyed1 = _mm256_xor_si256(data1, keys1);
+		acc0 = _mm256_add_epi64(acc0, _mm256_mul_epu32(keyed0, _mm256_srli_epi64(keyed0, 32)));
+		acc1 = _mm256_add_epi64(acc1, _mm256_mul_epu32(keyed1, _mm256_srli_epi64(keyed1, 32)));
+		acc0 = _mm256_add_epi64(acc0, _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc1 = _mm256_add_epi64(acc1, _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1, 0, 3, 2)));
+		p += 2;
+	}
+
+	u64 result[8];
+	_mm256_storeu_si256((__m256i *)&result[0], acc0);
+	_mm256_storeu_si256((__m256i *)&result[4], acc1);
+	return QuickTexHash64Finish(result, (const u8 *)p, size);
+}
+
+#endif
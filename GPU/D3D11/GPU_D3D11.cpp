@@ -281,7 +281,7 @@ void GPU_D3D11::FinishDeferred() {
 
 inline void GPU_D3D11::CheckFlushOp(int cmd, u32 diff) {
 	const u8 cmdFlags = cmdInfo_[cmd].flags;
-	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE)) {
+	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE) && NeedsFlushOnChange(cmd)) {
 		if (dumpThisFrame_) {
 			NOTICE_LOG(G3D, "================ FLUSH ================");
 		}
@@ -317,7 +317,7 @@ void GPU_DX9::FinishDeferred() {
 
 inline void GPU_DX9::CheckFlushOp(int cmd, u32 diff) {
 	const u8 cmdFlags = cmdInfo_[cmd].flags;
-	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE)) {
+	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE) && NeedsFlushOnChange(cmd)) {
 		if (dumpThisFrame_) {
 			NOTICE_LOG(G3D, "================ FLUSH ================");
 		}
@@ -62,14 +62,21 @@ struct GPUStatistics {
 		numVertsSubmitted = 0;
 		numCachedVertsDrawn = 0;
 		numUncachedVertsDrawn = 0;
+		numDecodedVertexCacheHits = 0;
+		numDecodedVertexCacheMisses = 0;
 		numTrackedVertexArrays = 0;
 		numTextureInvalidations = 0;
 		numTextureInvalidationsByFramebuffer = 0;
 		numTexturesHashed = 0;
 		numTextureSwitches = 0;
 		numTextureDataBytesHashed = 0;
+		numTextureHashesSkipped = 0;
 		numShaderSwitches = 0;
 		numFlushes = 0;
+		numFlushesSkipped = 0;
+		numFlushesPrimChange = 0;
+		numFlushesBufferFull = 0;
+		memset(numFlushesByCmd, 0, sizeof(numFlushesByCmd));
 		numTexturesDecoded = 0;
 		numFramebufferEvaluations = 0;
 		numReadbacks = 0;
@@ -85,14 +92,23 @@ struct GPUStatistics {
 	int numDrawCalls;
 	int numCachedDrawCalls;
 	int numFlushes;
+	// Flush reasons. State changes are counted per command, anything else (like frame end) isn't counted.
+	int numFlushesSkipped;
+	int numFlushesPrimChange;
+	int numFlushesBufferFull;
+	int numFlushesByCmd[256];
 	int numVertsSubmitted;
 	int numCachedVertsDrawn;
 	int numUncachedVertsDrawn;
+	int numDecodedVertexCacheHits;
+	int numDecodedVertexCacheMisses;
+	int decodedVertexCacheBytes;
 	int numTrackedVertexArrays;
 	int numTextureInvalidations;
 	int numTextureInvalidationsByFramebuffer;
 	int numTexturesHashed;
 	int numTextureDataBytesHashed;
+	int numTextureHashesSkipped;
 	int numTextureSwitches;
 	int numShaderSwitches;
 	int numTexturesDecoded;
@@ -366,6 +366,95 @@ void GPUCommon::Flush() {
 	drawEngineCommon_->DispatchFlush();
 }
 
+bool GPUCommon::NeedsFlushOnChange(int cmd) {
+	if (!drawEngineCommon_->GetNumDrawCalls())
+		return false;
+	if (IsStateChangeIrrelevant(cmd)) {
+		gpuStats.numFlushesSkipped++;
+		return false;
+	}
+	gpuStats.numFlushesByCmd[cmd]++;
+	return true;
+}
+
+// A change to one of these commands can't affect queued draws if the feature it configures is
+// off for them. This must only look at state that always flushes on change (the enables, clear
+// mode and UV gen mode), so that the queued draws are known to share it.
+bool GPUCommon::IsStateChangeIrrelevant(int cmd) {
+	const bool textureOff = !gstate.isTextureMapEnabled() || gstate.isModeClear();
+	switch (cmd) {
+	case GE_CMD_TEXADDR0: case GE_CMD_TEXADDR1: case GE_CMD_TEXADDR2: case GE_CMD_TEXADDR3:
+	case GE_CMD_TEXADDR4: case GE_CMD_TEXADDR5: case GE_CMD_TEXADDR6: case GE_CMD_TEXADDR7:
+	case GE_CMD_TEXBUFWIDTH0: case GE_CMD_TEXBUFWIDTH1: case GE_CMD_TEXBUFWIDTH2: case GE_CMD_TEXBUFWIDTH3:
+	case GE_CMD_TEXBUFWIDTH4: case GE_CMD_TEXBUFWIDTH5: case GE_CMD_TEXBUFWIDTH6: case GE_CMD_TEXBUFWIDTH7:
+	case GE_CMD_TEXSIZE0:
+	case GE_CMD_TEXFORMAT:
+	case GE_CMD_TEXMODE:
+	case GE_CMD_TEXFUNC:
+	case GE_CMD_TEXENVCOLOR:
+	case GE_CMD_TEXFILTER:
+	case GE_CMD_TEXWRAP:
+	case GE_CMD_TEXLODSLOPE:
+	case GE_CMD_CLUTADDR:
+	case GE_CMD_CLUTADDRUPPER:
+	case GE_CMD_CLUTFORMAT:
+	case GE_CMD_LOADCLUT:
+		return textureOff;
+
+	case GE_CMD_TGENMATRIXNUMBER:
+	case GE_CMD_TGENMATRIXDATA:
+		return textureOff || gstate.getUVGenMode() != GE_TEXMAP_TEXTURE_MATRIX;
+
+	case GE_CMD_FOGCOLOR:
+	case GE_CMD_FOG1:
+	case GE_CMD_FOG2:
+		return !gstate.isFogEnabled() || gstate.isModeClear();
+
+	case GE_CMD_ALPHATEST:
+		return !gstate.isAlphaTestEnabled() || gstate.isModeClear();
+
+	case GE_CMD_COLORTEST:
+	case GE_CMD_COLORREF:
+	case GE_CMD_COLORTESTMASK:
+		return !gstate.isColorTestEnabled() || gstate.isModeClear();
+
+	// Note: material ambient and alpha are used as the vertex color without lighting too.
+	case GE_CMD_AMBIENTCOLOR:
+	case GE_CMD_AMBIENTALPHA:
+	case GE_CMD_MATERIALDIFFUSE:
+	case GE_CMD_MATERIALEMISSIVE:
+	case GE_CMD_MATERIALSPECULAR:
+	case GE_CMD_MATERIALSPECULARCOEF:
+	case GE_CMD_LIGHTMODE:
+		return !gstate.isLightingEnabled();
+
+	default:
+		break;
+	}
+
+	// Per light parameters, don't matter if the light is off.
+	int light = -1;
+	if (cmd >= GE_CMD_LIGHTTYPE0 && cmd <= GE_CMD_LIGHTTYPE3) {
+		light = cmd - GE_CMD_LIGHTTYPE0;
+	} else if (cmd >= GE_CMD_LX0 && cmd <= GE_CMD_LZ3) {
+		light = (cmd - GE_CMD_LX0) / 3;
+	} else if (cmd >= GE_CMD_LDX0 && cmd <= GE_CMD_LDZ3) {
+		light = (cmd - GE_CMD_LDX0) / 3;
+	} else if (cmd >= GE_CMD_LKA0 && cmd <= GE_CMD_LKC3) {
+		light = (cmd - GE_CMD_LKA0) / 3;
+	} else if (cmd >= GE_CMD_LKS0 && cmd <= GE_CMD_LKS3) {
+		light = cmd - GE_CMD_LKS0;
+	} else if (cmd >= GE_CMD_LKO0 && cmd <= GE_CMD_LKO3) {
+		light = cmd - GE_CMD_LKO0;
+	} else if (cmd >= GE_CMD_LAC0 && cmd <= GE_CMD_LSC3) {
+		light = (cmd - GE_CMD_LAC0) / 3;
+	}
+	if (light >= 0) {
+		return !gstate.isLightingEnabled() || !gstate.isLightChanEnabled(light);
+	}
+	return false;
+}
+
 GPUCommon::GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw) :
 	dumpNextFrame_(false),
 	dumpThisFrame_(false),
@@ -960,6 +1049,7 @@ void GPUCommon::NotifySteppingExit() {
 }
 
 bool GPUCommon::InterpretList(DisplayList &list) {
+	TRACE_THIS_SCOPE("GE list", "ge");
 	// Initialized to avoid a race condition with bShowDebugStats changing.
 	double start = 0.0;
 	if (coreCollectDebugStats) {
@@ -1055,7 +1145,7 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 		} else {
 			uint64_t flags = info.flags;
 			if (flags & FLAG_FLUSHBEFOREONCHANGE) {
-				if (drawEngineCommon_->GetNumDrawCalls()) {
+				if (NeedsFlushOnChange(cmd)) {
 					drawEngineCommon_->DispatchFlush();
 				}
 			}
@@ -2123,7 +2213,8 @@ void GPUCommon::Execute_TgenMtxNum(u32 op, u32 diff) {
 		while ((src[i] >> 24) == GE_CMD_TGENMATRIXDATA) {
 			const u32 newVal = src[i] << 8;
 			if (dst[i] != newVal) {
-				Flush();
+				if (NeedsFlushOnChange(GE_CMD_TGENMATRIXDATA))
+					Flush();
 				dst[i] = newVal;
 				gstate_c.Dirty(DIRTY_TEXMATRIX);
 			}
@@ -2146,7 +2237,8 @@ void GPUCommon::Execute_TgenMtxData(u32 op, u32 diff) {
 	int num = gstate.texmtxnum & 0xF;
 	u32 newVal = op << 8;
 	if (num < 12 && newVal != ((const u32 *)gstate.tgenMatrix)[num]) {
-		Flush();
+		if (NeedsFlushOnChange(GE_CMD_TGENMATRIXDATA))
+			Flush();
 		((u32 *)gstate.tgenMatrix)[num] = newVal;
 		gstate_c.Dirty(DIRTY_TEXMATRIX | DIRTY_FRAGMENTSHADER_STATE);  // We check the matrix to see if we need projection
 	}
@@ -2713,6 +2805,7 @@ void GPUCommon::DoBlockTransfer(u32 skipDrawReason) {
 			}
 		}
 
+		Memory::MarkDirty(dstBasePtr + (dstY * dstStride + dstX) * bpp, height * dstStride * bpp);
 		// Fixes Gran Turismo's funky text issue, since it overwrites the current texture.
 		textureCache_->Invalidate(dstBasePtr + (dstY * dstStride + dstX) * bpp, height * dstStride * bpp, GPU_INVALIDATE_HINT);
 		framebufferManager_->NotifyBlockTransferAfter(dstBasePtr, dstStride, dstX, dstY, srcBasePtr, srcStride, srcX, srcY, width, height, bpp, skipDrawReason);
@@ -2782,10 +2875,13 @@ bool GPUCommon::PerformMemoryUpload(u32 dest, int size) {
 }
 
 void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
-	if (size > 0)
+	if (size > 0) {
+		Memory::MarkDirty(addr, size);
 		textureCache_->Invalidate(addr, size, type);
-	else
+	} else {
+		Memory::MarkAllDirty();
 		textureCache_->InvalidateAll(type);
+	}
 
 	if (type != GPU_INVALIDATE_ALL && framebufferManager_->MayIntersectFramebuffer(addr)) {
 		// Vempire invalidates (with writeback) after drawing, but before blitting.
@@ -2890,14 +2986,40 @@ bool GPUCommon::FramebufferReallyDirty() {
 
 size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 	float vertexAverageCycles = gpuStats.numVertsSubmitted > 0 ? (float)gpuStats.vertexGPUCycles / (float)gpuStats.numVertsSubmitted : 0.0f;
+
+	// Show the state changes that caused the most flushes.
+	int stateFlushes = 0;
+	int topCmds[3] = { -1, -1, -1 };
+	for (int cmd = 0; cmd < 256; ++cmd) {
+		int count = gpuStats.numFlushesByCmd[cmd];
+		if (!count)
+			continue;
+		stateFlushes += count;
+		for (int i = 0; i < 3; ++i) {
+			if (topCmds[i] == -1 || count > gpuStats.numFlushesByCmd[topCmds[i]]) {
+				for (int j = 2; j > i; --j)
+					topCmds[j] = topCmds[j - 1];
+				topCmds[i] = cmd;
+				break;
+			}
+		}
+	}
+	char topCmdsStr[64] = "";
+	size_t pos = 0;
+	for (int i = 0; i < 3 && topCmds[i] != -1; ++i) {
+		pos += snprintf(topCmdsStr + pos, sizeof(topCmdsStr) - pos, " %02x:%d", topCmds[i], gpuStats.numFlushesByCmd[topCmds[i]]);
+	}
+
 	return snprintf(buffer, size,
 		"DL processing time: %0.2f ms\n"
 		"Draw calls: %d, flushes %d, clears %d (cached: %d)\n"
+		"Flushes by state: %d (top%s), prim: %d, full: %d, skipped: %d\n"
 		"Num Tracked Vertex Arrays: %d\n"
 		"Commands per call level: %i %i %i %i\n"
 		"Vertices: %d cached: %d uncached: %d\n"
+		"Decoded vertex cache: %d hits, %d misses, %d kB\n"
 		"FBOs active: %d (evaluations: %d)\n"
-		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
+		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB, hashes skipped: %d\n"
 		"Readbacks: %d, uploads: %d\n"
 		"GPU cycles executed: %d (%f per vertex)\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
@@ -2905,17 +3027,26 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numFlushes,
 		gpuStats.numClears,
 		gpuStats.numCachedDrawCalls,
+		stateFlushes,
+		topCmdsStr,
+		gpuStats.numFlushesPrimChange,
+		gpuStats.numFlushesBufferFull,
+		gpuStats.numFlushesSkipped,
 		gpuStats.numTrackedVertexArrays,
 		gpuStats.gpuCommandsAtCallLevel[0], gpuStats.gpuCommandsAtCallLevel[1], gpuStats.gpuCommandsAtCallLevel[2], gpuStats.gpuCommandsAtCallLevel[3],
 		gpuStats.numVertsSubmitted,
 		gpuStats.numCachedVertsDrawn,
 		gpuStats.numUncachedVertsDrawn,
+		gpuStats.numDecodedVertexCacheHits,
+		gpuStats.numDecodedVertexCacheMisses,
+		gpuStats.decodedVertexCacheBytes / 1024,
 		(int)framebufferManager_->NumVFBs(),
 		gpuStats.numFramebufferEvaluations,
 		(int)textureCache_->NumLoadedTextures(),
 		gpuStats.numTexturesDecoded,
 		gpuStats.numTextureInvalidations,
 		gpuStats.numTextureDataBytesHashed / 1024,
+		gpuStats.numTextureHashesSkipped,
 		gpuStats.numReadbacks,
 		gpuStats.numUploads,
 		gpuStats.vertexGPUCycles + gpuStats.otherGPUCycles,
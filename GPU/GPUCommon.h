@@ -263,6 +263,10 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	void DeviceLost() override;
 	void DeviceRestore() override;
 
+	// Checks if a change to cmd needs the queued draws to be flushed first, and counts the reason.
+	bool NeedsFlushOnChange(int cmd);
+	static bool IsStateChangeIrrelevant(int cmd);
+
 	void SetDrawType(DrawType type, GEPrimitiveType prim) {
 		if (type != lastDraw_) {
 			// We always flush when drawing splines/beziers so no need to do so here
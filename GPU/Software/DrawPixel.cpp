@@ -0,0 +1,1067 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#include <algorithm>
+#include <mutex>
+#include "Common/ColorConv.h"
+#include "Common/StringUtils.h"
+#include "Core/Reporting.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/Rasterizer.h"
+#include "GPU/Software/SoftGpu.h"
+
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#endif
+
+using namespace Math3D;
+
+static_assert(sizeof(PixelFuncID) == sizeof(u64), "PixelFuncID should fit in its key");
+
+namespace Rasterizer {
+
+std::mutex jitCacheLock;
+PixelJitCache *jitCache = nullptr;
+
+void Init() {
+	jitCache = new PixelJitCache();
+}
+
+void Shutdown() {
+	delete jitCache;
+	jitCache = nullptr;
+}
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (!jitCache->IsInSpace(ptr)) {
+		return false;
+	}
+
+	name = jitCache->DescribeCodePtr(ptr);
+	return true;
+}
+
+void ComputePixelFuncID(PixelFuncID *id_out) {
+	PixelFuncID id;
+
+	id.clearMode = gstate.isModeClear();
+	// Depth range test - applied in clear mode, if not through mode.
+	id.applyDepthRange = !gstate.isModeThrough();
+	id.fbFormat = gstate.FrameBufFormat();
+	id.dithering = gstate.isDitherEnabled();
+	id.applyColorWriteMask = gstate.getColorMask() != 0;
+
+	id.alphaTestFunc = GE_COMP_ALWAYS;
+	id.depthTestFunc = GE_COMP_ALWAYS;
+	if (id.clearMode) {
+		id.depthWrite = gstate.isClearModeDepthMask();
+	} else {
+		if (gstate.isAlphaTestEnabled()) {
+			id.alphaTestFunc = gstate.getAlphaTestFunction();
+		}
+		if (gstate.isDepthTestEnabled()) {
+			id.depthTestFunc = gstate.getDepthTestFunction();
+			id.depthWrite = gstate.isDepthWriteEnabled();
+		}
+
+		// Fog is applied prior to color test.
+		id.applyFog = gstate.isFogEnabled() && !gstate.isModeThrough();
+
+		id.colorTest = gstate.isColorTestEnabled();
+		if (id.colorTest) {
+			id.colorTestFunc = gstate.getColorTestFunction();
+		}
+
+		id.stencilTest = gstate.isStencilTestEnabled();
+		if (id.stencilTest) {
+			id.stencilTestFunc = gstate.getStencilTestFunction();
+			id.sFail = gstate.getStencilOpSFail();
+			id.zFail = gstate.getStencilOpZFail();
+			id.zPass = gstate.getStencilOpZPass();
+		}
+
+		id.alphaBlend = gstate.isAlphaBlendEnabled();
+		if (id.alphaBlend) {
+			id.alphaBlendEq = gstate.getBlendEq();
+			id.alphaBlendSrc = gstate.getBlendFuncA();
+			id.alphaBlendDst = gstate.getBlendFuncB();
+		}
+
+		id.applyLogicOp = gstate.isLogicOpEnabled();
+		if (id.applyLogicOp) {
+			id.logicOp = gstate.getLogicOp();
+		}
+	}
+
+	*id_out = id;
+}
+
+SingleFunc GetSingleFunc(const PixelFuncID &id) {
+	SingleFunc jitted = jitCache->GetSingle(id);
+	if (jitted) {
+		return jitted;
+	}
+
+	return &DrawSinglePixel;
+}
+
+// NOTE: These likely aren't endian safe
+static inline u32 GetPixelColor(GEBufferFormat fmt, int x, int y) {
+	switch (fmt) {
+	case GE_FORMAT_565:
+		return RGB565ToRGBA8888(fb.Get16(x, y, gstate.FrameBufStride()));
+
+	case GE_FORMAT_5551:
+		return RGBA5551ToRGBA8888(fb.Get16(x, y, gstate.FrameBufStride()));
+
+	case GE_FORMAT_4444:
+		return RGBA4444ToRGBA8888(fb.Get16(x, y, gstate.FrameBufStride()));
+
+	case GE_FORMAT_8888:
+		return fb.Get32(x, y, gstate.FrameBufStride());
+
+	case GE_FORMAT_INVALID:
+	case GE_FORMAT_DEPTH16:
+		_dbg_assert_msg_(false, "Software: invalid framebuf format.");
+	}
+	return 0;
+}
+
+static inline void SetPixelColor(GEBufferFormat fmt, int x, int y, u32 value) {
+	switch (fmt) {
+	case GE_FORMAT_565:
+		fb.Set16(x, y, gstate.FrameBufStride(), RGBA8888ToRGB565(value));
+		break;
+
+	case GE_FORMAT_5551:
+		fb.Set16(x, y, gstate.FrameBufStride(), RGBA8888ToRGBA5551(value));
+		break;
+
+	case GE_FORMAT_4444:
+		fb.Set16(x, y, gstate.FrameBufStride(), RGBA8888ToRGBA4444(value));
+		break;
+
+	case GE_FORMAT_8888:
+		fb.Set32(x, y, gstate.FrameBufStride(), value);
+		break;
+
+	case GE_FORMAT_INVALID:
+	case GE_FORMAT_DEPTH16:
+		_dbg_assert_msg_(false, "Software: invalid framebuf format.");
+	}
+}
+
+static inline u16 GetPixelDepth(int x, int y) {
+	return depthbuf.Get16(x, y, gstate.DepthBufStride());
+}
+
+void SetPixelDepth(int x, int y, u16 value) {
+	depthbuf.Set16(x, y, gstate.DepthBufStride(), value);
+}
+
+u8 GetPixelStencil(GEBufferFormat fmt, int x, int y) {
+	if (fmt == GE_FORMAT_565) {
+		// Always treated as 0 for comparison purposes.
+		return 0;
+	} else if (fmt == GE_FORMAT_5551) {
+		return ((fb.Get16(x, y, gstate.FrameBufStride()) & 0x8000) != 0) ? 0xFF : 0;
+	} else if (fmt == GE_FORMAT_4444) {
+		return Convert4To8(fb.Get16(x, y, gstate.FrameBufStride()) >> 12);
+	} else {
+		return fb.Get32(x, y, gstate.FrameBufStride()) >> 24;
+	}
+}
+
+static inline void SetPixelStencil(GEBufferFormat fmt, int x, int y, u8 value) {
+	// TODO: This seems like it maybe respects the alpha mask (at least in some scenarios?)
+
+	if (fmt == GE_FORMAT_565) {
+		// Do nothing
+	} else if (fmt == GE_FORMAT_5551) {
+		u16 pixel = fb.Get16(x, y, gstate.FrameBufStride()) & ~0x8000;
+		pixel |= value != 0 ? 0x8000 : 0;
+		fb.Set16(x, y, gstate.FrameBufStride(), pixel);
+	} else if (fmt == GE_FORMAT_4444) {
+		u16 pixel = fb.Get16(x, y, gstate.FrameBufStride()) & ~0xF000;
+		pixel |= (u16)value << 12;
+		fb.Set16(x, y, gstate.FrameBufStride(), pixel);
+	} else {
+		u32 pixel = fb.Get32(x, y, gstate.FrameBufStride()) & ~0xFF000000;
+		pixel |= (u32)value << 24;
+		fb.Set32(x, y, gstate.FrameBufStride(), pixel);
+	}
+}
+
+static inline bool DepthTestPassed(GEComparison func, int x, int y, u16 z) {
+	u16 reference_z = GetPixelDepth(x, y);
+
+	switch (func) {
+	case GE_COMP_NEVER:
+		return false;
+
+	case GE_COMP_ALWAYS:
+		return true;
+
+	case GE_COMP_EQUAL:
+		return (z == reference_z);
+
+	case GE_COMP_NOTEQUAL:
+		return (z != reference_z);
+
+	case GE_COMP_LESS:
+		return (z < reference_z);
+
+	case GE_COMP_LEQUAL:
+		return (z <= reference_z);
+
+	case GE_COMP_GREATER:
+		return (z > reference_z);
+
+	case GE_COMP_GEQUAL:
+		return (z >= reference_z);
+
+	default:
+		return 0;
+	}
+}
+
+static inline bool StencilTestPassed(const PixelFuncID &pixelID, u8 stencil) {
+	// TODO: Does the masking logic make any sense?
+	stencil &= gstate.getStencilTestMask();
+	u8 ref = gstate.getStencilTestRef() & gstate.getStencilTestMask();
+	switch (GEComparison(pixelID.stencilTestFunc)) {
+		case GE_COMP_NEVER:
+			return false;
+
+		case GE_COMP_ALWAYS:
+			return true;
+
+		case GE_COMP_EQUAL:
+			return ref == stencil;
+
+		case GE_COMP_NOTEQUAL:
+			return ref != stencil;
+
+		case GE_COMP_LESS:
+			return ref < stencil;
+
+		case GE_COMP_LEQUAL:
+			return ref <= stencil;
+
+		case GE_COMP_GREATER:
+			return ref > stencil;
+
+		case GE_COMP_GEQUAL:
+			return ref >= stencil;
+	}
+	return true;
+}
+
+static inline u8 ApplyStencilOp(GEBufferFormat fmt, int op, u8 old_stencil) {
+	// TODO: Apply mask to reference or old stencil?
+	u8 reference_stencil = gstate.getStencilTestRef(); // TODO: Apply mask?
+	const u8 write_mask = gstate.getStencilWriteMask();
+
+	switch (op) {
+		case GE_STENCILOP_KEEP:
+			return old_stencil;
+
+		case GE_STENCILOP_ZERO:
+			return old_stencil & write_mask;
+
+		case GE_STENCILOP_REPLACE:
+			return (reference_stencil & ~write_mask) | (old_stencil & write_mask);
+
+		case GE_STENCILOP_INVERT:
+			return (~old_stencil & ~write_mask) | (old_stencil & write_mask);
+
+		case GE_STENCILOP_INCR:
+			switch (fmt) {
+			case GE_FORMAT_8888:
+				if (old_stencil != 0xFF) {
+					return ((old_stencil + 1) & ~write_mask) | (old_stencil & write_mask);
+				}
+				return old_stencil;
+			case GE_FORMAT_5551:
+				return ~write_mask | (old_stencil & write_mask);
+			case GE_FORMAT_4444:
+				if (old_stencil < 0xF0) {
+					return ((old_stencil + 0x10) & ~write_mask) | (old_stencil & write_mask);
+				}
+				return old_stencil;
+			default:
+				return old_stencil;
+			}
+			break;
+
+		case GE_STENCILOP_DECR:
+			switch (fmt) {
+			case GE_FORMAT_4444:
+				if (old_stencil >= 0x10)
+					return ((old_stencil - 0x10) & ~write_mask) | (old_stencil & write_mask);
+				break;
+			default:
+				if (old_stencil != 0)
+					return ((old_stencil - 1) & ~write_mask) | (old_stencil & write_mask);
+				return old_stencil;
+			}
+			break;
+	}
+
+	return old_stencil;
+}
+
+static inline u32 ApplyLogicOp(GELogicOp op, u32 old_color, u32 new_color) {
+	// All of the operations here intentionally preserve alpha/stencil.
+	switch (op) {
+	case GE_LOGIC_CLEAR:
+		new_color &= 0xFF000000;
+		break;
+
+	case GE_LOGIC_AND:
+		new_color = new_color & (old_color | 0xFF000000);
+		break;
+
+	case GE_LOGIC_AND_REVERSE:
+		new_color = new_color & (~old_color | 0xFF000000);
+		break;
+
+	case GE_LOGIC_COPY:
+		// No change to new_color.
+		break;
+
+	case GE_LOGIC_AND_INVERTED:
+		new_color = (~new_color & (old_color & 0x00FFFFFF)) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_NOOP:
+		new_color = (old_color & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_XOR:
+		new_color = new_color ^ (old_color & 0x00FFFFFF);
+		break;
+
+	case GE_LOGIC_OR:
+		new_color = new_color | (old_color & 0x00FFFFFF);
+		break;
+
+	case GE_LOGIC_NOR:
+		new_color = (~(new_color | old_color) & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_EQUIV:
+		new_color = (~(new_color ^ old_color) & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_INVERTED:
+		new_color = (~old_color & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_OR_REVERSE:
+		new_color = new_color | (~old_color & 0x00FFFFFF);
+		break;
+
+	case GE_LOGIC_COPY_INVERTED:
+		new_color = (~new_color & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_OR_INVERTED:
+		new_color = ((~new_color | old_color) & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_NAND:
+		new_color = (~(new_color & old_color) & 0x00FFFFFF) | (new_color & 0xFF000000);
+		break;
+
+	case GE_LOGIC_SET:
+		new_color |= 0x00FFFFFF;
+		break;
+	}
+
+	return new_color;
+}
+
+static inline bool ColorTestPassed(const PixelFuncID &pixelID, const Vec3<int> &color) {
+	const u32 mask = gstate.getColorTestMask();
+	const u32 c = color.ToRGB() & mask;
+	const u32 ref = gstate.getColorTestRef() & mask;
+	switch (GEComparison(pixelID.colorTestFunc)) {
+		case GE_COMP_NEVER:
+			return false;
+
+		case GE_COMP_ALWAYS:
+			return true;
+
+		case GE_COMP_EQUAL:
+			return c == ref;
+
+		case GE_COMP_NOTEQUAL:
+			return c != ref;
+
+		default:
+			ERROR_LOG_REPORT(G3D, "Software: Invalid colortest function: %d", pixelID.colorTestFunc);
+			break;
+	}
+	return true;
+}
+
+static inline bool AlphaTestPassed(const PixelFuncID &pixelID, int alpha) {
+	const u8 mask = gstate.getAlphaTestMask() & 0xFF;
+	const u8 ref = gstate.getAlphaTestRef() & mask;
+	alpha &= mask;
+
+	switch (GEComparison(pixelID.alphaTestFunc)) {
+		case GE_COMP_NEVER:
+			return false;
+
+		case GE_COMP_ALWAYS:
+			return true;
+
+		case GE_COMP_EQUAL:
+			return (alpha == ref);
+
+		case GE_COMP_NOTEQUAL:
+			return (alpha != ref);
+
+		case GE_COMP_LESS:
+			return (alpha < ref);
+
+		case GE_COMP_LEQUAL:
+			return (alpha <= ref);
+
+		case GE_COMP_GREATER:
+			return (alpha > ref);
+
+		case GE_COMP_GEQUAL:
+			return (alpha >= ref);
+	}
+	return true;
+}
+
+static inline Vec3<int> GetSourceFactor(GEBlendSrcFactor factor, const Vec4<int> &source, const Vec4<int> &dst) {
+	switch (factor) {
+	case GE_SRCBLEND_DSTCOLOR:
+		return dst.rgb();
+
+	case GE_SRCBLEND_INVDSTCOLOR:
+		return Vec3<int>::AssignToAll(255) - dst.rgb();
+
+	case GE_SRCBLEND_SRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3)));
+#else
+		return Vec3<int>::AssignToAll(source.a());
+#endif
+
+	case GE_SRCBLEND_INVSRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_sub_epi32(_mm_set1_epi32(255), _mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3))));
+#else
+		return Vec3<int>::AssignToAll(255 - source.a());
+#endif
+
+	case GE_SRCBLEND_DSTALPHA:
+		return Vec3<int>::AssignToAll(dst.a());
+
+	case GE_SRCBLEND_INVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - dst.a());
+
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+		return Vec3<int>::AssignToAll(2 * source.a());
+
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * source.a(), 255));
+
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+		return Vec3<int>::AssignToAll(2 * dst.a());
+
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * dst.a(), 255));
+
+	case GE_SRCBLEND_FIXA:
+	default:
+		// All other dest factors (> 10) are treated as FIXA.
+		return Vec3<int>::FromRGB(gstate.getFixA());
+	}
+}
+
+static inline Vec3<int> GetDestFactor(GEBlendDstFactor factor, const Vec4<int> &source, const Vec4<int> &dst) {
+	switch (factor) {
+	case GE_DSTBLEND_SRCCOLOR:
+		return source.rgb();
+
+	case GE_DSTBLEND_INVSRCCOLOR:
+		return Vec3<int>::AssignToAll(255) - source.rgb();
+
+	case GE_DSTBLEND_SRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3)));
+#else
+		return Vec3<int>::AssignToAll(source.a());
+#endif
+
+	case GE_DSTBLEND_INVSRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_sub_epi32(_mm_set1_epi32(255), _mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3))));
+#else
+		return Vec3<int>::AssignToAll(255 - source.a());
+#endif
+
+	case GE_DSTBLEND_DSTALPHA:
+		return Vec3<int>::AssignToAll(dst.a());
+
+	case GE_DSTBLEND_INVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - dst.a());
+
+	case GE_DSTBLEND_DOUBLESRCALPHA:
+		return Vec3<int>::AssignToAll(2 * source.a());
+
+	case GE_DSTBLEND_DOUBLEINVSRCALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * source.a(), 255));
+
+	case GE_DSTBLEND_DOUBLEDSTALPHA:
+		return Vec3<int>::AssignToAll(2 * dst.a());
+
+	case GE_DSTBLEND_DOUBLEINVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * dst.a(), 255));
+
+	case GE_DSTBLEND_FIXB:
+	default:
+		// All other dest factors (> 10) are treated as FIXB.
+		return Vec3<int>::FromRGB(gstate.getFixB());
+	}
+}
+
+// Removed inline here - it was never chosen to be inlined by the compiler anyway, too complex.
+Vec3<int> AlphaBlendingResult(const PixelFuncID &pixelID, const Vec4<int> &source, const Vec4<int> &dst) {
+	// Note: These factors cannot go below 0, but they can go above 255 when doubling.
+	Vec3<int> srcfactor = GetSourceFactor(GEBlendSrcFactor(pixelID.alphaBlendSrc), source, dst);
+	Vec3<int> dstfactor = GetDestFactor(GEBlendDstFactor(pixelID.alphaBlendDst), source, dst);
+
+	switch (GEBlendMode(pixelID.alphaBlendEq)) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+	{
+#if defined(_M_SSE)
+		const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(source.ivec), _mm_cvtepi32_ps(srcfactor.ivec));
+		const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst.ivec), _mm_cvtepi32_ps(dstfactor.ivec));
+		return Vec3<int>(_mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(s, d), _mm_set_ps1(1.0f / 255.0f))));
+#else
+		return (source.rgb() * srcfactor + dst.rgb() * dstfactor) / 255;
+#endif
+	}
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+	{
+#if defined(_M_SSE)
+		const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(source.ivec), _mm_cvtepi32_ps(srcfactor.ivec));
+		const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst.ivec), _mm_cvtepi32_ps(dstfactor.ivec));
+		return Vec3<int>(_mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(s, d), _mm_set_ps1(1.0f / 255.0f))));
+#else
+		return (source.rgb() * srcfactor - dst.rgb() * dstfactor) / 255;
+#endif
+	}
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+	{
+#if defined(_M_SSE)
+		const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(source.ivec), _mm_cvtepi32_ps(srcfactor.ivec));
+		const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst.ivec), _mm_cvtepi32_ps(dstfactor.ivec));
+		return Vec3<int>(_mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(d, s), _mm_set_ps1(1.0f / 255.0f))));
+#else
+		return (dst.rgb() * dstfactor - source.rgb() * srcfactor) / 255;
+#endif
+	}
+
+	case GE_BLENDMODE_MIN:
+		return Vec3<int>(std::min(source.r(), dst.r()),
+						std::min(source.g(), dst.g()),
+						std::min(source.b(), dst.b()));
+
+	case GE_BLENDMODE_MAX:
+		return Vec3<int>(std::max(source.r(), dst.r()),
+						std::max(source.g(), dst.g()),
+						std::max(source.b(), dst.b()));
+
+	case GE_BLENDMODE_ABSDIFF:
+		return Vec3<int>(::abs(source.r() - dst.r()),
+						::abs(source.g() - dst.g()),
+						::abs(source.b() - dst.b()));
+
+	default:
+		ERROR_LOG_REPORT(G3D, "Software: Unknown blend function %x", pixelID.alphaBlendEq);
+		return Vec3<int>();
+	}
+}
+
+template <bool clearMode>
+inline void DrawSinglePixel(int x, int y, int z, int fog, const Vec4<int> &color_in, const PixelFuncID &pixelID) {
+	Vec4<int> prim_color = color_in.Clamp(0, 255);
+	const GEBufferFormat fbFormat = GEBufferFormat(pixelID.fbFormat);
+
+	// Depth range test - applied in clear mode, if not through mode.
+	if (pixelID.applyDepthRange)
+		if (z < gstate.getDepthRangeMin() || z > gstate.getDepthRangeMax())
+			return;
+
+	if (pixelID.alphaTestFunc != GE_COMP_ALWAYS && !clearMode)
+		if (!AlphaTestPassed(pixelID, prim_color.a()))
+			return;
+
+	// Fog is applied prior to color test.
+	if (pixelID.applyFog && !clearMode) {
+		Vec3<int> fogColor = Vec3<int>::FromRGB(gstate.fogcolor);
+		fogColor = (prim_color.rgb() * fog + fogColor * (255 - fog)) / 255;
+		prim_color.r() = fogColor.r();
+		prim_color.g() = fogColor.g();
+		prim_color.b() = fogColor.b();
+	}
+
+	if (pixelID.colorTest && !clearMode)
+		if (!ColorTestPassed(pixelID, prim_color.rgb()))
+			return;
+
+	// In clear mode, it uses the alpha color as stencil.
+	u8 stencil = clearMode ? prim_color.a() : GetPixelStencil(fbFormat, x, y);
+	if (clearMode) {
+		if (pixelID.depthWrite)
+			SetPixelDepth(x, y, z);
+	} else if (pixelID.stencilTest || pixelID.depthTestFunc != GE_COMP_ALWAYS) {
+		if (pixelID.stencilTest && !StencilTestPassed(pixelID, stencil)) {
+			stencil = ApplyStencilOp(fbFormat, pixelID.sFail, stencil);
+			SetPixelStencil(fbFormat, x, y, stencil);
+			return;
+		}
+
+		// Also apply depth at the same time.  If disabled, same as passing.
+		if (pixelID.depthTestFunc != GE_COMP_ALWAYS && !DepthTestPassed(GEComparison(pixelID.depthTestFunc), x, y, z)) {
+			if (pixelID.stencilTest) {
+				stencil = ApplyStencilOp(fbFormat, pixelID.zFail, stencil);
+				SetPixelStencil(fbFormat, x, y, stencil);
+			}
+			return;
+		} else if (pixelID.stencilTest) {
+			stencil = ApplyStencilOp(fbFormat, pixelID.zPass, stencil);
+		}
+
+		if (pixelID.depthWrite) {
+			SetPixelDepth(x, y, z);
+		}
+	} else if (pixelID.depthWrite) {
+		// An always passing depth test still writes depth.
+		SetPixelDepth(x, y, z);
+	}
+
+	const u32 old_color = GetPixelColor(fbFormat, x, y);
+	u32 new_color;
+
+	// Dithering happens before the logic op and regardless of framebuffer format or clear mode.
+	// We do it while alpha blending because it happens before clamping.
+	if (pixelID.alphaBlend && !clearMode) {
+		const Vec4<int> dst = Vec4<int>::FromRGBA(old_color);
+		Vec3<int> blended = AlphaBlendingResult(pixelID, prim_color, dst);
+		if (pixelID.dithering) {
+			blended += Vec3<int>::AssignToAll(gstate.getDitherValue(x, y));
+		}
+
+		// ToRGB() always automatically clamps.
+		new_color = blended.ToRGB();
+		new_color |= stencil << 24;
+	} else {
+		if (pixelID.dithering) {
+			// We'll discard alpha anyway.
+			prim_color += Vec4<int>::AssignToAll(gstate.getDitherValue(x, y));
+		}
+
+#if defined(_M_SSE)
+		new_color = Vec3<int>(prim_color.ivec).ToRGB();
+		new_color |= stencil << 24;
+#else
+		new_color = Vec4<int>(prim_color.r(), prim_color.g(), prim_color.b(), stencil).ToRGBA();
+#endif
+	}
+
+	// Logic ops are applied after blending (if blending is enabled.)
+	if (pixelID.applyLogicOp && !clearMode) {
+		// Logic ops don't affect stencil, which happens inside ApplyLogicOp.
+		new_color = ApplyLogicOp(GELogicOp(pixelID.logicOp), old_color, new_color);
+	}
+
+	if (clearMode) {
+		new_color = (new_color & ~gstate.getClearModeColorMask()) | (old_color & gstate.getClearModeColorMask());
+	}
+	if (pixelID.applyColorWriteMask) {
+		new_color = (new_color & ~gstate.getColorMask()) | (old_color & gstate.getColorMask());
+	}
+
+	SetPixelColor(fbFormat, x, y, new_color);
+}
+
+void DrawSinglePixel(int x, int y, int z, int fog, const Vec4<int> &color_in, const PixelFuncID &pixelID) {
+	if (pixelID.clearMode)
+		DrawSinglePixel<true>(x, y, z, fog, color_in, pixelID);
+	else
+		DrawSinglePixel<false>(x, y, z, fog, color_in, pixelID);
+}
+
+#if defined(_M_SSE)
+// Lanes are all ones where a <func> b.
+static inline __m128i QuadCompare(GEComparison func, const __m128i &a, const __m128i &b) {
+	const __m128i ones = _mm_set1_epi32(-1);
+	switch (func) {
+	case GE_COMP_NEVER:
+		return _mm_setzero_si128();
+	case GE_COMP_ALWAYS:
+		return ones;
+	case GE_COMP_EQUAL:
+		return _mm_cmpeq_epi32(a, b);
+	case GE_COMP_NOTEQUAL:
+		return _mm_xor_si128(_mm_cmpeq_epi32(a, b), ones);
+	case GE_COMP_LESS:
+		return _mm_cmplt_epi32(a, b);
+	case GE_COMP_LEQUAL:
+		return _mm_xor_si128(_mm_cmpgt_epi32(a, b), ones);
+	case GE_COMP_GREATER:
+		return _mm_cmpgt_epi32(a, b);
+	case GE_COMP_GEQUAL:
+		return _mm_xor_si128(_mm_cmplt_epi32(a, b), ones);
+	}
+	return ones;
+}
+
+static inline __m128i QuadChannel(const __m128i &packed, int shift) {
+	return _mm_and_si128(_mm_srli_epi32(packed, shift), _mm_set1_epi32(0xFF));
+}
+
+// Clamps each channel to 0-255 (like ToRGB()) and packs them into colors with zero alpha.
+static inline __m128i QuadPackRGB(const __m128i &r, const __m128i &g, const __m128i &b) {
+	const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(r, g), _mm_packs_epi32(b, b));
+	const __m128i rg = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 4));
+	const __m128i b0 = _mm_unpacklo_epi8(_mm_srli_si128(bytes, 8), _mm_setzero_si128());
+	return _mm_unpacklo_epi16(rg, b0);
+}
+
+// The factor enums match for both sides, with color meaning the other side's color.
+static inline __m128i QuadBlendFactor(int factor, const __m128i &otherColor, const __m128i &srcA, const __m128i &dstA, u8 fix) {
+	// All values fit in the low 16 bits, so 16-bit min/max are safe below.
+	const __m128i const255 = _mm_set1_epi32(255);
+	switch (factor) {
+	case GE_SRCBLEND_DSTCOLOR:
+		return otherColor;
+	case GE_SRCBLEND_INVDSTCOLOR:
+		return _mm_sub_epi32(const255, otherColor);
+	case GE_SRCBLEND_SRCALPHA:
+		return srcA;
+	case GE_SRCBLEND_INVSRCALPHA:
+		return _mm_sub_epi32(const255, srcA);
+	case GE_SRCBLEND_DSTALPHA:
+		return dstA;
+	case GE_SRCBLEND_INVDSTALPHA:
+		return _mm_sub_epi32(const255, dstA);
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+		return _mm_add_epi32(srcA, srcA);
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+		return _mm_sub_epi32(const255, _mm_min_epi16(_mm_add_epi32(srcA, srcA), const255));
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+		return _mm_add_epi32(dstA, dstA);
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		return _mm_sub_epi32(const255, _mm_min_epi16(_mm_add_epi32(dstA, dstA), const255));
+	case GE_SRCBLEND_FIXA:
+	default:
+		return _mm_set1_epi32(fix);
+	}
+}
+
+// Same float math as AlphaBlendingResult(), for one channel of the quad.
+static inline __m128i QuadBlendChannel(GEBlendMode eq, const __m128i &src, const __m128i &dst, const __m128i &srcFactor, const __m128i &dstFactor) {
+	const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(src), _mm_cvtepi32_ps(srcFactor));
+	const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst), _mm_cvtepi32_ps(dstFactor));
+	switch (eq) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+		return _mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(s, d), _mm_set_ps1(1.0f / 255.0f)));
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+		return _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(s, d), _mm_set_ps1(1.0f / 255.0f)));
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+		return _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(d, s), _mm_set_ps1(1.0f / 255.0f)));
+	case GE_BLENDMODE_MIN:
+		return _mm_min_epi16(src, dst);
+	case GE_BLENDMODE_MAX:
+		return _mm_max_epi16(src, dst);
+	case GE_BLENDMODE_ABSDIFF:
+	default:
+		return _mm_sub_epi32(_mm_max_epi16(src, dst), _mm_min_epi16(src, dst));
+	}
+}
+
+static inline __m128i QuadLoad32(const u32 *row0, const u32 *row1, int liveBits) {
+	if (liveBits == 0xF)
+		return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)row0), _mm_loadl_epi64((const __m128i *)row1));
+	// Don't touch pixels we won't draw, they might be outside the buffer.
+	return _mm_setr_epi32((liveBits & 1) ? row0[0] : 0, (liveBits & 2) ? row0[1] : 0, (liveBits & 4) ? row1[0] : 0, (liveBits & 8) ? row1[1] : 0);
+}
+
+static inline void QuadStore32(u32 *row0, u32 *row1, int liveBits, const __m128i &value) {
+	if (liveBits == 0xF) {
+		_mm_storel_epi64((__m128i *)row0, value);
+		_mm_storel_epi64((__m128i *)row1, _mm_unpackhi_epi64(value, value));
+		return;
+	}
+
+	alignas(16) u32 lanes[4];
+	_mm_store_si128((__m128i *)lanes, value);
+	if (liveBits & 1)
+		row0[0] = lanes[0];
+	if (liveBits & 2)
+		row0[1] = lanes[1];
+	if (liveBits & 4)
+		row1[0] = lanes[2];
+	if (liveBits & 8)
+		row1[1] = lanes[3];
+}
+
+// Same as DrawSinglePixel<false>() for all four pixels at once, limited to what GetQuadFunc() allows.
+static void DrawQuad(int x, int y, const Vec4<int> &z_in, const Vec4<int> &fog, const Vec4<int> *colors, const Vec4<int> &mask, const PixelFuncID &pixelID) {
+	// Start with lanes that are inside the primitive.
+	__m128i live = _mm_cmpgt_epi32(mask.ivec, _mm_set1_epi32(-1));
+	const __m128i z = _mm_and_si128(z_in.ivec, _mm_set1_epi32(0xFFFF));
+
+	if (pixelID.applyDepthRange) {
+		const __m128i outside = _mm_or_si128(_mm_cmplt_epi32(z, _mm_set1_epi32(gstate.getDepthRangeMin())), _mm_cmpgt_epi32(z, _mm_set1_epi32(gstate.getDepthRangeMax())));
+		live = _mm_andnot_si128(outside, live);
+	}
+
+	// Clamps to 0-255, leaving the quad as four packed 8888 colors.
+	const __m128i prim = _mm_packus_epi16(_mm_packs_epi32(colors[0].ivec, colors[1].ivec), _mm_packs_epi32(colors[2].ivec, colors[3].ivec));
+	__m128i r = QuadChannel(prim, 0);
+	__m128i g = QuadChannel(prim, 8);
+	__m128i b = QuadChannel(prim, 16);
+	const __m128i a = _mm_srli_epi32(prim, 24);
+
+	if (pixelID.alphaTestFunc != GE_COMP_ALWAYS) {
+		const u8 alphaMask = gstate.getAlphaTestMask() & 0xFF;
+		const __m128i maskVec = _mm_set1_epi32(alphaMask);
+		const __m128i ref = _mm_set1_epi32(gstate.getAlphaTestRef() & alphaMask);
+		live = _mm_and_si128(live, QuadCompare(GEComparison(pixelID.alphaTestFunc), _mm_and_si128(a, maskVec), ref));
+	}
+
+	int liveBits = _mm_movemask_ps(_mm_castsi128_ps(live));
+	if (liveBits == 0)
+		return;
+
+	const int depthStride = gstate.DepthBufStride();
+	u16 *depth0 = depthbuf.Get16Ptr(x, y, depthStride);
+	u16 *depth1 = depthbuf.Get16Ptr(x, y + 1, depthStride);
+	if (pixelID.depthTestFunc != GE_COMP_ALWAYS) {
+		const __m128i ref = _mm_setr_epi32((liveBits & 1) ? depth0[0] : 0, (liveBits & 2) ? depth0[1] : 0, (liveBits & 4) ? depth1[0] : 0, (liveBits & 8) ? depth1[1] : 0);
+		live = _mm_and_si128(live, QuadCompare(GEComparison(pixelID.depthTestFunc), z, ref));
+		liveBits = _mm_movemask_ps(_mm_castsi128_ps(live));
+		if (liveBits == 0)
+			return;
+	}
+
+	if (pixelID.depthWrite) {
+		alignas(16) u32 lanes[4];
+		_mm_store_si128((__m128i *)lanes, z);
+		if (liveBits & 1)
+			depth0[0] = (u16)lanes[0];
+		if (liveBits & 2)
+			depth0[1] = (u16)lanes[1];
+		if (liveBits & 4)
+			depth1[0] = (u16)lanes[2];
+		if (liveBits & 8)
+			depth1[1] = (u16)lanes[3];
+	}
+
+	if (pixelID.applyFog) {
+		// (color * fog + fogColor * (255 - fog)) / 255, paired up for madd.
+		const __m128i fogFactors = _mm_or_si128(fog.ivec, _mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(255), fog.ivec), 16));
+		const __m128i div255 = _mm_set1_epi32(0x8081);
+		const u32 fogColor = gstate.fogcolor;
+		auto applyFog = [&](const __m128i &c, int shift) {
+			const __m128i pair = _mm_or_si128(c, _mm_set1_epi32(((fogColor >> shift) & 0xFF) << 16));
+			const __m128i sum = _mm_madd_epi16(pair, fogFactors);
+			return _mm_srli_epi32(_mm_mulhi_epu16(sum, div255), 7);
+		};
+		r = applyFog(r, 0);
+		g = applyFog(g, 8);
+		b = applyFog(b, 16);
+	}
+
+	const int fbStride = gstate.FrameBufStride();
+	u32 *row0 = fb.as32 + y * fbStride + x;
+	u32 *row1 = row0 + fbStride;
+	const __m128i old = QuadLoad32(row0, row1, liveBits);
+
+	if (pixelID.alphaBlend) {
+		const __m128i dr = QuadChannel(old, 0);
+		const __m128i dg = QuadChannel(old, 8);
+		const __m128i db = QuadChannel(old, 16);
+		const __m128i da = _mm_srli_epi32(old, 24);
+
+		const GEBlendMode eq = GEBlendMode(pixelID.alphaBlendEq);
+		const u32 fixA = gstate.getFixA();
+		const u32 fixB = gstate.getFixB();
+		const int srcFactor = pixelID.alphaBlendSrc;
+		const int dstFactor = pixelID.alphaBlendDst;
+		const __m128i nr = QuadBlendChannel(eq, r, dr, QuadBlendFactor(srcFactor, dr, a, da, fixA >> 0), QuadBlendFactor(dstFactor, r, a, da, fixB >> 0));
+		const __m128i ng = QuadBlendChannel(eq, g, dg, QuadBlendFactor(srcFactor, dg, a, da, fixA >> 8), QuadBlendFactor(dstFactor, g, a, da, fixB >> 8));
+		const __m128i nb = QuadBlendChannel(eq, b, db, QuadBlendFactor(srcFactor, db, a, da, fixA >> 16), QuadBlendFactor(dstFactor, b, a, da, fixB >> 16));
+		r = nr;
+		g = ng;
+		b = nb;
+	}
+
+	if (pixelID.dithering) {
+		const __m128i dither = _mm_setr_epi32(gstate.getDitherValue(x, y), gstate.getDitherValue(x + 1, y), gstate.getDitherValue(x, y + 1), gstate.getDitherValue(x + 1, y + 1));
+		r = _mm_add_epi32(r, dither);
+		g = _mm_add_epi32(g, dither);
+		b = _mm_add_epi32(b, dither);
+	}
+
+	// Keep the stencil, which is the old alpha.
+	const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+	__m128i newColor = _mm_or_si128(QuadPackRGB(r, g, b), _mm_and_si128(old, alphaMask));
+	if (pixelID.applyColorWriteMask) {
+		const __m128i writeMask = _mm_set1_epi32(gstate.getColorMask());
+		newColor = _mm_or_si128(_mm_andnot_si128(writeMask, newColor), _mm_and_si128(old, writeMask));
+	}
+
+	QuadStore32(row0, row1, liveBits, newColor);
+}
+#endif
+
+QuadFunc GetQuadFunc(const PixelFuncID &id) {
+#if defined(_M_SSE)
+	if (id.clearMode || id.stencilTest || id.colorTest || id.applyLogicOp)
+		return nullptr;
+	if (id.fbFormat != GE_FORMAT_8888)
+		return nullptr;
+	// Unknown equations report an error per pixel.
+	if (id.alphaBlend && id.alphaBlendEq > GE_BLENDMODE_ABSDIFF)
+		return nullptr;
+	return &DrawQuad;
+#else
+	return nullptr;
+#endif
+}
+
+PixelJitCache::PixelJitCache() {
+	// 256k should be enough.
+	AllocCodeSpace(1024 * 64 * 4);
+
+	// Add some random code to "help" MSVC's buggy disassembler :(
+#if defined(_WIN32) && (defined(_M_IX86) || defined(_M_X64)) && !PPSSPP_PLATFORM(UWP)
+	using namespace Gen;
+	for (int i = 0; i < 100; i++) {
+		MOV(32, R(EAX), R(EBX));
+		RET();
+	}
+#elif defined(ARM)
+	BKPT(0);
+	BKPT(0);
+#endif
+}
+
+void PixelJitCache::Clear() {
+	ClearCodeSpace(0);
+	cache_.clear();
+	addresses_.clear();
+}
+
+std::string PixelJitCache::DescribePixelFuncID(const PixelFuncID &id) {
+	std::string name;
+	if (id.clearMode) {
+		name += "Clear";
+		if (id.depthWrite)
+			name += "Z";
+		return name;
+	}
+
+	switch (GEBufferFormat(id.fbFormat)) {
+	case GE_FORMAT_565: name = "565"; break;
+	case GE_FORMAT_5551: name = "5551"; break;
+	case GE_FORMAT_4444: name = "4444"; break;
+	case GE_FORMAT_8888: name = "8888"; break;
+	default: name = "INV"; break;
+	}
+
+	static const char *const comparisons[] = { "NEVER", "ALWAYS", "EQ", "NE", "LT", "LE", "GT", "GE" };
+	if (id.alphaTestFunc != GE_COMP_ALWAYS)
+		name += StringFromFormat(":AT%s", comparisons[id.alphaTestFunc]);
+	if (id.applyFog)
+		name += ":Fog";
+	if (id.colorTest)
+		name += StringFromFormat(":CT%s", comparisons[id.colorTestFunc]);
+	if (id.stencilTest)
+		name += StringFromFormat(":ST%s%d%d%d", comparisons[id.stencilTestFunc], id.sFail, id.zFail, id.zPass);
+	if (id.depthTestFunc != GE_COMP_ALWAYS)
+		name += StringFromFormat(":ZT%s", comparisons[id.depthTestFunc]);
+	if (id.depthWrite)
+		name += ":ZWrite";
+	if (!id.applyDepthRange)
+		name += ":Through";
+	if (id.alphaBlend)
+		name += StringFromFormat(":B%d_%d_%d", id.alphaBlendEq, id.alphaBlendSrc, id.alphaBlendDst);
+	if (id.dithering)
+		name += ":Dither";
+	if (id.applyLogicOp)
+		name += StringFromFormat(":L%d", id.logicOp);
+	if (id.applyColorWriteMask)
+		name += ":Mask";
+	return name;
+}
+
+std::string PixelJitCache::DescribeCodePtr(const u8 *ptr) {
+	ptrdiff_t dist = 0x7FFFFFFF;
+	PixelFuncID found{};
+	for (const auto &it : addresses_) {
+		ptrdiff_t it_dist = ptr - it.second;
+		if (it_dist >= 0 && it_dist < dist) {
+			found = it.first;
+			dist = it_dist;
+		}
+	}
+
+	return DescribePixelFuncID(found);
+}
+
+SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+
+	auto it = cache_.find(id);
+	if (it != cache_.end()) {
+		return it->second;
+	}
+
+	// TODO: What should be the min size?  Can we even hit this?
+	if (GetSpaceLeft() < 16384) {
+		Clear();
+	}
+
+#if defined(_M_X64) && !PPSSPP_PLATFORM(UWP)
+	addresses_[id] = GetCodePointer();
+	SingleFunc func = CompileSingle(id);
+	cache_[id] = func;
+	return func;
+#else
+	return nullptr;
+#endif
+}
+
+};
@@ -0,0 +1,170 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if PPSSPP_ARCH(ARM)
+#include "Common/ArmEmitter.h"
+#elif PPSSPP_ARCH(ARM64)
+#include "Common/Arm64Emitter.h"
+#elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#include "Common/x64Emitter.h"
+#elif PPSSPP_ARCH(MIPS)
+#include "Common/MipsEmitter.h"
+#else
+#include "Common/FakeEmitter.h"
+#endif
+#include "GPU/Math3D.h"
+#include "GPU/ge_constants.h"
+
+// Everything about the current fragment state that changes what happens to a pixel after
+// texturing. Values like test references, masks and fog color are read from gstate instead.
+struct PixelFuncID {
+	PixelFuncID() : fullKey(0) {
+	}
+
+	union {
+		u64 fullKey;
+		struct {
+			bool clearMode : 1;
+			bool applyDepthRange : 1;
+			bool depthWrite : 1;
+			bool applyFog : 1;
+			bool dithering : 1;
+			bool applyColorWriteMask : 1;
+			uint8_t fbFormat : 2;
+
+			// GE_COMP_ALWAYS when the test is off.
+			uint8_t alphaTestFunc : 3;
+			uint8_t depthTestFunc : 3;
+			uint8_t colorTestFunc : 2;
+
+			bool colorTest : 1;
+			bool stencilTest : 1;
+			uint8_t stencilTestFunc : 3;
+			uint8_t : 3;
+
+			uint8_t sFail : 3;
+			uint8_t zFail : 3;
+			uint8_t : 2;
+			uint8_t zPass : 3;
+			uint8_t : 5;
+
+			bool alphaBlend : 1;
+			uint8_t alphaBlendEq : 3;
+			uint8_t : 4;
+			uint8_t alphaBlendSrc : 4;
+			uint8_t alphaBlendDst : 4;
+
+			bool applyLogicOp : 1;
+			uint8_t logicOp : 4;
+		};
+	};
+
+	bool operator == (const PixelFuncID &other) const {
+		return fullKey == other.fullKey;
+	}
+};
+
+namespace std {
+
+template <>
+struct hash<PixelFuncID> {
+	std::size_t operator()(const PixelFuncID &k) const {
+		return hash<u64>()(k.fullKey);
+	}
+};
+
+};
+
+namespace Rasterizer {
+
+// z is the 16-bit depth, fog is 0-255 (255 = no fog.) The color is clamped to 0-255 inside.
+typedef void (*SingleFunc)(int x, int y, int z, int fog, const Math3D::Vec4<int> &color_in, const PixelFuncID &pixelID);
+
+// Draws the 2x2 quad with its top left at x, y.  Pixels with a negative mask are skipped.
+// The z, fog, and color arguments are per pixel in the same order: left to right, then top to bottom.
+typedef void (*QuadFunc)(int x, int y, const Math3D::Vec4<int> &z, const Math3D::Vec4<int> &fog, const Math3D::Vec4<int> *colors, const Math3D::Vec4<int> &mask, const PixelFuncID &pixelID);
+
+void ComputePixelFuncID(PixelFuncID *id);
+SingleFunc GetSingleFunc(const PixelFuncID &id);
+// Returns nullptr when the state can only be drawn one pixel at a time.
+QuadFunc GetQuadFunc(const PixelFuncID &id);
+
+// The C++ version, which the jitted functions must match exactly.
+void DrawSinglePixel(int x, int y, int z, int fog, const Math3D::Vec4<int> &color_in, const PixelFuncID &pixelID);
+
+void Init();
+void Shutdown();
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name);
+
+u8 GetPixelStencil(GEBufferFormat fmt, int x, int y);
+void SetPixelDepth(int x, int y, u16 value);
+Math3D::Vec3<int> AlphaBlendingResult(const PixelFuncID &pixelID, const Math3D::Vec4<int> &source, const Math3D::Vec4<int> &dst);
+
+#if PPSSPP_ARCH(ARM)
+class PixelJitCache : public ArmGen::ARMXCodeBlock {
+#elif PPSSPP_ARCH(ARM64)
+class PixelJitCache : public Arm64Gen::ARM64CodeBlock {
+#elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+class PixelJitCache : public Gen::XCodeBlock {
+#elif PPSSPP_ARCH(MIPS)
+class PixelJitCache : public MIPSGen::MIPSCodeBlock {
+#else
+class PixelJitCache : public FakeGen::FakeXCodeBlock {
+#endif
+public:
+	PixelJitCache();
+
+	// Returns a pointer to the code to run, or nullptr if the state isn't supported.
+	SingleFunc GetSingle(const PixelFuncID &id);
+	void Clear();
+
+	std::string DescribeCodePtr(const u8 *ptr);
+	std::string DescribePixelFuncID(const PixelFuncID &id);
+
+private:
+	SingleFunc CompileSingle(const PixelFuncID &id);
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	bool Jit_ApplyDepthRange(const PixelFuncID &id);
+	bool Jit_AlphaTest(const PixelFuncID &id);
+	bool Jit_ApplyFog(const PixelFuncID &id);
+	bool Jit_DepthTestAndWrite(const PixelFuncID &id);
+	bool Jit_CalculateFramebufferPtr(const PixelFuncID &id);
+	bool Jit_AlphaBlend(const PixelFuncID &id);
+	bool Jit_BlendFactor(Gen::X64Reg destReg, int factor, Gen::X64Reg otherColorReg, const void *fixPtr);
+	bool Jit_Dither(const PixelFuncID &id);
+	bool Jit_WriteColor(const PixelFuncID &id);
+
+	// Uses tempReg for the address when ptr is too far away for RIP addressing.
+	Gen::OpArg MatPtr(const void *ptr, Gen::X64Reg tempReg);
+
+	std::vector<Gen::FixupBranch> discards_;
+#endif
+
+	std::unordered_map<PixelFuncID, SingleFunc> cache_;
+	std::unordered_map<PixelFuncID, const u8 *> addresses_;
+};
+
+};
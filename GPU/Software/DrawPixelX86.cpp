@@ -0,0 +1,475 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+
+#include <emmintrin.h>
+#include "Common/x64Emitter.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/ge_constants.h"
+
+using namespace Gen;
+
+namespace Rasterizer {
+
+// We keep things to volatile registers on both ABIs, so there's nothing to save.
+// The Win64 arguments are shuffled in the prologue so that RCX is free for shifts.
+#ifdef _WIN32
+static const X64Reg xReg = R9;
+static const X64Reg yReg = RDX;
+static const X64Reg zReg = R8;
+#else
+static const X64Reg xReg = RDI;
+static const X64Reg yReg = RSI;
+static const X64Reg zReg = RDX;
+#endif
+
+static const X64Reg tempReg1 = RAX;
+static const X64Reg tempReg2 = R11;
+// Holds the color pointer until it's loaded, then the framebuffer pointer.
+static const X64Reg ptrReg = R10;
+
+// Only XMM0-XMM5 are volatile on Win64.
+static const X64Reg colorReg = XMM0;
+static const X64Reg fpScratchReg1 = XMM1;
+static const X64Reg fpScratchReg2 = XMM2;
+static const X64Reg fpScratchReg3 = XMM3;
+static const X64Reg fogReg = XMM4;
+static const X64Reg zeroReg = XMM5;
+
+alignas(16) static const u16 by255Mul[8] = { 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, };
+alignas(16) static const u16 words255[8] = { 255, 255, 255, 255, 255, 255, 255, 255, };
+alignas(16) static const u32 dwords255[4] = { 255, 255, 255, 255, };
+alignas(16) static const float by255[4] = { 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, };
+
+// The test passes when the condition is true, so we discard on the opposite.
+static CCFlags InverseComparison(GEComparison func) {
+	switch (func) {
+	case GE_COMP_EQUAL: return CC_NE;
+	case GE_COMP_NOTEQUAL: return CC_E;
+	case GE_COMP_LESS: return CC_AE;
+	case GE_COMP_LEQUAL: return CC_A;
+	case GE_COMP_GREATER: return CC_BE;
+	case GE_COMP_GEQUAL: return CC_B;
+	default:
+		_assert_msg_(false, "Unexpected comparison %d", (int)func);
+		return CC_NE;
+	}
+}
+
+OpArg PixelJitCache::MatPtr(const void *ptr, X64Reg tempReg) {
+	if (RipAccessible(ptr)) {
+		return M(ptr);
+	}
+	MOV(PTRBITS, R(tempReg), ImmPtr(ptr));
+	return MatR(tempReg);
+}
+
+SingleFunc PixelJitCache::CompileSingle(const PixelFuncID &id) {
+	// The rarer paths (clear mode, stencil, color test, logic ops) stay in C++ for now.
+	if (id.clearMode || id.stencilTest || id.colorTest || id.applyLogicOp)
+		return nullptr;
+	// For 16-bit framebuffers, we only do the simple overwrite.
+	if (id.fbFormat != GE_FORMAT_8888 && (id.alphaBlend || id.applyColorWriteMask))
+		return nullptr;
+
+	BeginWrite();
+	const u8 *start = AlignCode16();
+	discards_.clear();
+
+	// POSIX: arg1=x, arg2=y, arg3=z, arg4=fog, arg5=color_in, arg6=pixelID
+	// Win64: arg1=x, arg2=y, arg3=z, arg4=fog, stack+40=color_in, stack+48=pixelID
+#ifdef _WIN32
+	MOV(PTRBITS, R(ptrReg), MDisp(RSP, 40));
+	if (id.applyFog)
+		MOVD_xmm(fogReg, R(R9));
+	MOV(32, R(xReg), R(RCX));
+#else
+	MOV(PTRBITS, R(ptrReg), R(R8));
+	if (id.applyFog)
+		MOVD_xmm(fogReg, R(RCX));
+#endif
+
+	// Clamp the color to 0-255 and expand to 16-bit lanes.
+	PXOR(zeroReg, R(zeroReg));
+	MOVDQU(colorReg, MatR(ptrReg));
+	PACKSSDW(colorReg, R(colorReg));
+	PACKUSWB(colorReg, R(colorReg));
+	PUNPCKLBW(colorReg, R(zeroReg));
+
+	bool success = true;
+	success = success && Jit_ApplyDepthRange(id);
+	success = success && Jit_AlphaTest(id);
+	success = success && Jit_ApplyFog(id);
+	success = success && Jit_DepthTestAndWrite(id);
+	success = success && Jit_CalculateFramebufferPtr(id);
+	success = success && Jit_AlphaBlend(id);
+	success = success && Jit_Dither(id);
+	success = success && Jit_WriteColor(id);
+
+	if (!success) {
+		EndWrite();
+		ResetCodePtr(GetOffset(start));
+		return nullptr;
+	}
+
+	for (FixupBranch &fixup : discards_) {
+		SetJumpTarget(fixup);
+	}
+	discards_.clear();
+	RET();
+
+	EndWrite();
+	return (SingleFunc)start;
+}
+
+bool PixelJitCache::Jit_ApplyDepthRange(const PixelFuncID &id) {
+	if (!id.applyDepthRange)
+		return true;
+
+	// z is always 0-65535, so we can compare as unsigned 32-bit.
+	MOVZX(32, 16, tempReg1, MatPtr(&gstate.minz, tempReg1));
+	CMP(32, R(zReg), R(tempReg1));
+	discards_.push_back(J_CC(CC_B, true));
+
+	MOVZX(32, 16, tempReg1, MatPtr(&gstate.maxz, tempReg1));
+	CMP(32, R(zReg), R(tempReg1));
+	discards_.push_back(J_CC(CC_A, true));
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaTest(const PixelFuncID &id) {
+	switch (GEComparison(id.alphaTestFunc)) {
+	case GE_COMP_ALWAYS:
+		return true;
+
+	case GE_COMP_NEVER:
+		discards_.push_back(J(true));
+		return true;
+
+	default:
+		break;
+	}
+
+	// Compare (alpha & mask) against (ref & mask).
+	PEXTRW(tempReg1, R(colorReg), 3);
+	MOVZX(32, 8, tempReg2, MatPtr((const u8 *)&gstate.alphatest + 2, tempReg2));
+	AND(32, R(tempReg1), R(tempReg2));
+	MOVZX(32, 8, ptrReg, MatPtr((const u8 *)&gstate.alphatest + 1, ptrReg));
+	AND(32, R(ptrReg), R(tempReg2));
+	CMP(32, R(tempReg1), R(ptrReg));
+	discards_.push_back(J_CC(InverseComparison(GEComparison(id.alphaTestFunc)), true));
+	return true;
+}
+
+bool PixelJitCache::Jit_ApplyFog(const PixelFuncID &id) {
+	if (!id.applyFog)
+		return true;
+
+	// Multiply alpha by 255 and the fog color alpha by 0, so it passes through.
+	PSHUFLW(fogReg, R(fogReg), _MM_SHUFFLE(0, 0, 0, 0));
+	MOV(32, R(tempReg1), Imm32(255));
+	PINSRW(fogReg, R(tempReg1), 3);
+
+	MOVD_xmm(fpScratchReg1, MatPtr(&gstate.fogcolor, tempReg1));
+	PUNPCKLBW(fpScratchReg1, R(zeroReg));
+	MOVDQA(fpScratchReg2, MatPtr(words255, tempReg1));
+	PSUBW(fpScratchReg2, R(fogReg));
+
+	// These can't overflow: prim * fog + fogcolor * (255 - fog) <= 255 * 255.
+	PMULLW(colorReg, R(fogReg));
+	PMULLW(fpScratchReg1, R(fpScratchReg2));
+	PADDW(colorReg, R(fpScratchReg1));
+
+	// Now divide by 255, which for 16-bit values is the same as * 0x8081 >> 23.
+	PMULHUW(colorReg, MatPtr(by255Mul, tempReg1));
+	PSRLW(colorReg, 7);
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthTestAndWrite(const PixelFuncID &id) {
+	if (id.depthTestFunc == GE_COMP_ALWAYS && !id.depthWrite)
+		return true;
+	if (id.depthTestFunc == GE_COMP_NEVER) {
+		discards_.push_back(J(true));
+		return true;
+	}
+
+	// Calculate the depth pointer: depthbuf.data + (x + y * stride) * 2.
+	MOV(PTRBITS, R(tempReg1), MatPtr(&depthbuf.data, tempReg1));
+	MOV(32, R(tempReg2), MatPtr(&gstate.zbwidth, tempReg2));
+	AND(32, R(tempReg2), Imm32(0x7FC));
+	IMUL(32, tempReg2, R(yReg));
+	ADD(32, R(tempReg2), R(xReg));
+	LEA(64, tempReg1, MComplex(tempReg1, tempReg2, SCALE_2, 0));
+
+	if (id.depthTestFunc != GE_COMP_ALWAYS) {
+		MOVZX(32, 16, tempReg2, MatR(tempReg1));
+		CMP(32, R(zReg), R(tempReg2));
+		discards_.push_back(J_CC(InverseComparison(GEComparison(id.depthTestFunc)), true));
+	}
+
+	if (id.depthWrite) {
+		MOV(16, MatR(tempReg1), R(zReg));
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_BlendFactor(X64Reg destReg, int factor, X64Reg otherColorReg, const void *fixPtr) {
+	// The src and dst factor enums line up, with "other" being dst for src and src for dst.
+	X64Reg alphaReg = factor == GE_SRCBLEND_DSTALPHA || factor == GE_SRCBLEND_INVDSTALPHA || factor == GE_SRCBLEND_DOUBLEDSTALPHA || factor == GE_SRCBLEND_DOUBLEINVDSTALPHA ? fpScratchReg1 : colorReg;
+
+	switch (factor) {
+	case GE_SRCBLEND_DSTCOLOR:
+		MOVDQA(destReg, R(otherColorReg));
+		break;
+
+	case GE_SRCBLEND_INVDSTCOLOR:
+		MOVDQA(destReg, MatPtr(dwords255, tempReg1));
+		PSUBD(destReg, R(otherColorReg));
+		break;
+
+	case GE_SRCBLEND_SRCALPHA:
+	case GE_SRCBLEND_DSTALPHA:
+		PSHUFD(destReg, R(alphaReg), _MM_SHUFFLE(3, 3, 3, 3));
+		break;
+
+	case GE_SRCBLEND_INVSRCALPHA:
+	case GE_SRCBLEND_INVDSTALPHA:
+		PSHUFD(fogReg, R(alphaReg), _MM_SHUFFLE(3, 3, 3, 3));
+		MOVDQA(destReg, MatPtr(dwords255, tempReg1));
+		PSUBD(destReg, R(fogReg));
+		break;
+
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+		PSHUFD(destReg, R(alphaReg), _MM_SHUFFLE(3, 3, 3, 3));
+		PADDD(destReg, R(destReg));
+		break;
+
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		PSHUFD(fogReg, R(alphaReg), _MM_SHUFFLE(3, 3, 3, 3));
+		PADDD(fogReg, R(fogReg));
+		// At most 510, so a signed 16-bit min does the job (the high halves are zero.)
+		PMINSW(fogReg, MatPtr(dwords255, tempReg1));
+		MOVDQA(destReg, MatPtr(dwords255, tempReg1));
+		PSUBD(destReg, R(fogReg));
+		break;
+
+	default:
+		// All other factors (> 10) are treated as FIXA/FIXB.
+		MOVD_xmm(destReg, MatPtr(fixPtr, tempReg1));
+		PUNPCKLBW(destReg, R(zeroReg));
+		PUNPCKLWD(destReg, R(zeroReg));
+		break;
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaBlend(const PixelFuncID &id) {
+	if (!id.alphaBlend)
+		return true;
+
+	// Only 8888 gets here, read the dst color into 16-bit lanes.
+	MOVD_xmm(fpScratchReg1, MatR(ptrReg));
+	PUNPCKLBW(fpScratchReg1, R(zeroReg));
+
+	switch (GEBlendMode(id.alphaBlendEq)) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+		// Must match AlphaBlendingResult() exactly, so we do the same float math.
+		PUNPCKLWD(colorReg, R(zeroReg));
+		PUNPCKLWD(fpScratchReg1, R(zeroReg));
+		if (!Jit_BlendFactor(fpScratchReg2, id.alphaBlendSrc, fpScratchReg1, &gstate.blendfixa))
+			return false;
+		if (!Jit_BlendFactor(fpScratchReg3, id.alphaBlendDst, colorReg, &gstate.blendfixb))
+			return false;
+
+		CVTDQ2PS(colorReg, R(colorReg));
+		CVTDQ2PS(fpScratchReg2, R(fpScratchReg2));
+		MULPS(colorReg, R(fpScratchReg2));
+		CVTDQ2PS(fpScratchReg1, R(fpScratchReg1));
+		CVTDQ2PS(fpScratchReg3, R(fpScratchReg3));
+		MULPS(fpScratchReg1, R(fpScratchReg3));
+
+		if (id.alphaBlendEq == GE_BLENDMODE_MUL_AND_ADD) {
+			ADDPS(colorReg, R(fpScratchReg1));
+		} else if (id.alphaBlendEq == GE_BLENDMODE_MUL_AND_SUBTRACT) {
+			SUBPS(colorReg, R(fpScratchReg1));
+		} else {
+			SUBPS(fpScratchReg1, R(colorReg));
+			MOVAPS(colorReg, R(fpScratchReg1));
+		}
+		MULPS(colorReg, MatPtr(by255, tempReg1));
+		CVTPS2DQ(colorReg, R(colorReg));
+		// The results are within -510 to 1020, so this doesn't clamp anything yet.
+		PACKSSDW(colorReg, R(colorReg));
+		break;
+
+	case GE_BLENDMODE_MIN:
+		PMINSW(colorReg, R(fpScratchReg1));
+		break;
+
+	case GE_BLENDMODE_MAX:
+		PMAXSW(colorReg, R(fpScratchReg1));
+		break;
+
+	case GE_BLENDMODE_ABSDIFF:
+		MOVDQA(fpScratchReg2, R(colorReg));
+		PSUBUSW(colorReg, R(fpScratchReg1));
+		PSUBUSW(fpScratchReg1, R(fpScratchReg2));
+		POR(colorReg, R(fpScratchReg1));
+		break;
+
+	default:
+		// Let the C++ version report it.
+		return false;
+	}
+
+	return true;
+}
+
+bool PixelJitCache::Jit_Dither(const PixelFuncID &id) {
+	if (!id.dithering)
+		return true;
+
+	// Same as gstate.getDitherValue(x, y): (dithmtx[y & 3] >> ((x & 3) * 4)) & 0xF, sign extended.
+	MOV(32, R(tempReg1), R(yReg));
+	AND(32, R(tempReg1), Imm8(3));
+	if (RipAccessible(&gstate.dithmtx[0])) {
+		LEA(64, tempReg2, M(&gstate.dithmtx[0]));
+	} else {
+		MOV(PTRBITS, R(tempReg2), ImmPtr(&gstate.dithmtx[0]));
+	}
+	MOV(32, R(tempReg1), MComplex(tempReg2, tempReg1, SCALE_4, 0));
+
+	MOV(32, R(RCX), R(xReg));
+	AND(32, R(RCX), Imm8(3));
+	SHL(32, R(RCX), Imm8(2));
+	SHR(32, R(tempReg1), R(CL));
+	SHL(32, R(tempReg1), Imm8(28));
+	SAR(32, R(tempReg1), Imm8(28));
+
+	// Alpha gets it too, but we replace it with stencil anyway.
+	MOVD_xmm(fpScratchReg1, R(tempReg1));
+	PSHUFLW(fpScratchReg1, R(fpScratchReg1), _MM_SHUFFLE(0, 0, 0, 0));
+	PADDW(colorReg, R(fpScratchReg1));
+	return true;
+}
+
+bool PixelJitCache::Jit_CalculateFramebufferPtr(const PixelFuncID &id) {
+	// fb.data + (x + y * stride) * bpp, kept in ptrReg for blending and writing.
+	MOV(PTRBITS, R(ptrReg), MatPtr(&fb.data, ptrReg));
+	MOV(32, R(tempReg2), MatPtr(&gstate.fbwidth, tempReg2));
+	AND(32, R(tempReg2), Imm32(0x7FC));
+	IMUL(32, tempReg2, R(yReg));
+	ADD(32, R(tempReg2), R(xReg));
+	LEA(64, ptrReg, MComplex(ptrReg, tempReg2, id.fbFormat == GE_FORMAT_8888 ? SCALE_4 : SCALE_2, 0));
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteColor(const PixelFuncID &id) {
+	// This clamps to 0-255, giving us RGBX in tempReg1.
+	PACKUSWB(colorReg, R(colorReg));
+	MOVD_xmm(R(tempReg1), colorReg);
+
+	// Without a stencil test, the stencil (alpha) bits are always kept.
+	switch (GEBufferFormat(id.fbFormat)) {
+	case GE_FORMAT_8888:
+		MOV(32, R(tempReg2), MatR(ptrReg));
+		AND(32, R(tempReg1), Imm32(0x00FFFFFF));
+		if (id.applyColorWriteMask) {
+			// Alpha is already the same, so only the RGB part of the mask matters.
+			// new = new ^ ((new ^ old) & mask)
+			MOV(32, R(RCX), MatPtr(&gstate.pmskc, RCX));
+			AND(32, R(RCX), Imm32(0x00FFFFFF));
+			XOR(32, R(tempReg2), R(tempReg1));
+			AND(32, R(tempReg2), R(RCX));
+			XOR(32, R(tempReg1), R(tempReg2));
+			MOV(32, R(tempReg2), MatR(ptrReg));
+		}
+		AND(32, R(tempReg2), Imm32(0xFF000000));
+		OR(32, R(tempReg1), R(tempReg2));
+		MOV(32, MatR(ptrReg), R(tempReg1));
+		break;
+
+	case GE_FORMAT_565:
+		// Same as RGBA8888ToRGB565().
+		MOV(32, R(tempReg2), R(tempReg1));
+		SHR(32, R(tempReg2), Imm8(3));
+		AND(32, R(tempReg2), Imm32(0x001F));
+		MOV(32, R(RCX), R(tempReg1));
+		SHR(32, R(RCX), Imm8(5));
+		AND(32, R(RCX), Imm32(0x07E0));
+		OR(32, R(tempReg2), R(RCX));
+		SHR(32, R(tempReg1), Imm8(8));
+		AND(32, R(tempReg1), Imm32(0xF800));
+		OR(32, R(tempReg2), R(tempReg1));
+		MOV(16, MatR(ptrReg), R(tempReg2));
+		break;
+
+	case GE_FORMAT_5551:
+		// Same as RGBA8888ToRGBA5551().
+		MOV(32, R(tempReg2), R(tempReg1));
+		SHR(32, R(tempReg2), Imm8(3));
+		AND(32, R(tempReg2), Imm32(0x001F));
+		MOV(32, R(RCX), R(tempReg1));
+		SHR(32, R(RCX), Imm8(6));
+		AND(32, R(RCX), Imm32(0x03E0));
+		OR(32, R(tempReg2), R(RCX));
+		SHR(32, R(tempReg1), Imm8(9));
+		AND(32, R(tempReg1), Imm32(0x7C00));
+		OR(32, R(tempReg2), R(tempReg1));
+		MOVZX(32, 16, RCX, MatR(ptrReg));
+		AND(32, R(RCX), Imm32(0x8000));
+		OR(32, R(tempReg2), R(RCX));
+		MOV(16, MatR(ptrReg), R(tempReg2));
+		break;
+
+	case GE_FORMAT_4444:
+		// Same as RGBA8888ToRGBA4444().
+		SHR(32, R(tempReg1), Imm8(4));
+		MOV(32, R(tempReg2), R(tempReg1));
+		AND(32, R(tempReg2), Imm32(0x000F));
+		MOV(32, R(RCX), R(tempReg1));
+		SHR(32, R(RCX), Imm8(4));
+		AND(32, R(RCX), Imm32(0x00F0));
+		OR(32, R(tempReg2), R(RCX));
+		SHR(32, R(tempReg1), Imm8(8));
+		AND(32, R(tempReg1), Imm32(0x0F00));
+		OR(32, R(tempReg2), R(tempReg1));
+		MOVZX(32, 16, RCX, MatR(ptrReg));
+		AND(32, R(RCX), Imm32(0xF000));
+		OR(32, R(tempReg2), R(RCX));
+		MOV(16, MatR(ptrReg), R(tempReg2));
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+};
+
+#endif
@@ -318,7 +318,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 	if (indices)
 		GetIndexBounds(indices, vertex_count, vertex_type, &index_lower_bound, &index_upper_bound);
-	vdecoder.DecodeVerts(buf, vertices, index_lower_bound, index_upper_bound);
+	drawEngine->DecodeVertsCached(&vdecoder, buf, vertices, index_lower_bound, index_upper_bound);
 
 	VertexReader vreader(buf, vtxfmt, vertex_type);
 
@@ -820,6 +820,10 @@ void DrawEngineVulkan::DoFlush() {
 
 			shaderManager_->GetShaders(prim, lastVType_, &vshader, &fshader, true, useHWTessellation_, decOptions_.expandAllWeightsToFloat);  // usehwtransform
 			_dbg_assert_msg_(vshader->UseHWTransform(), "Bad vshader");
+			if (g_Config.bSkipDrawsWithPendingShaders && !(vshader->IsReady() && fshader->IsReady())) {
+				SkipPendingShaderDraw();
+				return;
+			}
 
 			Draw::NativeObject object = framebufferManager_->UseBufferedRendering() ? Draw::NativeObject::FRAMEBUFFER_RENDERPASS : Draw::NativeObject::BACKBUFFER_RENDERPASS;
 			VkRenderPass renderPass = (VkRenderPass)draw_->GetNativeObject(object);
@@ -941,6 +945,10 @@ void DrawEngineVulkan::DoFlush() {
 			if (!lastPipeline_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE) || prim != lastPrim_) {
 				shaderManager_->GetShaders(prim, lastVType_, &vshader, &fshader, false, false, decOptions_.expandAllWeightsToFloat);  // usehwtransform
 				_dbg_assert_msg_(!vshader->UseHWTransform(), "Bad vshader");
+				if (g_Config.bSkipDrawsWithPendingShaders && !(vshader->IsReady() && fshader->IsReady())) {
+					SkipPendingShaderDraw();
+					return;
+				}
 				if (prim != lastPrim_ || gstate_c.IsDirty(DIRTY_BLEND_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_RASTER_STATE | DIRTY_DEPTHSTENCIL_STATE)) {
 					ConvertStateToVulkanKey(*framebufferManager_, shaderManager_, prim, pipelineKey_, dynState_);
 				}
@@ -1024,6 +1032,19 @@ void DrawEngineVulkan::DoFlush() {
 	gpuStats.numDrawCalls += numDrawCalls;
 	gpuStats.numVertsSubmitted += vertexCountInDrawCalls_;
 
+	ResetAfterDraw();
+	GPUDebug::NotifyDraw();
+}
+
+// The shaders are still compiling on the background threads. Rather than stall, we drop the draw,
+// and make sure the shaders get looked up again next time since we didn't bind a matching pipeline.
+void DrawEngineVulkan::SkipPendingShaderDraw() {
+	gstate_c.Dirty(DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE);
+	lastPipeline_ = nullptr;
+	ResetAfterDraw();
+}
+
+void DrawEngineVulkan::ResetAfterDraw() {
 	indexGen.Reset();
 	decodedVerts_ = 0;
 	numDrawCalls = 0;
@@ -1039,8 +1060,6 @@ void DrawEngineVulkan::DoFlush() {
 	gstate_c.vertBounds.minV = 512;
 	gstate_c.vertBounds.maxU = 0;
 	gstate_c.vertBounds.maxV = 0;
-
-	GPUDebug::NotifyDraw();
 }
 
 void DrawEngineVulkan::UpdateUBOs(FrameData *frame) {
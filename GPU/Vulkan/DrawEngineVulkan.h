@@ -208,6 +208,8 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	VkResult RecreateDescriptorPool(FrameData &frame, int newSize);
 
 	void DoFlush();
+	void SkipPendingShaderDraw();
+	void ResetAfterDraw();
 	void UpdateUBOs(FrameData *frame);
 
 	VkDescriptorSet GetOrCreateDescriptorSet(VkImageView imageView, VkSampler sampler, VkBuffer base, VkBuffer light, VkBuffer bone, bool tess);
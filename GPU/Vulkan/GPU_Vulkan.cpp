@@ -104,6 +104,7 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".vkshadercache";
+		spirvCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) + "/" + discID + ".vkspirv";
 		shaderCacheLoaded_ = false;
 
 		std::thread th([&] {
@@ -127,6 +128,18 @@ void GPU_Vulkan::CancelReady() {
 void GPU_Vulkan::LoadCache(std::string filename) {
 	PSP_SetLoading("Loading shader cache...");
 	// Actually precompiled by IsReady() since we're single-threaded.
+	// Load the SPIR-V first, so the shader compiles queued by the ID cache below turn into cache hits.
+	// It doesn't depend on the GPU, so it stays useful even if the rest of the cache is rejected.
+	FILE *spirvFile = File::OpenCFile(spirvCachePath_, "rb");
+	if (spirvFile) {
+		bool spirvResult = shaderManagerVulkan_->LoadSPIRVCache(spirvFile);
+		fclose(spirvFile);
+		if (!spirvResult) {
+			WARN_LOG(G3D, "Bad SPIR-V cache - rebuilding.");
+			File::Delete(spirvCachePath_);
+		}
+	}
+
 	FILE *f = File::OpenCFile(filename, "rb");
 	if (!f)
 		return;
@@ -156,6 +169,14 @@ void GPU_Vulkan::SaveCache(std::string filename) {
 		return;
 	}
 
+	if (!spirvCachePath_.empty() && shaderManagerVulkan_->SPIRVCacheDirty()) {
+		FILE *spirvFile = File::OpenCFile(spirvCachePath_, "wb");
+		if (spirvFile) {
+			shaderManagerVulkan_->SaveSPIRVCache(spirvFile);
+			fclose(spirvFile);
+		}
+	}
+
 	FILE *f = File::OpenCFile(filename, "wb");
 	if (!f)
 		return;
@@ -451,7 +472,7 @@ void GPU_Vulkan::FinishDeferred() {
 
 inline void GPU_Vulkan::CheckFlushOp(int cmd, u32 diff) {
 	const u8 cmdFlags = cmdInfo_[cmd].flags;
-	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE)) {
+	if (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE) && NeedsFlushOnChange(cmd)) {
 		if (dumpThisFrame_) {
 			NOTICE_LOG(G3D, "================ FLUSH ================");
 		}
@@ -563,13 +584,17 @@ void GPU_Vulkan::GetStats(char *buffer, size_t bufsize) {
 	const DrawEngineVulkanStats &drawStats = drawEngine_.GetStats();
 	char texStats[256];
 	textureCacheVulkan_->GetStats(texStats, sizeof(texStats));
+	char compilerStats[256];
+	shaderManagerVulkan_->GetCompilerStats(compilerStats, sizeof(compilerStats));
 	snprintf(buffer, bufsize,
 		"Vertex, Fragment, Pipelines loaded: %i, %i, %i\n"
+		"%s\n"
 		"Pushbuffer space used: UBO %d, Vtx %d, Idx %d\n"
 		"%s\n",
 		shaderManagerVulkan_->GetNumVertexShaders(),
 		shaderManagerVulkan_->GetNumFragmentShaders(),
 		pipelineManager_->GetNumPipelines(),
+		compilerStats,
 		drawStats.pushUBOSpaceUsed,
 		drawStats.pushVertexSpaceUsed,
 		drawStats.pushIndexSpaceUsed,
@@ -29,6 +29,8 @@
 #include "Common/StringUtils.h"
 #include "Common/GPU/Vulkan/VulkanContext.h"
 #include "Common/GPU/Vulkan/VulkanMemory.h"
+#include "Common/GPU/Vulkan/VulkanShaderCompiler.h"
+#include "Common/Thread/WorkerPool.h"
 #include "Common/Log.h"
 #include "Common/Common.h"
 #include "Core/Config.h"
@@ -42,18 +44,12 @@
 #include "GPU/Vulkan/DrawEngineVulkan.h"
 #include "GPU/Vulkan/FramebufferManagerVulkan.h"
 
-VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, const char *code)
-	: vulkan_(vulkan), id_(id), failed_(false), module_(0) {
-	PROFILE_THIS_SCOPE("shadercomp");
-	source_ = code;
-
-	std::string errorMessage;
-	std::vector<uint32_t> spirv;
-#ifdef SHADERLOG
-	OutputDebugStringA(LineNumberString(code).c_str());
-#endif
+// Turns a finished compile job into a shader module, reporting any errors. Called lazily on first use.
+static bool CreateModuleFromJob(VulkanContext *vulkan, VulkanShaderCompileJob *job, const std::string &code, VkShaderModule *module) {
+	job->Wait();
 
-	bool success = GLSLtoSPV(VK_SHADER_STAGE_FRAGMENT_BIT, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+	const std::string &errorMessage = job->ErrorMessage();
+	bool success = job->Succeeded();
 	if (!errorMessage.empty()) {
 		if (success) {
 			ERROR_LOG(G3D, "Warnings in shader compilation!");
@@ -61,26 +57,33 @@ VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id,
 			ERROR_LOG(G3D, "Error in shader compilation!");
 		}
 		ERROR_LOG(G3D, "Messages: %s", errorMessage.c_str());
-		ERROR_LOG(G3D, "Shader source:\n%s", code);
+		ERROR_LOG(G3D, "Shader source:\n%s", code.c_str());
 #ifdef SHADERLOG
 		OutputDebugStringA(LineNumberString(code).c_str());
-		OutputDebugStringA("Messages:\n");
-		OutputDebugStringA(errorMessage.c_str());
+		OutputDebugStringUTF8("Messages:\n");
+		OutputDebugStringUTF8(errorMessage.c_str());
 #endif
-		Reporting::ReportMessage("Vulkan error in shader compilation: info: %s / code: %s", errorMessage.c_str(), code);
+		Reporting::ReportMessage("Vulkan error in shader compilation: info: %s / code: %s", errorMessage.c_str(), code.c_str());
 	} else {
-		success = vulkan_->CreateShaderModule(spirv, &module_);
+		success = vulkan->CreateShaderModule(job->SPIRV(), module);
 #ifdef SHADERLOG
 		OutputDebugStringA("OK\n");
 #endif
 	}
 
 	if (!success) {
-		failed_ = true;
-		return;
-	} else {
-		VERBOSE_LOG(G3D, "Compiled fragment shader:\n%s\n", (const char *)code);
+		*module = VK_NULL_HANDLE;
 	}
+	return success;
+}
+
+VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, VulkanShaderCompiler *compiler, FShaderID id, const char *code)
+	: vulkan_(vulkan), id_(id), failed_(false), module_(VK_NULL_HANDLE) {
+	source_ = code;
+#ifdef SHADERLOG
+	OutputDebugStringA(LineNumberString(code).c_str());
+#endif
+	job_ = compiler->Compile(VK_SHADER_STAGE_FRAGMENT_BIT, source_);
 }
 
 VulkanFragmentShader::~VulkanFragmentShader() {
@@ -89,6 +92,26 @@ VulkanFragmentShader::~VulkanFragmentShader() {
 	}
 }
 
+bool VulkanFragmentShader::IsReady() const {
+	return module_ != VK_NULL_HANDLE || failed_ || job_->IsReady();
+}
+
+bool VulkanFragmentShader::Failed() {
+	GetModule();
+	return failed_;
+}
+
+VkShaderModule VulkanFragmentShader::GetModule() {
+	if (module_ == VK_NULL_HANDLE && !failed_) {
+		if (CreateModuleFromJob(vulkan_, job_.get(), source_, &module_)) {
+			VERBOSE_LOG(G3D, "Compiled fragment shader:\n%s\n", source_.c_str());
+		} else {
+			failed_ = true;
+		}
+	}
+	return module_;
+}
+
 std::string VulkanFragmentShader::GetShaderString(DebugShaderStringType type) const {
 	switch (type) {
 	case SHADER_STRING_SOURCE_CODE:
@@ -100,44 +123,13 @@ std::string VulkanFragmentShader::GetShaderString(DebugShaderStringType type) co
 	}
 }
 
-VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, const char *code, bool useHWTransform)
+VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VulkanShaderCompiler *compiler, VShaderID id, const char *code, bool useHWTransform)
 	: vulkan_(vulkan), id_(id), failed_(false), useHWTransform_(useHWTransform), module_(VK_NULL_HANDLE) {
-	PROFILE_THIS_SCOPE("shadercomp");
 	source_ = code;
-	std::string errorMessage;
-	std::vector<uint32_t> spirv;
 #ifdef SHADERLOG
 	OutputDebugStringA(LineNumberString(code).c_str());
 #endif
-	bool success = GLSLtoSPV(VK_SHADER_STAGE_VERTEX_BIT, code, GLSLVariant::VULKAN, spirv, &errorMessage);
-	if (!errorMessage.empty()) {
-		if (success) {
-			ERROR_LOG(G3D, "Warnings in shader compilation!");
-		} else {
-			ERROR_LOG(G3D, "Error in shader compilation!");
-		}
-		ERROR_LOG(G3D, "Messages: %s", errorMessage.c_str());
-		ERROR_LOG(G3D, "Shader source:\n%s", code);
-#ifdef SHADERLOG
-		OutputDebugStringA(LineNumberString(code).c_str());
-		OutputDebugStringUTF8("Messages:\n");
-		OutputDebugStringUTF8(errorMessage.c_str());
-#endif
-		Reporting::ReportMessage("Vulkan error in shader compilation: info: %s / code: %s", errorMessage.c_str(), code);
-	} else {
-		success = vulkan_->CreateShaderModule(spirv, &module_);
-#ifdef SHADERLOG
-		OutputDebugStringA("OK\n");
-#endif
-	}
-
-	if (!success) {
-		failed_ = true;
-		module_ = VK_NULL_HANDLE;
-		return;
-	} else {
-		VERBOSE_LOG(G3D, "Compiled vertex shader:\n%s\n", (const char *)code);
-	}
+	job_ = compiler->Compile(VK_SHADER_STAGE_VERTEX_BIT, source_);
 }
 
 VulkanVertexShader::~VulkanVertexShader() {
@@ -146,6 +138,26 @@ VulkanVertexShader::~VulkanVertexShader() {
 	}
 }
 
+bool VulkanVertexShader::IsReady() const {
+	return module_ != VK_NULL_HANDLE || failed_ || job_->IsReady();
+}
+
+bool VulkanVertexShader::Failed() {
+	GetModule();
+	return failed_;
+}
+
+VkShaderModule VulkanVertexShader::GetModule() {
+	if (module_ == VK_NULL_HANDLE && !failed_) {
+		if (CreateModuleFromJob(vulkan_, job_.get(), source_, &module_)) {
+			VERBOSE_LOG(G3D, "Compiled vertex shader:\n%s\n", source_.c_str());
+		} else {
+			failed_ = true;
+		}
+	}
+	return module_;
+}
+
 std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) const {
 	switch (type) {
 	case SHADER_STRING_SOURCE_CODE:
@@ -160,6 +172,7 @@ std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) cons
 ShaderManagerVulkan::ShaderManagerVulkan(Draw::DrawContext *draw, VulkanContext *vulkan)
 	: ShaderManagerCommon(draw), vulkan_(vulkan), compat_(GLSL_VULKAN), fsCache_(16), vsCache_(16) {
 	codeBuffer_ = new char[16384];
+	compiler_ = new VulkanShaderCompiler(WorkerPool::DefaultThreadCount());
 	uboAlignment_ = vulkan_->GetPhysicalDeviceProperties().properties.limits.minUniformBufferOffsetAlignment;
 	memset(&ub_base, 0, sizeof(ub_base));
 	memset(&ub_lights, 0, sizeof(ub_lights));
@@ -172,6 +185,7 @@ ShaderManagerVulkan::ShaderManagerVulkan(Draw::DrawContext *draw, VulkanContext
 
 ShaderManagerVulkan::~ShaderManagerVulkan() {
 	ClearShaders();
+	delete compiler_;
 	delete[] codeBuffer_;
 }
 
@@ -267,7 +281,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 		uint32_t attributeMask = 0;  // Not used
 		bool success = GenerateVertexShader(VSID, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &genErrorString);
 		_assert_(success);
-		vs = new VulkanVertexShader(vulkan_, VSID, codeBuffer_, useHWTransform);
+		vs = new VulkanVertexShader(vulkan_, compiler_, VSID, codeBuffer_, useHWTransform);
 		vsCache_.Insert(VSID, vs);
 	}
 	lastVSID_ = VSID;
@@ -280,7 +294,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 		uint64_t uniformMask = 0;  // Not used
 		bool success = GenerateFragmentShader(FSID, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &genErrorString);
 		_assert_(success);
-		fs = new VulkanFragmentShader(vulkan_, FSID, codeBuffer_);
+		fs = new VulkanFragmentShader(vulkan_, compiler_, FSID, codeBuffer_);
 		fsCache_.Insert(FSID, fs);
 	}
 
@@ -363,7 +377,8 @@ VulkanFragmentShader *ShaderManagerVulkan::GetFragmentShaderFromModule(VkShaderM
 //
 // We simply store the IDs of the shaders used during gameplay. On next startup of
 // the same game, we simply compile all the shaders from the start, so we don't have to
-// compile them on the fly later. We also store the Vulkan pipeline cache, so if it contains
+// compile them on the fly later. The compiles are queued on the compiler's worker threads,
+// and mostly turn into SPIR-V cache hits if the SPIR-V cache was loaded first. We also store the Vulkan pipeline cache, so if it contains
 // pipelines compiled from SPIR-V matching these shaders, pipeline creation will be practically
 // instantaneous.
 
@@ -401,7 +416,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		if (!GenerateVertexShader(id, codeBuffer_, compat_, draw_->GetBugs(), &attributeMask, &uniformMask, &genErrorString)) {
 			return false;
 		}
-		VulkanVertexShader *vs = new VulkanVertexShader(vulkan_, id, codeBuffer_, useHWTransform);
+		VulkanVertexShader *vs = new VulkanVertexShader(vulkan_, compiler_, id, codeBuffer_, useHWTransform);
 		vsCache_.Insert(id, vs);
 	}
 	uint32_t vendorID = vulkan_->GetPhysicalDeviceProperties().properties.vendorID;
@@ -417,7 +432,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 		if (!GenerateFragmentShader(id, codeBuffer_, compat_, draw_->GetBugs(), &uniformMask, &genErrorString)) {
 			return false;
 		}
-		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan_, id, codeBuffer_);
+		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan_, compiler_, id, codeBuffer_);
 		fsCache_.Insert(id, fs);
 	}
 
@@ -446,3 +461,21 @@ void ShaderManagerVulkan::SaveCache(FILE *f) {
 		NOTICE_LOG(G3D, "Saved %d vertex and %d fragment shaders", header.numVertexShaders, header.numFragmentShaders);
 	}
 }
+
+bool ShaderManagerVulkan::LoadSPIRVCache(FILE *f) {
+	return compiler_->LoadCache(f);
+}
+
+void ShaderManagerVulkan::SaveSPIRVCache(FILE *f) {
+	compiler_->SaveCache(f);
+}
+
+bool ShaderManagerVulkan::SPIRVCacheDirty() {
+	return compiler_->CacheDirty();
+}
+
+void ShaderManagerVulkan::GetCompilerStats(char *buffer, size_t bufsize) {
+	VulkanShaderCompilerStats stats = compiler_->GetStats();
+	snprintf(buffer, bufsize, "SPIR-V: %d compiled (%0.1f ms), %d cache hits, %d pending, %d failed",
+		stats.compiled, stats.compileSeconds * 1000.0, stats.cacheHits, stats.pending, stats.failed);
+}
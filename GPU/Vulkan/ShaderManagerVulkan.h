@@ -19,6 +19,7 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <memory>
 
 #include "Common/Data/Collections/Hashmaps.h"
 #include "Common/GPU/Vulkan/VulkanMemory.h"
@@ -32,24 +33,31 @@
 
 class VulkanContext;
 class VulkanPushBuffer;
+class VulkanShaderCompiler;
+class VulkanShaderCompileJob;
 
+// The SPIR-V for these is compiled in the background by VulkanShaderCompiler. The module is created
+// on first use of GetModule(), which waits for the compile if it hasn't finished yet. Use IsReady()
+// to check without blocking.
 class VulkanFragmentShader {
 public:
-	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, const char *code);
+	VulkanFragmentShader(VulkanContext *vulkan, VulkanShaderCompiler *compiler, FShaderID id, const char *code);
 	~VulkanFragmentShader();
 
 	const std::string &source() const { return source_; }
 
-	bool Failed() const { return failed_; }
+	bool IsReady() const;
+	bool Failed();
 
 	std::string GetShaderString(DebugShaderStringType type) const;
-	VkShaderModule GetModule() const { return module_; }
+	VkShaderModule GetModule();
 	const FShaderID &GetID() { return id_; }
 
 protected:	
 	VkShaderModule module_;
 
 	VulkanContext *vulkan_;
+	std::shared_ptr<VulkanShaderCompileJob> job_;
 	std::string source_;
 	bool failed_;
 	FShaderID id_;
@@ -57,22 +65,24 @@ class VulkanFragmentShader {
 
 class VulkanVertexShader {
 public:
-	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, const char *code, bool useHWTransform);
+	VulkanVertexShader(VulkanContext *vulkan, VulkanShaderCompiler *compiler, VShaderID id, const char *code, bool useHWTransform);
 	~VulkanVertexShader();
 
 	const std::string &source() const { return source_; }
 
-	bool Failed() const { return failed_; }
+	bool IsReady() const;
+	bool Failed();
 	bool UseHWTransform() const { return useHWTransform_; }
 
 	std::string GetShaderString(DebugShaderStringType type) const;
-	VkShaderModule GetModule() const { return module_; }
+	VkShaderModule GetModule();
 	const VShaderID &GetID() { return id_; }
 
 protected:
 	VkShaderModule module_;
 
 	VulkanContext *vulkan_;
+	std::shared_ptr<VulkanShaderCompileJob> job_;
 	std::string source_;
 	bool failed_;
 	bool useHWTransform_;
@@ -127,10 +137,17 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	bool LoadCache(FILE *f);
 	void SaveCache(FILE *f);
 
+	// The SPIR-V cache is separate from the ID cache above, it's content-addressed and independent of GPU features.
+	bool LoadSPIRVCache(FILE *f);
+	void SaveSPIRVCache(FILE *f);
+	bool SPIRVCacheDirty();
+	void GetCompilerStats(char *buffer, size_t bufsize);
+
 private:
 	void Clear();
 
 	VulkanContext *vulkan_;
+	VulkanShaderCompiler *compiler_;
 	ShaderLanguageDesc compat_;
 
 	typedef DenseHashMap<FShaderID, VulkanFragmentShader *, nullptr> FSCache;
@@ -21,6 +21,7 @@
 #include <map>
 #include <memory>
 #include <algorithm>
+#include <thread>
 
 #include "Common/GPU/thin3d.h"
 #include "Common/Thread/PrioritizedWorkQueue.h"
@@ -38,6 +39,7 @@
 #include "Core/Util/GameManager.h"
 #include "Core/Config.h"
 #include "UI/GameInfoCache.h"
+#include "UI/GameInfoIndex.h"
 #include "UI/TextureUtil.h"
 
 GameInfoCache *g_gameInfoCache;
@@ -330,18 +332,37 @@ static bool ReadVFSToString(const char *filename, std::string *contents, std::mu
 	return data != nullptr;
 }
 
+// For games without an ICON0.PNG of their own.
+static void ReadFallbackIcon(GameInfo *info) {
+	std::string screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) + info->id + "_00000.jpg";
+	std::string screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) + info->id + "_00000.png";
+	std::lock_guard<std::mutex> lock(info->lock);
+	// Try using png/jpg screenshots first
+	if (File::Exists(screenshot_png)) {
+		readFileToString(false, screenshot_png.c_str(), info->icon.data);
+	} else if (File::Exists(screenshot_jpg)) {
+		readFileToString(false, screenshot_jpg.c_str(), info->icon.data);
+	} else {
+		DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
+		ReadVFSToString("unknown.png", &info->icon.data, nullptr);
+	}
+}
 
 class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 public:
-	GameInfoWorkItem(const std::string &gamePath, std::shared_ptr<GameInfo> &info)
-		: gamePath_(gamePath), info_(info) {
+	GameInfoWorkItem(const std::string &gamePath, std::shared_ptr<GameInfo> &info, GameInfoIndex *index)
+		: gamePath_(gamePath), info_(info), index_(index) {
+		remote_ = startsWith(gamePath, "http://") || startsWith(gamePath, "https://");
 	}
 
 	~GameInfoWorkItem() override {
+		std::lock_guard<std::mutex> guard(info_->loadLock);
 		info_->DisposeFileLoader();
 	}
 
 	void run() override {
+		// Another worker may be loading the same game with different flags, wait for it.
+		std::lock_guard<std::mutex> guard(info_->loadLock);
 		if (!info_->LoadFromPath(gamePath_)) {
 			info_->pending = false;
 			return;
@@ -353,6 +374,102 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 		}
 
 		info_->working = true;
+
+		// PBP directories are keyed by their EBOOT.PBP, since that's what changes.
+		File::FileDetails details{};
+		bool indexable = !remote_ && File::GetFileDetails(gamePath_, &details);
+		if (indexable && details.isDirectory)
+			indexable = File::GetFileDetails(ResolvePBPFile(gamePath_), &details) && !details.isDirectory;
+
+		// Sound is only wanted for the selected game, so it's never indexed.
+		GameInfoIndexEntry entry;
+		const int indexedFlags = info_->wantFlags & GAMEINFO_WANTBG;
+		bool fromIndex = indexable && (info_->wantFlags & GAMEINFO_WANTSND) == 0;
+		fromIndex = fromIndex && index_->Lookup(gamePath_, details.size, details.mtime, (indexedFlags & GAMEINFO_WANTBG) != 0, &entry);
+		fromIndex = fromIndex && (entry.contents & indexedFlags) == indexedFlags;
+
+		if (fromIndex) {
+			LoadFromIndex(entry);
+		} else {
+			entry = GameInfoIndexEntry();
+			entry.contents = indexedFlags;
+			if (!Scan(&entry, &indexable))
+				return;
+		}
+
+		info_->hasConfig = g_Config.hasGameConfig(info_->id);
+
+		if (info_->wantFlags & GAMEINFO_WANTSIZE) {
+			std::lock_guard<std::mutex> lock(info_->lock);
+			if (entry.contents & GAMEINFO_WANTSIZE) {
+				info_->gameSize = entry.gameSize;
+			} else {
+				info_->gameSize = info_->GetGameSizeInBytes();
+				entry.gameSize = info_->gameSize;
+				entry.contents |= GAMEINFO_WANTSIZE;
+				// Store it below, this can take a while for PBP directories.
+				fromIndex = false;
+			}
+			info_->saveDataSize = info_->GetSaveDataSizeInBytes();
+			info_->installDataSize = info_->GetInstallDataSizeInBytes();
+		}
+
+		if (indexable && !fromIndex) {
+			entry.fileSize = details.size;
+			entry.mtime = details.mtime;
+			index_->Store(gamePath_, entry);
+		}
+
+		info_->pending = false;
+		info_->working = false;
+		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
+	}
+
+	float priority() override {
+		if (remote_) {
+			// Increase the value so remote info loads after non-remote.
+			return info_->lastAccessedTime + 1000.0f;
+		}
+		return info_->lastAccessedTime;
+	}
+
+private:
+	void LoadFromIndex(const GameInfoIndexEntry &entry) {
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->fileType = (IdentifiedFileType)entry.fileType;
+			if (!entry.paramSFO.empty()) {
+				info_->paramSFO.ReadSFO((const u8 *)entry.paramSFO.data(), entry.paramSFO.size());
+				info_->ParseParamSFO();
+			}
+			info_->id = entry.id;
+			info_->id_version = entry.id_version;
+			info_->region = entry.region;
+
+			if (info_->wantFlags & GAMEINFO_WANTBG) {
+				if (!entry.pic0.empty()) {
+					info_->pic0.data = entry.pic0;
+					info_->pic0.dataLoaded = true;
+				}
+				if (!entry.pic1.empty()) {
+					info_->pic1.data = entry.pic1;
+					info_->pic1.dataLoaded = true;
+				}
+			}
+			if (!entry.icon.empty())
+				info_->icon.data = entry.icon;
+		}
+
+		if (entry.icon.empty())
+			ReadFallbackIcon(info_.get());
+		info_->icon.dataLoaded = true;
+	}
+
+	// Reads everything from the file itself.  Returns false if it couldn't be read at all.
+	// Fills entry and leaves indexable as true only for types the index can describe.
+	bool Scan(GameInfoIndexEntry *entry, bool *indexable) {
+		// Only PBPs and ISOs are worth indexing, everything else is quick to look at.
+		bool scanned = false;
 		info_->fileType = Identify_File(info_->GetFileLoader().get());
 		switch (info_->fileType) {
 		case IdentifiedFileType::PSP_PBP:
@@ -374,8 +491,9 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 					ERROR_LOG(LOADER, "invalid pbp %s\n", pbpLoader->Path().c_str());
 					info_->pending = false;
 					info_->working = false;
-					return;
+					return false;
 				}
+				scanned = true;
 
 				// First, PARAM.SFO.
 				std::vector<u8> sfoData;
@@ -383,6 +501,7 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					info_->paramSFO.ReadSFO(sfoData);
 					info_->ParseParamSFO();
+					entry->paramSFO.assign((const char *)sfoData.data(), sfoData.size());
 
 					// Assuming PSP_PBP_DIRECTORY without ID or with disc_total < 1 in GAME dir must be homebrew
 					if ((info_->id.empty() || !info_->disc_total)
@@ -398,17 +517,9 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				if (pbp.GetSubFileSize(PBP_ICON0_PNG) > 0) {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					pbp.GetSubFileAsString(PBP_ICON0_PNG, &info_->icon.data);
+					entry->icon = info_->icon.data;
 				} else {
-					std::string screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.jpg";
-					std::string screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.png";
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						readFileToString(false, screenshot_png.c_str(), info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						readFileToString(false, screenshot_jpg.c_str(), info_->icon.data);
-					else
-						// Read standard icon
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
+					ReadFallbackIcon(info_.get());
 				}
 				info_->icon.dataLoaded = true;
 
@@ -416,11 +527,13 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 					if (pbp.GetSubFileSize(PBP_PIC0_PNG) > 0) {
 						std::lock_guard<std::mutex> lock(info_->lock);
 						pbp.GetSubFileAsString(PBP_PIC0_PNG, &info_->pic0.data);
+						entry->pic0 = info_->pic0.data;
 						info_->pic0.dataLoaded = true;
 					}
 					if (pbp.GetSubFileSize(PBP_PIC1_PNG) > 0) {
 						std::lock_guard<std::mutex> lock(info_->lock);
 						pbp.GetSubFileAsString(PBP_PIC1_PNG, &info_->pic1.data);
+						entry->pic1 = info_->pic1.data;
 						info_->pic1.dataLoaded = true;
 					}
 				}
@@ -537,21 +650,21 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				info_->fileType = IdentifiedFileType::PSP_ISO;
 				SequentialHandleAllocator handles;
 				// Let's assume it's an ISO.
-				// TODO: This will currently read in the whole directory tree. Not really necessary for just a
-				// few files.
+				// Directories are only read as the paths below need them, so this touches few sectors.
 				auto fl = info_->GetFileLoader();
 				if (!fl) {
 					info_->pending = false;
 					info_->working = false;
-					return;  // Happens with UWP currently, TODO...
+					return false;  // Happens with UWP currently, TODO...
 				}
 				BlockDevice *bd = constructBlockDevice(info_->GetFileLoader().get());
 				if (!bd) {
 					info_->pending = false;
 					info_->working = false;
-					return;  // nothing to do here..
+					return false;  // nothing to do here..
 				}
 				ISOFileSystem umd(&handles, bd);
+				scanned = true;
 
 				// Alright, let's fetch the PARAM.SFO.
 				std::string paramSFOcontents;
@@ -559,11 +672,14 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					info_->paramSFO.ReadSFO((const u8 *)paramSFOcontents.data(), paramSFOcontents.size());
 					info_->ParseParamSFO();
+					entry->paramSFO = paramSFOcontents;
 
 					if (info_->wantFlags & GAMEINFO_WANTBG) {
 						ReadFileToString(&umd, "/PSP_GAME/PIC0.PNG", &info_->pic0.data, nullptr);
+						entry->pic0 = info_->pic0.data;
 						info_->pic0.dataLoaded = true;
 						ReadFileToString(&umd, "/PSP_GAME/PIC1.PNG", &info_->pic1.data, nullptr);
+						entry->pic1 = info_->pic1.data;
 						info_->pic1.dataLoaded = true;
 					}
 					if (info_->wantFlags & GAMEINFO_WANTSND) {
@@ -573,18 +689,13 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				}
 
 				// Fall back to unknown icon if ISO is broken/is a homebrew ISO, override is allowed though
-				if (!ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
-					std::string screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.jpg";
-					std::string screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.png";
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						readFileToString(false, screenshot_png.c_str(), info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						readFileToString(false, screenshot_jpg.c_str(), info_->icon.data);
-					else {
-						DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
-					}
+				std::string icon;
+				if (ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &icon, nullptr)) {
+					std::lock_guard<std::mutex> lock(info_->lock);
+					info_->icon.data = icon;
+					entry->icon = std::move(icon);
+				} else {
+					ReadFallbackIcon(info_.get());
 				}
 				info_->icon.dataLoaded = true;
 				break;
@@ -620,32 +731,21 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				break;
 		}
 
-		info_->hasConfig = g_Config.hasGameConfig(info_->id);
-
-		if (info_->wantFlags & GAMEINFO_WANTSIZE) {
+		*indexable = *indexable && scanned;
+		if (*indexable) {
 			std::lock_guard<std::mutex> lock(info_->lock);
-			info_->gameSize = info_->GetGameSizeInBytes();
-			info_->saveDataSize = info_->GetSaveDataSizeInBytes();
-			info_->installDataSize = info_->GetInstallDataSizeInBytes();
+			entry->fileType = (int)info_->fileType;
+			entry->id = info_->id;
+			entry->id_version = info_->id_version;
+			entry->region = info_->region;
 		}
-
-		info_->pending = false;
-		info_->working = false;
-		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
+		return true;
 	}
 
-	float priority() override {
-		auto fl = info_->GetFileLoader();
-		if (fl && fl->IsRemote()) {
-			// Increase the value so remote info loads after non-remote.
-			return info_->lastAccessedTime + 1000.0f;
-		}
-		return info_->lastAccessedTime;
-	}
-
-private:
 	std::string gamePath_;
 	std::shared_ptr<GameInfo> info_;
+	GameInfoIndex *index_;
+	bool remote_;
 	DISALLOW_COPY_AND_ASSIGN(GameInfoWorkItem);
 };
 
@@ -659,8 +759,17 @@ GameInfoCache::~GameInfoCache() {
 }
 
 void GameInfoCache::Init() {
+	// The images are kept next to the index, so that loading it stays quick.
+	std::string cacheDir = GetSysDirectory(DIRECTORY_APP_CACHE);
+	std::string imageDir = cacheDir + "/GameInfoIndex";
+	if (!File::Exists(imageDir))
+		File::CreateFullPath(imageDir);
+	index_.Init(cacheDir + "/GameInfoIndex.ppidx", imageDir);
+
+	// Mostly waiting on storage, so a few threads help even on slower devices.
+	int threads = std::max(1, std::min((int)std::thread::hardware_concurrency(), 4));
 	gameInfoWQ_ = new PrioritizedWorkQueue();
-	ProcessWorkQueueOnThreadWhile(gameInfoWQ_);
+	ProcessWorkQueueOnThreadWhile(gameInfoWQ_, threads);
 }
 
 void GameInfoCache::Shutdown() {
@@ -671,6 +780,11 @@ void GameInfoCache::Shutdown() {
 		delete gameInfoWQ_;
 		gameInfoWQ_ = nullptr;
 	}
+	SaveIndex();
+}
+
+void GameInfoCache::SaveIndex() {
+	index_.Save();
 }
 
 void GameInfoCache::Clear() {
@@ -681,6 +795,7 @@ void GameInfoCache::Clear() {
 		gameInfoWQ_->WaitUntilDone();
 	}
 	info_.clear();
+	SaveIndex();
 }
 
 void GameInfoCache::CancelAll() {
@@ -773,7 +888,7 @@ std::shared_ptr<GameInfo> GameInfoCache::GetInfo(Draw::DrawContext *draw, const
 		info->pending = true;
 	}
 
-	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info);
+	GameInfoWorkItem *item = new GameInfoWorkItem(gamePath, info, &index_);
 	gameInfoWQ_->Add(item);
 
 	// Don't re-insert if we already have it.
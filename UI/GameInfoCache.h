@@ -24,6 +24,7 @@
 #include <atomic>
 
 #include "Core/ELF/ParamSFO.h"
+#include "UI/GameInfoIndex.h"
 #include "UI/TextureUtil.h"
 
 namespace Draw {
@@ -105,6 +106,8 @@ class GameInfo {
 	// and obviously also not when creating it and holding the only pointer
 	// to it.
 	std::mutex lock;
+	// Held while a work item loads this, so two with different flags don't overlap.
+	std::mutex loadLock;
 
 	std::string id;
 	std::string id_version;
@@ -170,12 +173,16 @@ class GameInfoCache {
 private:
 	void Init();
 	void Shutdown();
+	void SaveIndex();
 	void SetupTexture(std::shared_ptr<GameInfo> &info, Draw::DrawContext *draw, GameInfoTex &tex);
 
 	// Maps ISO path to info. Need to use shared_ptr as we can return these pointers - 
 	// and if they get destructed while being in use, that's bad.
 	std::map<std::string, std::shared_ptr<GameInfo> > info_;
 
+	// Remembers what was loaded for each game across runs.
+	GameInfoIndex index_;
+
 	// Work queue and management
 	PrioritizedWorkQueue *gameInfoWQ_;
 };
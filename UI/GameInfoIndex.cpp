@@ -0,0 +1,179 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+
+#include "ext/xxhash.h"
+
+#include "Common/File/FileUtil.h"
+#include "Common/Log.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Serialize/SerializeMap.h"
+#include "Core/Config.h"
+#include "UI/GameInfoIndex.h"
+
+void GameInfoIndexEntry::DoState(PointerWrap &p) {
+	auto s = p.Section("GameInfoIndexEntry", 1);
+	if (!s)
+		return;
+
+	Do(p, fileSize);
+	Do(p, mtime);
+	Do(p, contents);
+	Do(p, fileType);
+	Do(p, id);
+	Do(p, id_version);
+	Do(p, region);
+	Do(p, paramSFO);
+	Do(p, hasIcon);
+	Do(p, hasPic0);
+	Do(p, hasPic1);
+	Do(p, gameSize);
+}
+
+void GameInfoIndex::DoState(PointerWrap &p) {
+	// Version 1 had the images inline, just rescan those.
+	auto s = p.Section("GameInfoIndex", 2, 2);
+	if (!s)
+		return;
+
+	Do(p, entries_);
+}
+
+void GameInfoIndex::Init(const std::string &filename, const std::string &imageDir) {
+	std::lock_guard<std::mutex> guard(lock_);
+	filename_ = filename;
+	imageDir_ = imageDir;
+	entries_.clear();
+	loaded_ = false;
+	dirty_ = false;
+}
+
+void GameInfoIndex::LoadIfNeeded() {
+	if (loaded_)
+		return;
+	loaded_ = true;
+	if (!File::Exists(filename_))
+		return;
+
+	std::string gitVersion;
+	std::string errorString;
+	if (CChunkFileReader::Load(filename_, &gitVersion, *this, &errorString) != CChunkFileReader::ERROR_NONE) {
+		WARN_LOG(LOADER, "Discarding game info index %s: %s", filename_.c_str(), errorString.c_str());
+		entries_.clear();
+		return;
+	}
+
+	INFO_LOG(LOADER, "Loaded game info index with %d entries", (int)entries_.size());
+}
+
+std::string GameInfoIndex::ImageFilename(const std::string &path, const char *kind) const {
+	char name[64];
+	snprintf(name, sizeof(name), "/%016llx.%s", (unsigned long long)XXH3_64bits(path.data(), path.size()), kind);
+	return imageDir_ + name;
+}
+
+void GameInfoIndex::DeleteImages(const std::string &path, const GameInfoIndexEntry &entry) {
+	if (entry.hasIcon)
+		File::Delete(ImageFilename(path, "icon"));
+	if (entry.hasPic0)
+		File::Delete(ImageFilename(path, "pic0"));
+	if (entry.hasPic1)
+		File::Delete(ImageFilename(path, "pic1"));
+}
+
+bool GameInfoIndex::Save() {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!dirty_)
+		return true;
+
+	// Forget files that are gone, unless they were looked at this run (e.g. a remote file.)
+	for (auto it = entries_.begin(); it != entries_.end(); ) {
+		if (!it->second.used && !File::Exists(it->first)) {
+			DeleteImages(it->first, it->second);
+			it = entries_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (CChunkFileReader::Save(filename_, "GameInfoIndex", PPSSPP_GIT_VERSION, *this) != CChunkFileReader::ERROR_NONE) {
+		ERROR_LOG(LOADER, "Failed to save game info index %s", filename_.c_str());
+		return false;
+	}
+	dirty_ = false;
+	return true;
+}
+
+bool GameInfoIndex::Lookup(const std::string &path, u64 fileSize, u64 mtime, bool wantPics, GameInfoIndexEntry *entry) {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		LoadIfNeeded();
+		auto it = entries_.find(path);
+		if (it == entries_.end())
+			return false;
+		if (it->second.fileSize != fileSize || it->second.mtime != mtime) {
+			DeleteImages(it->first, it->second);
+			entries_.erase(it);
+			dirty_ = true;
+			return false;
+		}
+
+		it->second.used = true;
+		*entry = it->second;
+	}
+
+	// Read the images outside the lock, so the other workers can keep going.
+	if (entry->hasIcon && !readFileToString(false, ImageFilename(path, "icon").c_str(), entry->icon))
+		return false;
+	if (wantPics) {
+		if (entry->hasPic0 && !readFileToString(false, ImageFilename(path, "pic0").c_str(), entry->pic0))
+			return false;
+		if (entry->hasPic1 && !readFileToString(false, ImageFilename(path, "pic1").c_str(), entry->pic1))
+			return false;
+	}
+	return true;
+}
+
+void GameInfoIndex::Store(const std::string &path, const GameInfoIndexEntry &entry) {
+	// Write the images first, outside the lock.  Store() for a path is never called twice at once.
+	bool hasIcon = !entry.icon.empty() && writeStringToFile(false, entry.icon, ImageFilename(path, "icon").c_str());
+	bool hasPic0 = !entry.pic0.empty() && writeStringToFile(false, entry.pic0, ImageFilename(path, "pic0").c_str());
+	bool hasPic1 = !entry.pic1.empty() && writeStringToFile(false, entry.pic1, ImageFilename(path, "pic1").c_str());
+
+	std::lock_guard<std::mutex> guard(lock_);
+	LoadIfNeeded();
+	GameInfoIndexEntry &stored = entries_[path];
+	// Don't leave behind images the new entry doesn't have.
+	if (stored.hasPic0 && !hasPic0)
+		File::Delete(ImageFilename(path, "pic0"));
+	if (stored.hasPic1 && !hasPic1)
+		File::Delete(ImageFilename(path, "pic1"));
+	if (stored.hasIcon && !hasIcon)
+		File::Delete(ImageFilename(path, "icon"));
+	stored = entry;
+	stored.hasIcon = hasIcon;
+	stored.hasPic0 = hasPic0;
+	stored.hasPic1 = hasPic1;
+	// Only the flags are kept in memory.
+	stored.icon.clear();
+	stored.pic0.clear();
+	stored.pic1.clear();
+	stored.used = true;
+	dirty_ = true;
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+class PointerWrap;
+
+// What the GameInfoCache found out about a game image the last time it looked, so the
+// next launch can show the game list without opening every ISO and PBP again.
+struct GameInfoIndexEntry {
+	// The image is only trusted if these still match.
+	u64 fileSize = 0;
+	u64 mtime = 0;
+
+	// GAMEINFO_WANTBG and GAMEINFO_WANTSIZE, for whether pics and gameSize were stored.
+	int contents = 0;
+	int fileType = 0;
+
+	std::string id;
+	std::string id_version;
+	int region = -1;
+
+	// Raw PARAM.SFO, exactly as in the image.
+	std::string paramSFO;
+	u64 gameSize = 0;
+
+	// Raw PNG data.  Not part of the index file itself, these are kept in separate files
+	// and only read by Lookup(), so loading the index stays quick.
+	std::string icon;
+	std::string pic0;
+	std::string pic1;
+	bool hasIcon = false;
+	bool hasPic0 = false;
+	bool hasPic1 = false;
+
+	// Not saved, used to prune entries for deleted files.
+	bool used = false;
+
+	void DoState(PointerWrap &p);
+};
+
+class GameInfoIndex {
+public:
+	// Nothing is read here.  The index is loaded by the first Lookup() or Store(), which
+	// happen on the game info worker threads, so startup doesn't wait on it.
+	void Init(const std::string &filename, const std::string &imageDir);
+	// Only writes if something changed since the index was loaded.
+	bool Save();
+
+	// Finds the entry for path, if the file still has the same size and mtime.
+	// The pics are only read if wantPics is set.
+	bool Lookup(const std::string &path, u64 fileSize, u64 mtime, bool wantPics, GameInfoIndexEntry *entry);
+	void Store(const std::string &path, const GameInfoIndexEntry &entry);
+
+	void DoState(PointerWrap &p);
+
+private:
+	// Call with lock_ held.
+	void LoadIfNeeded();
+	std::string ImageFilename(const std::string &path, const char *kind) const;
+	void DeleteImages(const std::string &path, const GameInfoIndexEntry &entry);
+
+	std::mutex lock_;
+	std::string filename_;
+	std::string imageDir_;
+	std::map<std::string, GameInfoIndexEntry> entries_;
+	bool loaded_ = false;
+	bool dirty_ = false;
+};
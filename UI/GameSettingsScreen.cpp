@@ -616,6 +616,9 @@ void GameSettingsScreen::CreateViews() {
 	altVolume->SetZeroLabel(a->T("Mute"));
 	altVolume->SetNegativeDisable(a->T("Use global volume"));
 
+	CheckBox *highQualityResampler = audioSettings->Add(new CheckBox(&g_Config.bHighQualityResampler, a->T("High quality resampling")));
+	highQualityResampler->SetEnabledPtr(&g_Config.bEnableSound);
+
 	// Hide the backend selector in UWP builds (we only support XAudio2 there).
 #if PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
 	if (IsVistaOrHigher()) {
@@ -0,0 +1,283 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "headless/Benchmark.h"
+
+#include "Common/Data/Format/JSONReader.h"
+#include "Common/Data/Format/JSONWriter.h"
+#include "Core/Config.h"
+#include "Core/HLE/sceKernel.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/System.h"
+#include "GPU/GPU.h"
+
+// Changes smaller than this are ignored, even if they're consistent.
+static const double MIN_CHANGE_PERCENT = 2.0;
+static const double MIN_CHANGE_MS = 0.05;
+static const double SIGNIFICANCE = 0.01;
+
+BenchFrame BenchCollectFrame(double wallMs) {
+	BenchFrame frame;
+	frame.wallMs = wallMs;
+	frame.geMs = gpuStats.msProcessingDisplayLists;
+	frame.audioMs = kernelStats.msInAudioUpdate;
+	frame.syscallMs = kernelStats.msInSyscalls;
+	frame.jitMs = MIPSComp::jitCompileStats.msCompiling;
+	frame.jitBlocks = MIPSComp::jitCompileStats.blocksCompiled;
+	frame.drawCalls = gpuStats.numDrawCalls;
+	frame.flushes = gpuStats.numFlushes;
+	frame.vertsSubmitted = gpuStats.numVertsSubmitted;
+	frame.vertexCacheHits = gpuStats.numDecodedVertexCacheHits;
+	frame.vertexCacheMisses = gpuStats.numDecodedVertexCacheMisses;
+	frame.texturesDecoded = gpuStats.numTexturesDecoded;
+	frame.textureInvalidations = gpuStats.numTextureInvalidations;
+	return frame;
+}
+
+// The GE and audio run on the emu thread too, so they're taken out of the CPU time.
+static double CpuMs(const BenchFrame &frame) {
+	return std::max(0.0, frame.wallMs - frame.geMs - frame.audioMs);
+}
+
+std::string BenchResultJSON(const CoreParameter &coreParameter, const std::vector<BenchFrame> &frames, double totalSeconds) {
+	json::JsonWriter writer(json::JsonWriter::PRETTY);
+	writer.begin();
+	writer.writeString("file", coreParameter.fileToStart);
+	switch (coreParameter.cpuCore) {
+	case CPUCore::INTERPRETER: writer.writeString("cpuCore", "interpreter"); break;
+	case CPUCore::IR_JIT: writer.writeString("cpuCore", "ir"); break;
+	default: writer.writeString("cpuCore", "jit"); break;
+	}
+	writer.writeInt("frames", (int)frames.size());
+	writer.writeFloat("totalSeconds", totalSeconds);
+
+	double slowest = 0.0;
+	double jitMs = 0.0;
+	int jitBlocks = 0;
+	for (const BenchFrame &frame : frames) {
+		slowest = std::max(slowest, frame.wallMs);
+		jitMs += frame.jitMs;
+		jitBlocks += frame.jitBlocks;
+	}
+	writer.writeFloat("avgFrameMs", frames.empty() ? 0.0 : totalSeconds * 1000.0 / frames.size());
+	writer.writeFloat("maxFrameMs", slowest);
+
+	writer.pushDict("jit");
+	writer.writeInt("blocksCompiled", jitBlocks);
+	writer.writeFloat("compileMs", jitMs);
+	JitBlockCacheDebugInterface *blockCache = MIPSComp::jit ? MIPSComp::jit->GetBlockCacheDebugInterface() : nullptr;
+	if (blockCache && blockCache->GetNumBlocks() > 0) {
+		BlockCacheStats bcStats;
+		blockCache->ComputeStats(bcStats);
+		writer.writeInt("cachedBlocks", bcStats.numBlocks);
+		writer.writeFloat("avgBloat", bcStats.avgBloat);
+		writer.writeFloat("minBloat", bcStats.minBloat);
+		writer.writeFloat("maxBloat", bcStats.maxBloat);
+	}
+	writer.pop();
+
+	writer.pushArray("perFrame");
+	for (const BenchFrame &frame : frames) {
+		writer.pushDict();
+		writer.writeFloat("wallMs", frame.wallMs);
+		writer.writeFloat("cpuMs", CpuMs(frame));
+		writer.writeFloat("geMs", frame.geMs);
+		writer.writeFloat("audioMs", frame.audioMs);
+		// Includes any GE work the syscalls kicked off.
+		writer.writeFloat("syscallMs", frame.syscallMs);
+		writer.writeFloat("jitCompileMs", frame.jitMs);
+		writer.writeInt("jitBlocksCompiled", frame.jitBlocks);
+		writer.writeInt("drawCalls", frame.drawCalls);
+		writer.writeInt("flushes", frame.flushes);
+		writer.writeInt("vertsSubmitted", frame.vertsSubmitted);
+		writer.writeInt("vertexCacheHits", frame.vertexCacheHits);
+		writer.writeInt("vertexCacheMisses", frame.vertexCacheMisses);
+		writer.writeInt("texturesDecoded", frame.texturesDecoded);
+		writer.writeInt("textureInvalidations", frame.textureInvalidations);
+		writer.pop();
+	}
+	writer.pop();
+	writer.end();
+	return writer.str();
+}
+
+bool BenchLoadFrames(const std::string &filename, std::vector<BenchFrame> *frames) {
+	json::JsonReader reader(filename);
+	if (!reader.ok())
+		return false;
+
+	const JsonNode *perFrame = reader.root().getArray("perFrame");
+	if (!perFrame)
+		return false;
+
+	frames->clear();
+	for (const JsonNode *node : perFrame->value) {
+		json::JsonGet entry = node->value;
+		BenchFrame frame;
+		frame.wallMs = entry.getFloat("wallMs", 0.0);
+		frame.geMs = entry.getFloat("geMs", 0.0);
+		frame.audioMs = entry.getFloat("audioMs", 0.0);
+		frame.syscallMs = entry.getFloat("syscallMs", 0.0);
+		frame.jitMs = entry.getFloat("jitCompileMs", 0.0);
+		frame.jitBlocks = entry.getInt("jitBlocksCompiled", 0);
+		frame.drawCalls = entry.getInt("drawCalls", 0);
+		frame.flushes = entry.getInt("flushes", 0);
+		frame.vertsSubmitted = entry.getInt("vertsSubmitted", 0);
+		frame.vertexCacheHits = entry.getInt("vertexCacheHits", 0);
+		frame.vertexCacheMisses = entry.getInt("vertexCacheMisses", 0);
+		frame.texturesDecoded = entry.getInt("texturesDecoded", 0);
+		frame.textureInvalidations = entry.getInt("textureInvalidations", 0);
+		frames->push_back(frame);
+	}
+	return true;
+}
+
+// Wilcoxon signed-rank test on the paired differences, using the normal approximation.
+// A replay runs the same work each frame, so pairing by frame cancels out the variation between frames.
+// Returns the two-sided p-value.
+static double SignedRankTest(const std::vector<double> &baseline, const std::vector<double> &current) {
+	std::vector<double> diffs;
+	for (size_t i = 0; i < baseline.size(); ++i) {
+		double diff = current[i] - baseline[i];
+		if (diff != 0.0)
+			diffs.push_back(diff);
+	}
+	size_t n = diffs.size();
+	if (n < 10)
+		return 1.0;
+
+	std::sort(diffs.begin(), diffs.end(), [](double a, double b) {
+		return fabs(a) < fabs(b);
+	});
+
+	double positiveRanks = 0.0;
+	double tieCorrection = 0.0;
+	for (size_t i = 0; i < n; ) {
+		size_t end = i + 1;
+		while (end < n && fabs(diffs[end]) == fabs(diffs[i]))
+			end++;
+		// Ties share the average of their ranks.
+		double rank = (double)(i + 1 + end) * 0.5;
+		for (size_t j = i; j < end; ++j) {
+			if (diffs[j] > 0.0)
+				positiveRanks += rank;
+		}
+		double t = (double)(end - i);
+		tieCorrection += t * t * t - t;
+		i = end;
+	}
+
+	double mean = n * (n + 1) * 0.25;
+	double variance = n * (n + 1) * (2 * n + 1) / 24.0 - tieCorrection / 48.0;
+	if (variance <= 0.0)
+		return 1.0;
+	double z = (fabs(positiveRanks - mean) - 0.5) / sqrt(variance);
+	return erfc(std::max(0.0, z) / sqrt(2.0));
+}
+
+template <typename F>
+static std::vector<double> Metric(const std::vector<BenchFrame> &frames, size_t count, F func) {
+	std::vector<double> values;
+	values.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		values.push_back(func(frames[i]));
+	return values;
+}
+
+static double Mean(const std::vector<double> &values) {
+	double sum = 0.0;
+	for (double v : values)
+		sum += v;
+	return values.empty() ? 0.0 : sum / values.size();
+}
+
+bool BenchCompare(const std::string &baselineFilename, const std::vector<BenchFrame> &baseline, const std::vector<BenchFrame> &frames) {
+	size_t count = std::min(baseline.size(), frames.size());
+	printf("Comparing %d frames against %s:\n", (int)count, baselineFilename.c_str());
+	if (baseline.size() != frames.size())
+		printf("  Warning: baseline has %d frames, this run has %d\n", (int)baseline.size(), (int)frames.size());
+
+	// If the replay went differently, the frames aren't doing the same work and the pairing is meaningless.
+	for (size_t i = 0; i < count; ++i) {
+		if (baseline[i].drawCalls != frames[i].drawCalls || baseline[i].vertsSubmitted != frames[i].vertsSubmitted) {
+			printf("  Warning: diverged from the baseline at frame %d (%d draws, baseline %d)\n", (int)i, frames[i].drawCalls, baseline[i].drawCalls);
+			break;
+		}
+	}
+
+	struct Timing {
+		const char *name;
+		double (*func)(const BenchFrame &);
+	};
+	static const Timing timings[] = {
+		{ "wallMs", [](const BenchFrame &f) { return f.wallMs; } },
+		{ "cpuMs", [](const BenchFrame &f) { return CpuMs(f); } },
+		{ "geMs", [](const BenchFrame &f) { return f.geMs; } },
+		{ "audioMs", [](const BenchFrame &f) { return f.audioMs; } },
+		{ "syscallMs", [](const BenchFrame &f) { return f.syscallMs; } },
+		{ "jitCompileMs", [](const BenchFrame &f) { return f.jitMs; } },
+	};
+
+	bool regressed = false;
+	printf("  %-22s %12s %12s %9s %10s\n", "per frame", "baseline", "current", "change", "p");
+	for (const Timing &timing : timings) {
+		std::vector<double> before = Metric(baseline, count, timing.func);
+		std::vector<double> after = Metric(frames, count, timing.func);
+		double meanBefore = Mean(before);
+		double meanAfter = Mean(after);
+		double change = meanBefore > 0.0 ? (meanAfter - meanBefore) * 100.0 / meanBefore : 0.0;
+		double p = SignedRankTest(before, after);
+
+		const char *verdict = "";
+		if (p < SIGNIFICANCE && fabs(change) >= MIN_CHANGE_PERCENT && fabs(meanAfter - meanBefore) >= MIN_CHANGE_MS) {
+			verdict = change > 0.0 ? "slower" : "faster";
+			regressed = regressed || change > 0.0;
+		}
+		printf("  %-22s %12.3f %12.3f %+8.1f%% %10.4f %s\n", timing.name, meanBefore, meanAfter, change, p, verdict);
+	}
+
+	// These don't depend on timing, so any change is real (as long as the replay didn't diverge.)
+	struct Counter {
+		const char *name;
+		int (*func)(const BenchFrame &);
+	};
+	static const Counter counters[] = {
+		{ "jitBlocksCompiled", [](const BenchFrame &f) { return f.jitBlocks; } },
+		{ "flushes", [](const BenchFrame &f) { return f.flushes; } },
+		{ "vertexCacheMisses", [](const BenchFrame &f) { return f.vertexCacheMisses; } },
+		{ "texturesDecoded", [](const BenchFrame &f) { return f.texturesDecoded; } },
+		{ "textureInvalidations", [](const BenchFrame &f) { return f.textureInvalidations; } },
+	};
+
+	printf("  %-22s %12s %12s %9s\n", "total", "baseline", "current", "change");
+	for (const Counter &counter : counters) {
+		long long before = 0, after = 0;
+		for (size_t i = 0; i < count; ++i) {
+			before += counter.func(baseline[i]);
+			after += counter.func(frames[i]);
+		}
+		double change = before > 0 ? (after - before) * 100.0 / before : 0.0;
+		printf("  %-22s %12lld %12lld %+8.1f%%\n", counter.name, before, after, change);
+	}
+
+	printf("%s\n", regressed ? "Significantly slower than the baseline." : "No significant slowdown.");
+	return !regressed;
+}
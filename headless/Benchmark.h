@@ -0,0 +1,50 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct CoreParameter;
+
+struct BenchFrame {
+	double wallMs;
+	double geMs;
+	double audioMs;
+	double syscallMs;
+	double jitMs;
+	int jitBlocks;
+	int drawCalls;
+	int flushes;
+	int vertsSubmitted;
+	int vertexCacheHits;
+	int vertexCacheMisses;
+	// Texture cache misses, basically.
+	int texturesDecoded;
+	int textureInvalidations;
+};
+
+// Reads the frame stats (which must be on, see Core_UpdateDebugStats) for the frame that just ended.
+BenchFrame BenchCollectFrame(double wallMs);
+
+std::string BenchResultJSON(const CoreParameter &coreParameter, const std::vector<BenchFrame> &frames, double totalSeconds);
+bool BenchLoadFrames(const std::string &filename, std::vector<BenchFrame> *frames);
+
+// Prints a frame by frame comparison against a baseline from the same replay.
+// Returns false if anything got significantly slower.
+bool BenchCompare(const std::string &baselineFilename, const std::vector<BenchFrame> &baseline, const std::vector<BenchFrame> &frames);
@@ -5,12 +5,21 @@
 #include "ppsspp_config.h"
 #include <cstdio>
 #include <cstdlib>
+#include <algorithm>
 #include <limits>
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
 #endif
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Profiler/TraceRecorder.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
 
@@ -18,6 +27,7 @@
 #include "Common/File/VFS/AssetReader.h"
 #include "Common/File/FileUtil.h"
 #include "Common/GraphicsContext.h"
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
@@ -25,13 +35,16 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
+#include "Core/Replay.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "Log.h"
 #include "LogManager.h"
 
+#include "Benchmark.h"
 #include "Compare.h"
 #include "StubHost.h"
 #if defined(_WIN32)
@@ -117,6 +130,15 @@ int printUsage(const char *progname, const char *reason)
 	}
 #endif
 	fprintf(stderr, "  --timeout=SECONDS     abort test it if takes longer than SECONDS\n");
+	fprintf(stderr, "  --syscall-profile     print time spent in each HLE function after each test\n");
+	fprintf(stderr, "  --trace=FILE          write a Chrome trace of all tests to FILE\n");
+#if !defined(_WIN32)
+	fprintf(stderr, "  --jobs=N              run each test in its own process, N at a time\n");
+#endif
+	fprintf(stderr, "  --bench=FRAMES        run the first file for FRAMES frames and print timing as JSON\n");
+	fprintf(stderr, "  --bench-output=FILE   write the --bench JSON to FILE instead of stdout\n");
+	fprintf(stderr, "  --bench-baseline=FILE compare --bench against JSON from an earlier run\n");
+	fprintf(stderr, "  --replay=FILE         play back recorded input and disk results during --bench\n");
 
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
@@ -142,7 +164,19 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
+static void PrintSyscallProfile() {
+	auto entries = hleGetSyscallProfile();
+	printf("Syscall profile for %s:\n", currentTestName.c_str());
+	printf("  %-40s %10s %12s %10s %10s\n", "function", "calls", "total ms", "avg us", "max us");
+	for (const auto &entry : entries) {
+		std::string name = StringFromFormat("%s::%s", entry.module, entry.name);
+		double totalSeconds = hleSyscallProfileSeconds(entry.profile.ticks);
+		double maxSeconds = hleSyscallProfileSeconds(entry.profile.maxTicks);
+		printf("  %-40s %10llu %12.3f %10.3f %10.3f\n", name.c_str(), (unsigned long long)entry.profile.calls, totalSeconds * 1000.0, totalSeconds * 1000000.0 / entry.profile.calls, maxSeconds * 1000000.0);
+	}
+}
+
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout, bool syscallProfile)
 {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
@@ -209,6 +243,10 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
 
+	// Must happen before shutdown, which forgets the HLE modules.
+	if (syscallProfile)
+		PrintSyscallProfile();
+
 	PSP_Shutdown();
 
 	headlessHost->FlushDebugOutput();
@@ -221,6 +259,235 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	return passed;
 }
 
+struct BenchOptions {
+	int frames = 0;
+	const char *output = nullptr;
+	const char *replay = nullptr;
+	const char *baseline = nullptr;
+};
+
+static bool RunBenchmark(HeadlessHost *headlessHost, CoreParameter &coreParameter, const BenchOptions &options, double timeout) {
+	int maxFrames = options.frames;
+	// Load this first, so a bad baseline doesn't waste a whole run.
+	std::vector<BenchFrame> baseline;
+	if (options.baseline && !BenchLoadFrames(options.baseline, &baseline)) {
+		fprintf(stderr, "Unable to read benchmark baseline %s\n", options.baseline);
+		return false;
+	}
+	// Must be set up before boot, so the same input and disk results are used from the start.
+	if (options.replay && !ReplayExecuteFile(options.replay)) {
+		fprintf(stderr, "Unable to read replay %s\n", options.replay);
+		return false;
+	}
+
+	std::string error_string;
+	if (!PSP_Init(coreParameter, &error_string)) {
+		fprintf(stderr, "Failed to start %s. Error: %s\n", coreParameter.fileToStart.c_str(), error_string.c_str());
+		ReplayAbort();
+		return false;
+	}
+
+	ReplaySyncRtc();
+	host->BootDone();
+
+	std::vector<BenchFrame> frames;
+	frames.reserve(maxFrames);
+
+	// Also resets all the frame stats.
+	Core_UpdateDebugStats(true);
+
+	PSP_BeginHostFrame();
+	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
+		coreParameter.graphicsContext->GetDrawContext()->BeginFrame();
+
+	double startTime = time_now_d();
+	double deadline = startTime + timeout;
+	double frameStart = startTime;
+	coreState = CORE_RUNNING;
+	while (coreState == CORE_RUNNING && (int)frames.size() < maxFrames) {
+		PSP_RunLoopFor(usToCycles(1000000 / 10));
+
+		if (coreState == CORE_NEXTFRAME) {
+			coreState = CORE_RUNNING;
+			headlessHost->SwapBuffers();
+
+			frames.push_back(BenchCollectFrame((time_now_d() - frameStart) * 1000.0));
+
+			Core_UpdateDebugStats(true);
+			// Don't count the stats bookkeeping against the next frame.
+			frameStart = time_now_d();
+		}
+		if (time_now_d() > deadline) {
+			fprintf(stderr, "Benchmark timed out after %d frames\n", (int)frames.size());
+			break;
+		}
+	}
+	double totalSeconds = frameStart - startTime;
+
+	PSP_EndHostFrame();
+	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
+		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
+
+	// Must happen before shutdown, which destroys the jit.
+	std::string result = BenchResultJSON(coreParameter, frames, totalSeconds);
+	Core_UpdateDebugStats(false);
+	PSP_Shutdown();
+	ReplayAbort();
+	headlessHost->FlushDebugOutput();
+
+	bool success = true;
+	if (options.output) {
+		if (!writeStringToFile(true, result, options.output)) {
+			fprintf(stderr, "Unable to write benchmark results to %s\n", options.output);
+			success = false;
+		}
+	} else if (!options.baseline) {
+		printf("%s\n", result.c_str());
+	}
+
+	if ((int)frames.size() < maxFrames) {
+		fprintf(stderr, "Only ran %d of %d frames\n", (int)frames.size(), maxFrames);
+		success = false;
+	}
+	if (options.baseline && !BenchCompare(options.baseline, baseline, frames))
+		success = false;
+	return success;
+}
+
+#if !defined(_WIN32)
+struct TestWorker {
+	pid_t pid;
+	int fd;
+	std::string filename;
+	std::string output;
+	double startTime;
+	bool killed;
+};
+
+static void FinishTestWorker(TestWorker &worker, std::vector<std::string> &passedTests, std::vector<std::string> &failedTests, std::vector<std::pair<double, std::string>> &timings) {
+	close(worker.fd);
+	int status = 0;
+	while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR)
+		continue;
+	double seconds = time_now_d() - worker.startTime;
+
+	std::string testName = GetTestName(worker.filename);
+	printf("%s", worker.output.c_str());
+	if (worker.killed) {
+		printf("  %s - killed after %.1f seconds\n", testName.c_str(), seconds);
+	} else if (WIFSIGNALED(status)) {
+		printf("  %s - crashed (signal %d)\n", testName.c_str(), WTERMSIG(status));
+	}
+	fflush(stdout);
+
+	if (!worker.killed && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		passedTests.push_back(testName);
+	else
+		failedTests.push_back(testName);
+	timings.push_back(std::make_pair(seconds, testName));
+}
+
+// Forks a worker process per test, up to jobs at a time, so a crash or hang only takes out its own test.
+// Returns true in the worker, with testFilenames reduced to its one test.  Otherwise, prints the summary.
+static bool RunTestWorkers(std::vector<std::string> &testFilenames, int jobs, double timeout) {
+	const std::vector<std::string> tests = testFilenames;
+	std::vector<std::string> passedTests;
+	std::vector<std::string> failedTests;
+	std::vector<std::pair<double, std::string>> timings;
+	std::vector<TestWorker> workers;
+	double startTime = time_now_d();
+	size_t next = 0;
+
+	fflush(stdout);
+	fflush(stderr);
+	while (next < tests.size() || !workers.empty()) {
+		while (next < tests.size() && (int)workers.size() < jobs) {
+			const std::string &filename = tests[next++];
+			int fds[2];
+			pid_t pid = -1;
+			if (pipe(fds) == 0) {
+				pid = fork();
+				if (pid < 0) {
+					close(fds[0]);
+					close(fds[1]);
+				}
+			}
+			if (pid < 0) {
+				fprintf(stderr, "Unable to start a worker for %s: %s\n", filename.c_str(), strerror(errno));
+				failedTests.push_back(GetTestName(filename));
+				continue;
+			}
+
+			if (pid == 0) {
+				close(fds[0]);
+				for (const TestWorker &worker : workers)
+					close(worker.fd);
+				dup2(fds[1], STDOUT_FILENO);
+				dup2(fds[1], STDERR_FILENO);
+				close(fds[1]);
+				// Keep as much output as possible if the test crashes.
+				setvbuf(stdout, nullptr, _IOLBF, 0);
+				testFilenames.assign(1, filename);
+				return true;
+			}
+
+			close(fds[1]);
+			workers.push_back({ pid, fds[0], filename, std::string(), time_now_d(), false });
+		}
+		if (workers.empty())
+			continue;
+
+		std::vector<pollfd> pollfds;
+		for (const TestWorker &worker : workers)
+			pollfds.push_back({ worker.fd, POLLIN, 0 });
+		if (poll(&pollfds[0], pollfds.size(), 100) < 0 && errno != EINTR) {
+			perror("poll");
+			break;
+		}
+
+		double now = time_now_d();
+		for (size_t i = workers.size(); i-- > 0; ) {
+			TestWorker &worker = workers[i];
+			bool done = false;
+			if (pollfds[i].revents != 0) {
+				char buffer[4096];
+				ssize_t count = read(worker.fd, buffer, sizeof(buffer));
+				if (count > 0)
+					worker.output.append(buffer, count);
+				else if (count == 0 || errno != EINTR)
+					done = true;
+			}
+			// The worker enforces the timeout itself, this is for when it's stuck outside the emulator.
+			if (!done && !worker.killed && timeout < std::numeric_limits<double>::infinity() && now - worker.startTime > timeout + 10.0) {
+				kill(worker.pid, SIGKILL);
+				worker.killed = true;
+			}
+
+			if (done) {
+				FinishTestWorker(worker, passedTests, failedTests, timings);
+				workers.erase(workers.begin() + i);
+			}
+		}
+	}
+
+	printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
+	if (!failedTests.empty()) {
+		printf("Failed tests:\n");
+		for (const std::string &testName : failedTests)
+			printf("  %s\n", testName.c_str());
+	}
+
+	std::sort(timings.begin(), timings.end(), [](const std::pair<double, std::string> &a, const std::pair<double, std::string> &b) {
+		return a.first > b.first;
+	});
+	printf("Slowest tests:\n");
+	for (size_t i = 0; i < timings.size() && i < 10; ++i)
+		printf("  %8.3fs %s\n", timings[i].first, timings[i].second.c_str());
+	printf("Ran %d tests in %.3f seconds with %d workers.\n", (int)tests.size(), time_now_d() - startTime, jobs);
+	return false;
+}
+#endif
+
 int main(int argc, const char* argv[])
 {
 	PROFILE_INIT();
@@ -236,6 +503,10 @@ int main(int argc, const char* argv[])
 	GPUCore gpuCore = GPUCORE_SOFTWARE;
 	CPUCore cpuCore = CPUCore::JIT;
 	int debuggerPort = -1;
+	bool syscallProfile = false;
+	const char *traceFilename = 0;
+	int jobs = 1;
+	BenchOptions bench;
 
 	std::vector<std::string> testFilenames;
 	const char *mountIso = 0;
@@ -299,6 +570,20 @@ int main(int argc, const char* argv[])
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
+		else if (!strcmp(argv[i], "--syscall-profile"))
+			syscallProfile = true;
+		else if (!strncmp(argv[i], "--trace=", strlen("--trace=")) && strlen(argv[i]) > strlen("--trace="))
+			traceFilename = argv[i] + strlen("--trace=");
+		else if (!strncmp(argv[i], "--jobs=", strlen("--jobs=")) && strlen(argv[i]) > strlen("--jobs="))
+			jobs = std::max(1, atoi(argv[i] + strlen("--jobs=")));
+		else if (!strncmp(argv[i], "--bench=", strlen("--bench=")) && strlen(argv[i]) > strlen("--bench="))
+			bench.frames = atoi(argv[i] + strlen("--bench="));
+		else if (!strncmp(argv[i], "--bench-output=", strlen("--bench-output=")) && strlen(argv[i]) > strlen("--bench-output="))
+			bench.output = argv[i] + strlen("--bench-output=");
+		else if (!strncmp(argv[i], "--bench-baseline=", strlen("--bench-baseline=")) && strlen(argv[i]) > strlen("--bench-baseline="))
+			bench.baseline = argv[i] + strlen("--bench-baseline=");
+		else if (!strncmp(argv[i], "--replay=", strlen("--replay=")) && strlen(argv[i]) > strlen("--replay="))
+			bench.replay = argv[i] + strlen("--replay=");
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -323,6 +608,29 @@ int main(int argc, const char* argv[])
 	if (testFilenames.empty())
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
+	if (bench.frames < 0)
+		return printUsage(argv[0], "Invalid frame count after --bench=");
+	if ((bench.replay || bench.baseline) && bench.frames == 0)
+		return printUsage(argv[0], "--replay and --bench-baseline only work with --bench");
+	if (bench.frames > 0 && testFilenames.size() > 1)
+		fprintf(stderr, "Warning: --bench only runs %s\n", testFilenames[0].c_str());
+
+	bool isWorker = false;
+	if (jobs > 1 && testFilenames.size() > 1 && bench.frames == 0) {
+#if defined(_WIN32)
+		fprintf(stderr, "Warning: --jobs is not supported on Windows, running tests in sequence\n");
+#else
+		if (traceFilename != 0 || debuggerPort > 0) {
+			fprintf(stderr, "Warning: --jobs can't be used with --trace or --debugger, running tests in sequence\n");
+		} else {
+			// Everything else, including logging and graphics, is set up separately in each worker.
+			if (!RunTestWorkers(testFilenames, jobs, timeout))
+				return 0;
+			isWorker = true;
+		}
+#endif
+	}
+
 	LogManager::Init(&g_Config.bEnableLogging);
 	LogManager *logman = LogManager::GetInstance();
 
@@ -439,14 +747,24 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(stateToLoad, -1);
 
+	if (traceFilename != 0)
+		TraceRecorder::Start();
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
+	bool allPassed = true;
+	if (bench.frames > 0) {
+		coreParameter.fileToStart = testFilenames[0];
+		allPassed = RunBenchmark(headlessHost, coreParameter, bench, timeout);
+		testFilenames.clear();
+	}
 	for (size_t i = 0; i < testFilenames.size(); ++i)
 	{
 		coreParameter.fileToStart = testFilenames[i];
 		if (autoCompare)
 			printf("%s:\n", coreParameter.fileToStart.c_str());
-		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout);
+		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout, syscallProfile);
+		allPassed = allPassed && passed;
 		if (autoCompare)
 		{
 			std::string testName = GetTestName(coreParameter.fileToStart);
@@ -460,7 +778,13 @@ int main(int argc, const char* argv[])
 		}
 	}
 
-	if (autoCompare)
+	if (traceFilename != 0) {
+		if (!writeStringToFile(false, TraceRecorder::Stop(), traceFilename))
+			fprintf(stderr, "Unable to write trace to %s\n", traceFilename);
+	}
+
+	// The parent process prints the summary for all the workers.
+	if (autoCompare && !isWorker)
 	{
 		printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
 		if (!failedTests.empty())
@@ -485,5 +809,7 @@ int main(int argc, const char* argv[])
 	LogManager::Shutdown();
 	delete printfLogger;
 
+	if (isWorker || bench.frames > 0)
+		return allPassed ? 0 : 1;
 	return 0;
 }
@@ -25,6 +25,7 @@
 #include "Core/ConfigValues.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/IR/IRTierCache.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSAsm.h"
@@ -33,6 +34,7 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/HLE/HLE.h"
+#include "unittest/UnitTest.h"
 
 // Temporary hacks around annoying linking errors.  Copied from Headless.
 void NativeUpdate() { }
@@ -198,3 +200,76 @@ bool TestJit() {
 
 	return jit_speed >= interp_speed;
 }
+
+static bool AssembleAt(u32 addr, const char *const *lines, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (!MIPSAsm::MipsAssembleOpcode(lines[i], currentDebugMIPS, addr + (u32)i * 4)) {
+			printf("ERROR: %ls\n", MIPSAsm::GetAssembleError().c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool RunTierOnce(MIPSComp::IRTierCache &tier) {
+	coreState = CORE_RUNNING;
+	currentMIPS->downcount = 1000000;
+	return tier.RunColdBlocks();
+}
+
+bool TestJitTiering() {
+	SetupJitHarness();
+
+	// Two blocks: one that counts and stops the core, then one that jumps back to it.
+	const u32 base = PSP_GetUserMemoryBase();
+	static const char *lines[] = {
+		"addiu r2, r2, 1",
+		"addiu r3, r3, 1",
+		// The syscall goes here, below.
+		"nop",
+		"jr r31",
+		"nop",
+	};
+	bool success = AssembleAt(base, lines, ARRAY_SIZE(lines));
+	Memory::Write_U32(MIPS_MAKE_SYSCALL("UnitTestFakeSyscalls", "UnitTestTerminator"), base + 8);
+	currentMIPS->r[MIPS_REG_V0] = 0;
+	currentMIPS->r[MIPS_REG_V1] = 0;
+	currentMIPS->r[MIPS_REG_RA] = base;
+	currentMIPS->pc = base;
+
+	MIPSComp::IRTierCache tier(currentMIPS, 3);
+	// Stops after the syscall, since the core isn't running anymore.
+	EXPECT_TRUE(success && RunTierOnce(tier));
+	EXPECT_EQ_HEX(currentMIPS->pc, base + 12);
+	EXPECT_EQ_INT(currentMIPS->r[MIPS_REG_V0], 1);
+
+	// Change the second op, so only an invalidation would notice.
+	static const char *changed[] = { "addiu r3, r3, 16" };
+	EXPECT_TRUE(AssembleAt(base + 4, changed, 1));
+	tier.InvalidateCacheAt(base + 4, 4);
+	EXPECT_TRUE(RunTierOnce(tier));
+	EXPECT_EQ_INT(currentMIPS->r[MIPS_REG_V0], 2);
+	EXPECT_EQ_INT(currentMIPS->r[MIPS_REG_V1], 17);
+
+	// The third time through, the first block is hot and should be compiled natively instead.
+	EXPECT_FALSE(RunTierOnce(tier));
+	EXPECT_EQ_HEX(currentMIPS->pc, base);
+	EXPECT_EQ_INT(currentMIPS->r[MIPS_REG_V0], 2);
+
+	// Pretend the native jit took it, with an emuhack that matches a tier block number.
+	int blockNum = tier.GetBlockCacheDebugInterface()->GetBlockNumberFromStartAddress(base, false);
+	EXPECT_TRUE(blockNum >= 0);
+	const u32 emuhack = MIPS_EMUHACK_OPCODE | (u32)blockNum;
+	Memory::Write_U32(emuhack, base);
+	EXPECT_TRUE(RunTierOnce(tier));
+	EXPECT_EQ_HEX(currentMIPS->pc, base);
+
+	// The tier doesn't own the emuhack, so neither of these may touch it.
+	tier.InvalidateCacheAt(base, 20);
+	EXPECT_EQ_HEX(Memory::ReadUnchecked_U32(base), emuhack);
+	tier.ClearCache();
+	EXPECT_EQ_HEX(Memory::ReadUnchecked_U32(base), emuhack);
+
+	DestroyJitHarness();
+	return true;
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/TimeUtil.h"
+#include "Core/Util/AudioFormat.h"
+#include "unittest/UnitTest.h"
+
+// Simple xorshift, so the data is the same every run.
+static u32 NextRandom(u32 &state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+// Returns frames per second, in millions.
+template <typename F>
+static double Benchmark(int framesPerRound, F func) {
+	int rounds = 0;
+	double st = time_now_d();
+	do {
+		for (int i = 0; i < 32; ++i)
+			func();
+		rounds += 32;
+	} while (time_now_d() - st < 0.1);
+	double elapsed = time_now_d() - st;
+	return ((double)framesPerRound * rounds / elapsed) / 1000000.0;
+}
+
+// What StereoResampler::Mix used to do, one frame at a time.
+static size_t ReferenceResampleLinear(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio) {
+	size_t written = 0;
+	while (written < outFrames && *pos + 1 < inFrames) {
+		const s16 *src = in + *pos * 2;
+		out[written * 2] = ((src[0] << 16) + (src[2] - src[0]) * (u16)*frac) >> 16;
+		out[written * 2 + 1] = ((src[1] << 16) + (src[3] - src[1]) * (u16)*frac) >> 16;
+		written++;
+		*frac += ratio;
+		*pos += *frac >> 16;
+		*frac &= 0xFFFF;
+	}
+	return written;
+}
+
+static size_t ReferenceResamplePolyphase(s16 *out, size_t outFrames, const s16 *in, size_t inFrames, size_t *pos, u32 *frac, u32 ratio) {
+	size_t written = 0;
+	while (written < outFrames && *pos + RESAMPLE_FIR_TAPS / 2 < inFrames) {
+		const s16 *src = in + ((ptrdiff_t)*pos - (RESAMPLE_FIR_TAPS / 2 - 1)) * 2;
+		const s16 *coefs = GetResampleFIRPhase(*frac);
+		int sumL = 0, sumR = 0;
+		for (int i = 0; i < RESAMPLE_FIR_TAPS; ++i) {
+			sumL += src[i * 2] * coefs[i];
+			sumR += src[i * 2 + 1] * coefs[i];
+		}
+		out[written * 2] = clamp_s16((sumL + (1 << 14)) >> 15);
+		out[written * 2 + 1] = clamp_s16((sumR + (1 << 14)) >> 15);
+		written++;
+		*frac += ratio;
+		*pos += *frac >> 16;
+		*frac &= 0xFFFF;
+	}
+	return written;
+}
+
+static bool CompareSamples(const char *title, const s16 *expected, const s16 *actual, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		if (expected[i] != actual[i]) {
+			printf("%s: mismatch at %d, %d != expected %d\n", title, (int)i, actual[i], expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool TestAudioMixing() {
+	// A PSP block is 256 frames.
+	static const int FRAMES = 256;
+	static const int HISTORY = RESAMPLE_FIR_TAPS / 2 - 1;
+	std::vector<s16> input((HISTORY + FRAMES * 2) * 2);
+	std::vector<s32> mixed(FRAMES * 2);
+	std::vector<s16> clampExpected(FRAMES * 2), clampActual(FRAMES * 2);
+
+	u32 seed = 0x1337;
+	for (auto &s : input) {
+		// Mostly full scale, to exercise wrapping and saturation.
+		s = (s16)NextRandom(seed);
+	}
+	for (int i = 0; i < FRAMES * 2; ++i) {
+		mixed[i] = (s32)(NextRandom(seed) & 0x3FFFF) - 0x20000;
+	}
+
+	const s16 *in = &input[HISTORY * 2];
+
+	for (int shift = 0; shift < 3; ++shift) {
+		for (int i = 0; i < FRAMES * 2; ++i) {
+			clampExpected[i] = clamp_s16(mixed[i] >> shift);
+		}
+		ClampBufferToS16(&clampActual[0], &mixed[0], FRAMES * 2, shift);
+		if (!CompareSamples("ClampBufferToS16", &clampExpected[0], &clampActual[0], FRAMES * 2))
+			return false;
+	}
+
+	// The ratios are near 1.0, since we normally resample 44100 to 44100 or 48000.
+	static const u32 ratios[] = { 0x10000, 0x0EB33, 0x10123, 0x0FF00, 0x18000, 0x08000, 0x1FFFF };
+	std::vector<s16> outExpected(FRAMES * 4 * 2), outActual(FRAMES * 4 * 2);
+	for (u32 ratio : ratios) {
+		for (int fracStart = 0; fracStart < 0x10000; fracStart += 0x3333) {
+			for (int poly = 0; poly < 2; ++poly) {
+				const char *title = poly ? "ResamplePolyphaseStereo" : "ResampleLinearStereo";
+				size_t posExpected = 0, posActual = 0;
+				u32 fracExpected = fracStart, fracActual = fracStart;
+				size_t expectedFrames, actualFrames;
+				// Ask for more than the input allows, so they must both stop in the same place.
+				if (poly) {
+					expectedFrames = ReferenceResamplePolyphase(&outExpected[0], FRAMES * 4, in, FRAMES * 2, &posExpected, &fracExpected, ratio);
+					actualFrames = ResamplePolyphaseStereo(&outActual[0], FRAMES * 4, in, FRAMES * 2, &posActual, &fracActual, ratio);
+				} else {
+					expectedFrames = ReferenceResampleLinear(&outExpected[0], FRAMES * 4, in, FRAMES * 2, &posExpected, &fracExpected, ratio);
+					actualFrames = ResampleLinearStereo(&outActual[0], FRAMES * 4, in, FRAMES * 2, &posActual, &fracActual, ratio);
+				}
+				if (expectedFrames != actualFrames || posExpected != posActual || fracExpected != fracActual) {
+					printf("%s: ratio %05x stopped at %d/%d (%04x), expected %d/%d (%04x)\n", title, ratio, (int)actualFrames, (int)posActual, fracActual, (int)expectedFrames, (int)posExpected, fracExpected);
+					return false;
+				}
+				if (!CompareSamples(title, &outExpected[0], &outActual[0], expectedFrames * 2))
+					return false;
+			}
+		}
+	}
+
+	// A constant signal should stay constant through the filter.
+	std::vector<s16> dc(input.size(), 12345);
+	size_t dcPos = 0;
+	u32 dcFrac = 0x1234;
+	size_t dcFrames = ResamplePolyphaseStereo(&outActual[0], FRAMES, &dc[HISTORY * 2], FRAMES * 2, &dcPos, &dcFrac, 0xEB33);
+	for (size_t i = 0; i < dcFrames * 2; ++i) {
+		if (outActual[i] != 12345) {
+			printf("ResamplePolyphaseStereo: DC came out as %d\n", outActual[i]);
+			return false;
+		}
+	}
+
+	double linearRate = Benchmark(FRAMES, [&] {
+		size_t pos = 0;
+		u32 frac = 0;
+		ResampleLinearStereo(&outActual[0], FRAMES, in, FRAMES * 2, &pos, &frac, 0xEB33);
+	});
+	double linearRefRate = Benchmark(FRAMES, [&] {
+		size_t pos = 0;
+		u32 frac = 0;
+		ReferenceResampleLinear(&outActual[0], FRAMES, in, FRAMES * 2, &pos, &frac, 0xEB33);
+	});
+	double polyRate = Benchmark(FRAMES, [&] {
+		size_t pos = 0;
+		u32 frac = 0;
+		ResamplePolyphaseStereo(&outActual[0], FRAMES, in, FRAMES * 2, &pos, &frac, 0xEB33);
+	});
+	double polyRefRate = Benchmark(FRAMES, [&] {
+		size_t pos = 0;
+		u32 frac = 0;
+		ReferenceResamplePolyphase(&outActual[0], FRAMES, in, FRAMES * 2, &pos, &frac, 0xEB33);
+	});
+	printf("Audio Mframes/s (scalar): linear %.1f (%.1f), polyphase %.1f (%.1f)\n", linearRate, linearRefRate, polyRate, polyRefRate);
+
+	return true;
+}
@@ -2,18 +2,23 @@
 #include <algorithm>
 
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Common/Thread/WorkerPool.h"
 
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/ShaderCommon.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "Common/Data/Random/Rng.h"
 
-#include "GPU/Vulkan/VulkanContext.h"
+#include "Common/GPU/Vulkan/VulkanContext.h"
+#include "Common/GPU/Vulkan/VulkanShaderCompiler.h"
 
 #include "GPU/Common/FragmentShaderGenerator.h"
 #include "GPU/Common/VertexShaderGenerator.h"
 #include "GPU/Common/ReinterpretFramebuffer.h"
 
+#include "unittest/UnitTest.h"
+
 #if PPSSPP_PLATFORM(WINDOWS)
 #include "GPU/D3D11/D3D11Util.h"
 #include "GPU/D3D11/D3D11Loader.h"
@@ -378,4 +383,113 @@ bool TestShaderGenerators() {
 	}
 
 	return true;
-} 
+}
+
+struct ShaderSource {
+	VkShaderStageFlagBits stage;
+	std::string code;
+};
+
+// Same ID generation as the tests above, but only keeps the Vulkan GLSL.
+static std::vector<ShaderSource> GenerateVulkanShaderSources(int vsCount, int fsCount) {
+	std::vector<ShaderSource> sources;
+	char *buffer = new char[65536];
+	GMRng rng;
+	Draw::Bugs bugs;
+
+	for (int i = 0; i < fsCount; i++) {
+		FShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBit(FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL, false);
+		id.SetBit(FS_BIT_SHADER_DEPAL, false);
+		std::string errorString;
+		if (GenerateFShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &errorString)) {
+			sources.push_back({ VK_SHADER_STAGE_FRAGMENT_BIT, buffer });
+		}
+	}
+
+	for (int i = 0; i < vsCount; i++) {
+		VShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBits(VS_BIT_WEIGHT_FMTSCALE, 2, 0);
+		if (id.Bit(VS_BIT_IS_THROUGH)) {
+			id.SetBit(VS_BIT_USE_HW_TRANSFORM, 0);
+		}
+		if (!id.Bit(VS_BIT_USE_HW_TRANSFORM)) {
+			id.SetBit(VS_BIT_ENABLE_BONES, 0);
+		}
+		std::string errorString;
+		if (GenerateVShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &errorString)) {
+			sources.push_back({ VK_SHADER_STAGE_VERTEX_BIT, buffer });
+		}
+	}
+
+	delete[] buffer;
+	return sources;
+}
+
+// CPU-only benchmark of GLSL -> SPIR-V throughput: serial, on the compile pool, and from the SPIR-V cache.
+// Also checks that all three produce identical SPIR-V, and that the cache survives a save/load roundtrip.
+bool TestShaderCompiler() {
+	init_glslang();
+
+	std::vector<ShaderSource> sources = GenerateVulkanShaderSources(200, 100);
+	const int count = (int)sources.size();
+
+	std::vector<std::vector<uint32_t>> reference(count);
+	double start = time_now_d();
+	for (int i = 0; i < count; i++) {
+		std::string errorMessage;
+		if (!GLSLtoSPV(sources[i].stage, sources[i].code.c_str(), GLSLVariant::VULKAN, reference[i], &errorMessage)) {
+			printf("Error compiling shader:\n\n%s\n\n%s\n", LineNumberString(sources[i].code).c_str(), errorMessage.c_str());
+			return false;
+		}
+	}
+	double serialTime = time_now_d() - start;
+
+	int numThreads = WorkerPool::DefaultThreadCount();
+	VulkanShaderCompiler compiler(numThreads);
+	std::vector<std::shared_ptr<VulkanShaderCompileJob>> jobs(count);
+	start = time_now_d();
+	for (int i = 0; i < count; i++) {
+		jobs[i] = compiler.Compile(sources[i].stage, sources[i].code);
+	}
+	compiler.WaitUntilIdle();
+	double parallelTime = time_now_d() - start;
+
+	for (int i = 0; i < count; i++) {
+		EXPECT_TRUE(jobs[i]->IsReady());
+		EXPECT_TRUE(jobs[i]->Succeeded());
+		EXPECT_TRUE(jobs[i]->SPIRV() == reference[i]);
+	}
+
+	// Roundtrip through a cache file, then everything should be a hit.
+	FILE *f = tmpfile();
+	EXPECT_TRUE(f != nullptr);
+	compiler.SaveCache(f);
+	rewind(f);
+	VulkanShaderCompiler cachedCompiler(numThreads);
+	EXPECT_TRUE(cachedCompiler.LoadCache(f));
+	fclose(f);
+
+	start = time_now_d();
+	for (int i = 0; i < count; i++) {
+		jobs[i] = cachedCompiler.Compile(sources[i].stage, sources[i].code);
+	}
+	double cachedTime = time_now_d() - start;
+
+	for (int i = 0; i < count; i++) {
+		EXPECT_TRUE(jobs[i]->IsReady());
+		EXPECT_TRUE(jobs[i]->FromCache());
+		EXPECT_TRUE(jobs[i]->SPIRV() == reference[i]);
+	}
+	VulkanShaderCompilerStats stats = cachedCompiler.GetStats();
+	EXPECT_EQ_INT(stats.compiled, 0);
+
+	printf("%d shaders: serial %0.1f ms (%0.1f/s), %d threads %0.1f ms (%0.1f/s), cached %0.2f ms\n",
+		count, serialTime * 1000.0, count / serialTime, numThreads, parallelTime * 1000.0, count / parallelTime, cachedTime * 1000.0);
+	return true;
+}
+
@@ -0,0 +1,175 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstring>
+
+#include "Common/Common.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "unittest/UnitTest.h"
+
+using namespace Math3D;
+
+static u32 NextRandom(u32 &state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static void RandomizePixelState(u32 &seed) {
+	memset(&gstate, 0, sizeof(gstate));
+	auto r = [&](u32 mask) { return NextRandom(seed) & mask; };
+
+	gstate.vertType = r(1) ? GE_VTYPE_THROUGH_MASK : 0;
+	gstate.alphaTestEnable = r(1);
+	gstate.alphatest = r(0xFFFFFF);
+	gstate.zTestEnable = r(1);
+	gstate.ztestfunc = r(7);
+	gstate.zmsk = r(1);
+	gstate.minz = r(0x7FFF);
+	gstate.maxz = 0x8000 | r(0x7FFF);
+	gstate.fogEnable = r(1);
+	gstate.fogcolor = r(0xFFFFFF);
+	gstate.alphaBlendEnable = r(1);
+	gstate.blend = r(0xFF) | ((r(0xFF) % 6) << 8);
+	gstate.blendfixa = r(0xFFFFFF);
+	gstate.blendfixb = r(0xFFFFFF);
+	gstate.ditherEnable = r(1);
+	for (int i = 0; i < 4; ++i)
+		gstate.dithmtx[i] = r(0xFFFF);
+	if (r(3) == 0) {
+		gstate.pmskc = r(0xFFFFFF);
+		gstate.pmska = r(0xFF);
+	}
+	gstate.framebufpixformat = r(3);
+	gstate.fbwidth = 64;
+	gstate.zbwidth = 64;
+}
+
+bool TestSoftwareGPUJit() {
+	static const int W = 64, H = 4;
+	static u8 fbExpected[W * H * 4], fbActual[W * H * 4];
+	static u16 zExpected[W * H], zActual[W * H];
+
+	Rasterizer::Init();
+	GPUgstate oldState = gstate;
+	FormatBuffer oldFb = fb;
+	FormatBuffer oldDepth = depthbuf;
+
+	u32 seed = 0x1337;
+	int compiled = 0;
+	int quads = 0;
+	bool success = true;
+	for (int i = 0; i < 1000 && success; ++i) {
+		RandomizePixelState(seed);
+
+		PixelFuncID id;
+		Rasterizer::ComputePixelFuncID(&id);
+		Rasterizer::QuadFunc quadFunc = Rasterizer::GetQuadFunc(id);
+		if (quadFunc) {
+			quads++;
+			for (int j = 0; j < 16; ++j) {
+				for (int k = 0; k < W * H * 4; ++k)
+					fbExpected[k] = (u8)NextRandom(seed);
+				for (int k = 0; k < W * H; ++k)
+					zExpected[k] = (u16)NextRandom(seed);
+				memcpy(fbActual, fbExpected, sizeof(fbActual));
+				memcpy(zActual, zExpected, sizeof(zActual));
+
+				int x = NextRandom(seed) % (W - 1);
+				int y = NextRandom(seed) % (H - 1);
+				Vec4<int> z, fog, mask;
+				Vec4<int> colors[4];
+				for (int p = 0; p < 4; ++p) {
+					z[p] = NextRandom(seed) & 0xFFFF;
+					fog[p] = NextRandom(seed) & 0xFF;
+					mask[p] = (NextRandom(seed) & 3) == 0 ? -1 : 0;
+					for (int c = 0; c < 4; ++c)
+						colors[p][c] = (int)(NextRandom(seed) & 0x3FF) - 0x100;
+				}
+
+				fb.data = fbExpected;
+				depthbuf.data = (u8 *)zExpected;
+				for (int p = 0; p < 4; ++p) {
+					if (mask[p] >= 0)
+						Rasterizer::DrawSinglePixel(x + (p & 1), y + p / 2, z[p], fog[p], colors[p], id);
+				}
+
+				fb.data = fbActual;
+				depthbuf.data = (u8 *)zActual;
+				quadFunc(x, y, z, fog, colors, mask, id);
+
+				if (memcmp(fbExpected, fbActual, sizeof(fbActual)) != 0 || memcmp(zExpected, zActual, sizeof(zActual)) != 0) {
+					Rasterizer::PixelJitCache describer;
+					printf("Pixel quad mismatch for %s at %d,%d\n", describer.DescribePixelFuncID(id).c_str(), x, y);
+					success = false;
+					break;
+				}
+			}
+		}
+
+		Rasterizer::SingleFunc func = Rasterizer::GetSingleFunc(id);
+		if (func == &Rasterizer::DrawSinglePixel || !success)
+			continue;
+		compiled++;
+
+		for (int j = 0; j < 16; ++j) {
+			for (int k = 0; k < W * H * 4; ++k)
+				fbExpected[k] = (u8)NextRandom(seed);
+			for (int k = 0; k < W * H; ++k)
+				zExpected[k] = (u16)NextRandom(seed);
+			memcpy(fbActual, fbExpected, sizeof(fbActual));
+			memcpy(zActual, zExpected, sizeof(zActual));
+
+			int x = NextRandom(seed) % W;
+			int y = NextRandom(seed) % H;
+			int z = NextRandom(seed) & 0xFFFF;
+			int fog = NextRandom(seed) & 0xFF;
+			// Go outside 0-255 sometimes, to check clamping.
+			Vec4<int> color;
+			for (int c = 0; c < 4; ++c)
+				color[c] = (int)(NextRandom(seed) & 0x3FF) - 0x100;
+
+			fb.data = fbExpected;
+			depthbuf.data = (u8 *)zExpected;
+			Rasterizer::DrawSinglePixel(x, y, z, fog, color, id);
+
+			fb.data = fbActual;
+			depthbuf.data = (u8 *)zActual;
+			func(x, y, z, fog, color, id);
+
+			if (memcmp(fbExpected, fbActual, sizeof(fbActual)) != 0 || memcmp(zExpected, zActual, sizeof(zActual)) != 0) {
+				Rasterizer::PixelJitCache describer;
+				printf("Pixel jit mismatch for %s at %d,%d\n", describer.DescribePixelFuncID(id).c_str(), x, y);
+				success = false;
+				break;
+			}
+		}
+	}
+
+	gstate = oldState;
+	fb = oldFb;
+	depthbuf = oldDepth;
+	Rasterizer::Shutdown();
+
+	if (success)
+		printf("Pixel jit: %d states matched the C++ path, %d with quads\n", compiled, quads);
+	return success;
+}
@@ -0,0 +1,242 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/TimeUtil.h"
+#include "Core/MemMap.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "unittest/UnitTest.h"
+
+// Simple xorshift, so the data is the same every run.
+static u32 NextRandom(u32 &state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static void FillRandom(void *p, size_t bytes, u32 seed) {
+	u8 *b = (u8 *)p;
+	for (size_t i = 0; i < bytes; ++i) {
+		b[i] = (u8)NextRandom(seed);
+	}
+}
+
+template <typename T>
+static bool CompareResults(const char *title, TextureDecoderLevel level, const std::vector<T> &expected, const std::vector<T> &actual) {
+	for (size_t i = 0; i < expected.size(); ++i) {
+		if (expected[i] != actual[i]) {
+			printf("%s (%s): mismatch at %d, %08x != expected %08x\n", title, TextureDecoderLevelName(level), (int)i, (u32)actual[i], (u32)expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Returns megapixels per second.
+template <typename F>
+static double Benchmark(int pixelsPerRound, F func) {
+	int rounds = 0;
+	double st = time_now_d();
+	do {
+		for (int i = 0; i < 32; ++i)
+			func();
+		rounds += 32;
+	} while (time_now_d() - st < 0.1);
+	double elapsed = time_now_d() - st;
+	return ((double)pixelsPerRound * rounds / elapsed) / 1000000.0;
+}
+
+// The reference: unswizzle into a temp buffer, then deindex row by row.
+static void UnswizzleThenDeIndex4(u32 *dest, int destPitch, const u8 *texptr, int bufw, int w, int h, const u32 *clut) {
+	const int rowBytes = bufw / 2;
+	std::vector<u8> linear(rowBytes * ((h + 7) & ~7));
+	const int bxc = rowBytes / 16;
+	const u8 *src = texptr;
+	for (int by = 0; by < (h + 7) / 8; ++by) {
+		for (int bx = 0; bx < bxc; ++bx) {
+			for (int n = 0; n < 8; ++n) {
+				memcpy(&linear[(by * 8 + n) * rowBytes + bx * 16], src, 16);
+				src += 16;
+			}
+		}
+	}
+	for (int y = 0; y < h; ++y) {
+		DeIndexTexture4To32Basic(dest + destPitch * y, &linear[rowBytes * y], w, clut);
+	}
+}
+
+bool TestTextureDecoders() {
+	SetupTextureDecoder();
+	printf("Texture decoder level: %s\n", TextureDecoderLevelName(texDecoderFuncs.level));
+
+	// Lengths chosen to hit the SIMD loops as well as the scalar tails.
+	static const int lengths[] = { 2, 30, 32, 34, 62, 64, 66, 98, 480, 512 };
+	static const int MAX_LENGTH = 512;
+
+	std::vector<u8> indexed(MAX_LENGTH);
+	FillRandom(indexed.data(), indexed.size(), 0x1234);
+	std::vector<u16> clut16(256);
+	std::vector<u32> clut32(256);
+	FillRandom(clut16.data(), clut16.size() * sizeof(u16), 0x5678);
+	FillRandom(clut32.data(), clut32.size() * sizeof(u32), 0x9ABC);
+	std::vector<u16> src16(MAX_LENGTH);
+	FillRandom(src16.data(), src16.size() * sizeof(u16), 0xDEF0);
+
+	TextureDecoderFuncs ref;
+	EXPECT_TRUE(GetTextureDecoderFuncs(TextureDecoderLevel::BASIC, &ref));
+
+	for (int l = 0; l < (int)TextureDecoderLevel::COUNT; ++l) {
+		TextureDecoderFuncs f;
+		if (!GetTextureDecoderFuncs((TextureDecoderLevel)l, &f))
+			continue;
+
+		for (int length : lengths) {
+			// One extra pixel of room, the reference writes pairs.
+			std::vector<u16> expected16(length + 1), actual16(length + 1);
+			std::vector<u32> expected32(length + 1), actual32(length + 1);
+
+			ref.deIndex4To16(expected16.data(), indexed.data(), length, clut16.data());
+			f.deIndex4To16(actual16.data(), indexed.data(), length, clut16.data());
+			EXPECT_TRUE(CompareResults("deIndex4To16", f.level, expected16, actual16));
+
+			ref.deIndex4To32(expected32.data(), indexed.data(), length, clut32.data());
+			f.deIndex4To32(actual32.data(), indexed.data(), length, clut32.data());
+			EXPECT_TRUE(CompareResults("deIndex4To32", f.level, expected32, actual32));
+
+			ref.deIndex8To16(expected16.data(), indexed.data(), length, clut16.data());
+			f.deIndex8To16(actual16.data(), indexed.data(), length, clut16.data());
+			EXPECT_TRUE(CompareResults("deIndex8To16", f.level, expected16, actual16));
+
+			ref.deIndex8To32(expected32.data(), indexed.data(), length, clut32.data());
+			f.deIndex8To32(actual32.data(), indexed.data(), length, clut32.data());
+			EXPECT_TRUE(CompareResults("deIndex8To32", f.level, expected32, actual32));
+
+			// The reference conversions only take the SSE2 path when aligned, use an odd offset too.
+			for (int offset = 0; offset < 2; ++offset) {
+				const u16 *src = src16.data() + offset;
+				const int count = length - offset;
+				ref.convert4444To8888(expected32.data(), src, count);
+				f.convert4444To8888(actual32.data(), src, count);
+				EXPECT_TRUE(CompareResults("convert4444To8888", f.level, expected32, actual32));
+				ref.convert5551To8888(expected32.data(), src, count);
+				f.convert5551To8888(actual32.data(), src, count);
+				EXPECT_TRUE(CompareResults("convert5551To8888", f.level, expected32, actual32));
+				ref.convert565To8888(expected32.data(), src, count);
+				f.convert565To8888(actual32.data(), src, count);
+				EXPECT_TRUE(CompareResults("convert565To8888", f.level, expected32, actual32));
+			}
+		}
+	}
+
+	// The fused unswizzle, with a width that doesn't cover the whole buffer and a partial block row.
+	{
+		const int bufw = 128, w = 100, h = 61;
+		std::vector<u8> swizzled(bufw / 2 * ((h + 7) & ~7));
+		FillRandom(swizzled.data(), swizzled.size(), 0x4444);
+		std::vector<u32> expected(bufw * h), actual(bufw * h);
+		UnswizzleThenDeIndex4(expected.data(), bufw, swizzled.data(), bufw, w, h, clut32.data());
+		UnswizzleDeIndexTexture4(actual.data(), bufw, swizzled.data(), bufw, w, h, clut32.data());
+		EXPECT_TRUE(CompareResults("UnswizzleDeIndexTexture4", texDecoderFuncs.level, expected, actual));
+	}
+
+	// Now some rough numbers, on a 512x512 texture.
+	static const int BENCH_PIXELS = 512 * 512;
+	std::vector<u8> benchIndexed(BENCH_PIXELS);
+	std::vector<u16> bench16(BENCH_PIXELS);
+	std::vector<u32> bench32(BENCH_PIXELS);
+	FillRandom(benchIndexed.data(), benchIndexed.size(), 0x5555);
+	FillRandom(bench16.data(), bench16.size() * sizeof(u16), 0x6666);
+
+	for (int l = 0; l < (int)TextureDecoderLevel::COUNT; ++l) {
+		TextureDecoderFuncs f;
+		if (!GetTextureDecoderFuncs((TextureDecoderLevel)l, &f))
+			continue;
+
+		double clut4 = Benchmark(BENCH_PIXELS, [&] {
+			f.deIndex4To32(bench32.data(), benchIndexed.data(), BENCH_PIXELS, clut32.data());
+		});
+		double clut8 = Benchmark(BENCH_PIXELS, [&] {
+			f.deIndex8To32(bench32.data(), benchIndexed.data(), BENCH_PIXELS, clut32.data());
+		});
+		double conv4444 = Benchmark(BENCH_PIXELS, [&] {
+			f.convert4444To8888(bench32.data(), bench16.data(), BENCH_PIXELS);
+		});
+		double conv565 = Benchmark(BENCH_PIXELS, [&] {
+			f.convert565To8888(bench32.data(), bench16.data(), BENCH_PIXELS);
+		});
+		printf("%-7s Mpix/s: CLUT4->32 %7.1f  CLUT8->32 %7.1f  4444 %7.1f  565 %7.1f\n", TextureDecoderLevelName(f.level), clut4, clut8, conv4444, conv565);
+	}
+
+	return true;
+}
+
+bool TestTextureHashes() {
+	SetupTextureDecoder();
+
+	// Dirty page tracking, used to skip rehashing.
+	u64 stamp = Memory::GetDirtyStamp();
+	EXPECT_FALSE(Memory::IsDirtySince(0x08800000, 0x10000, stamp));
+	Memory::MarkDirty(0x08805000, 4);
+	EXPECT_TRUE(Memory::IsDirtySince(0x08800000, 0x10000, stamp));
+	EXPECT_FALSE(Memory::IsDirtySince(0x08800000, 0x5000, stamp));
+	EXPECT_FALSE(Memory::IsDirtySince(0x08806000, 0x1000, stamp));
+	// Uncached mirror of the same page.
+	EXPECT_TRUE(Memory::IsDirtySince(0x48805000, 0x10, stamp));
+	stamp = Memory::GetDirtyStamp();
+	EXPECT_FALSE(Memory::IsDirtySince(0x08805000, 0x10, stamp));
+	// VRAM mirrors are folded.
+	Memory::MarkDirty(0x04600000, 0x100);
+	EXPECT_TRUE(Memory::IsDirtySince(0x04000000, 0x100, stamp));
+	EXPECT_FALSE(Memory::IsDirtySince(0x04100000, 0x100, stamp));
+	// Scratchpad isn't tracked, so is always reported dirty.
+	EXPECT_TRUE(Memory::IsDirtySince(0x00010000, 0x100, stamp));
+	stamp = Memory::GetDirtyStamp();
+	Memory::MarkAllDirty();
+	EXPECT_TRUE(Memory::IsDirtySince(0x08900000, 0x100, stamp));
+
+	// Compare against the 32-bit hash, on common texture sizes.
+	static const u32 sizes[] = { 64 * 64 * 2, 256 * 256 * 2, 512 * 272 * 4, 512 * 512 * 4 };
+	std::vector<u8> data(512 * 512 * 4 + 64);
+	FillRandom(data.data(), data.size(), 0x7777);
+	// Like PSP memory, textures are 16-byte aligned.
+	const u8 *aligned = (const u8 *)(((uintptr_t)data.data() + 15) & ~(uintptr_t)15);
+
+	// Every version must match the basic one, including partial blocks at the end.
+	for (u32 size : { 0U, 16U, 72U, 1000U, 4096U }) {
+		EXPECT_TRUE(DoQuickTexHash64(aligned, size) == QuickTexHash64Basic(aligned, size));
+	}
+	EXPECT_FALSE(DoQuickTexHash64(aligned, 4096) == DoQuickTexHash64(aligned + 16, 4096));
+
+	for (u32 size : sizes) {
+		volatile u64 sink = 0;
+		double hash32 = Benchmark(size / 4, [&] {
+			sink += DoQuickTexHash(aligned, size);
+		});
+		double hash64 = Benchmark(size / 4, [&] {
+			sink += DoQuickTexHash64(aligned, size);
+		});
+		// Benchmark() counts "pixels", here 4 bytes, so this is GB/s.
+		printf("Texture hash %7d bytes: QuickTexHash %6.2f GB/s, QuickTexHash64 %6.2f GB/s\n", size, hash32 * 4.0 / 1000.0, hash64 * 4.0 / 1000.0);
+	}
+
+	return true;
+}
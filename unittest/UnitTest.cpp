@@ -28,6 +28,7 @@
 // Search for "availableTests".
 
 #include "ppsspp_config.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
@@ -52,6 +53,9 @@
 #include "Core/Config.h"
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "GPU/Common/TextureDecoder.h"
 
@@ -297,6 +301,8 @@ bool TestParsers() {
 }
 
 bool TestVFPUSinCos() {
+	InitVFPUSinCos(false);
+
 	float sine, cosine;
 	vfpu_sincos(0.0f, sine, cosine);
 	EXPECT_EQ_FLOAT(sine, 0.0f);
@@ -357,6 +363,119 @@ bool TestMatrixTranspose() {
 	return true;
 }
 
+// regs[j * 4 + i] = base + i * iStride + j * jStride, like IRFrontend checks for the Mat4 ops.
+static void MakeMatrixLayout(u8 regs[16], int base, int iStride, int jStride) {
+	for (int j = 0; j < 4; j++) {
+		for (int i = 0; i < 4; i++)
+			regs[j * 4 + i] = (u8)(base + i * iStride + j * jStride);
+	}
+}
+
+// Runs the op and the FMul/FAdd expansion it replaces (same as IRFrontend's fallback), and compares.
+static bool CompareMatrixOp(const std::vector<IRInst> &op, const std::vector<IRInst> &expanded, u32 seed, int dBase, int refBase) {
+	MIPSState *mips = &mipsr4k;
+	for (int i = 32; i < 32 + 128; i++) {
+		seed = seed * 1103515245 + 12345;
+		// Finite values of all sorts of magnitudes, so rounding differences would show up.
+		mips->f[i] = ldexpf((float)(int)(seed >> 8) / (float)(1 << 23), (int)(seed & 15) - 8);
+	}
+	// Whatever the op doesn't write should be left alone in both.
+	memcpy(&mips->f[refBase], &mips->f[dBase], 16 * sizeof(float));
+
+	IRInterpret(mips, &op[0], (int)op.size());
+	IRInterpret(mips, &expanded[0], (int)expanded.size());
+	for (int i = 0; i < 16; i++) {
+		if (mips->fi[dBase + i] != mips->fi[refBase + i])
+			return false;
+	}
+	return true;
+}
+
+bool TestIRMatrixOps() {
+	static const int S_BASE = 32, T_BASE = 48, D_BASE = 64, REF_BASE = 80;
+	const IRInst exitInst = { IROp::ExitToConst, 0, 0, 0, 0 };
+
+	for (int n = 2; n <= 4; n++) {
+		for (u32 layout = 0; layout < 4; layout++) {
+			const u32 flags = n | ((layout & 1) ? IRMATRIX_S_TRANSPOSED : 0) | ((layout & 2) ? IRMATRIX_T_TRANSPOSED : 0);
+			u8 sregs[16], tregs[16], dregs[16], refregs[16];
+			if (flags & IRMATRIX_S_TRANSPOSED)
+				MakeMatrixLayout(sregs, S_BASE, 1, 4);
+			else
+				MakeMatrixLayout(sregs, S_BASE, 4, 1);
+			if (flags & IRMATRIX_T_TRANSPOSED)
+				MakeMatrixLayout(tregs, T_BASE, 4, 1);
+			else
+				MakeMatrixLayout(tregs, T_BASE, 1, 4);
+			MakeMatrixLayout(dregs, D_BASE, 1, 4);
+			MakeMatrixLayout(refregs, REF_BASE, 1, 4);
+
+			std::vector<IRInst> op{ { IROp::Mat4Mul, dregs[0], sregs[0], tregs[0], flags }, exitInst };
+			std::vector<IRInst> expanded;
+			const u8 temp0 = IRVTEMP_0, temp1 = IRVTEMP_0 + 1;
+			for (int a = 0; a < n; a++) {
+				for (int b = 0; b < n; b++) {
+					expanded.push_back({ IROp::FMul, temp0, sregs[b * 4], tregs[a * 4], 0 });
+					for (int c = 1; c < n; c++) {
+						expanded.push_back({ IROp::FMul, temp1, sregs[b * 4 + c], tregs[a * 4 + c], 0 });
+						expanded.push_back({ IROp::FAdd, (c == n - 1) ? refregs[a * 4 + b] : temp0, temp0, temp1, 0 });
+					}
+				}
+			}
+			expanded.push_back(exitInst);
+
+			for (u32 seed = 1; seed <= 16; seed++) {
+				if (!CompareMatrixOp(op, expanded, seed * 0x9E3779B9, D_BASE, REF_BASE)) {
+					printf("Mat4Mul: mismatch, flags %02x\n", flags);
+					return false;
+				}
+			}
+		}
+
+		for (u32 layout = 0; layout < 16; layout++) {
+			const bool homogenous = (layout & 8) != 0;
+			const u32 flags = n | ((layout & 1) ? IRMATRIX_S_TRANSPOSED : 0) | ((layout & 2) ? IRMATRIX_T_TRANSPOSED : 0) | ((layout & 4) ? IRMATRIX_D_TRANSPOSED : 0) | (homogenous ? IRMATRIX_HOMOGENOUS : 0);
+			u8 sregs[16], tregs[4], dregs[4], refregs[4];
+			if (flags & IRMATRIX_S_TRANSPOSED)
+				MakeMatrixLayout(sregs, S_BASE, 1, 4);
+			else
+				MakeMatrixLayout(sregs, S_BASE, 4, 1);
+			const int tStride = (flags & IRMATRIX_T_TRANSPOSED) ? 4 : 1;
+			const int dStride = (flags & IRMATRIX_D_TRANSPOSED) ? 4 : 1;
+			for (int i = 0; i < 4; i++) {
+				tregs[i] = (u8)(T_BASE + i * tStride);
+				dregs[i] = (u8)(D_BASE + i * dStride);
+				refregs[i] = (u8)(REF_BASE + i * dStride);
+			}
+
+			std::vector<IRInst> op{ { IROp::Mat4Transform, dregs[0], sregs[0], tregs[0], flags }, exitInst };
+			std::vector<IRInst> expanded;
+			const u8 s0 = IRVTEMP_0, temp1 = IRVTEMP_0 + 1;
+			for (int i = 0; i < n; i++) {
+				expanded.push_back({ IROp::FMul, s0, sregs[i * 4], tregs[0], 0 });
+				for (int k = 1; k < n; k++) {
+					if (!homogenous || k != n - 1) {
+						expanded.push_back({ IROp::FMul, temp1, sregs[i * 4 + k], tregs[k], 0 });
+						expanded.push_back({ IROp::FAdd, s0, s0, temp1, 0 });
+					} else {
+						expanded.push_back({ IROp::FAdd, s0, s0, sregs[i * 4 + k], 0 });
+					}
+				}
+				expanded.push_back({ IROp::FMov, refregs[i], s0, 0, 0 });
+			}
+			expanded.push_back(exitInst);
+
+			for (u32 seed = 1; seed <= 16; seed++) {
+				if (!CompareMatrixOp(op, expanded, seed * 0x9E3779B9, D_BASE, REF_BASE)) {
+					printf("Mat4Transform: mismatch, flags %02x\n", flags);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
 void TestGetMatrix(int matrix, MatrixSize sz) {
 	INFO_LOG(SYSTEM, "Testing matrix %s", GetMatrixNotation(matrix, sz));
 	u8 fullMatrix[16];
@@ -519,6 +638,65 @@ bool TestCLZ() {
 	return true;
 }
 
+static std::vector<int> SortedBlocksOnPage(const JitBlockPageIndex &index, u32 address) {
+	const std::vector<int> *page = index.GetBlocksOnPage(address);
+	std::vector<int> blocks;
+	if (page)
+		blocks = *page;
+	std::sort(blocks.begin(), blocks.end());
+	return blocks;
+}
+
+bool TestJitBlockPageIndex() {
+	JitBlockPageIndex index;
+
+	// Pages are 1KB, and each second level table covers 1MB.
+	index.Add(0x08800000, 0x100, 1);
+	// Straddles the first two pages.
+	index.Add(0x088003F8, 0x10, 2);
+	index.Add(0x08800400, 4, 3);
+	// Straddles two second level tables.
+	index.Add(0x088FFFFC, 8, 4);
+	// A mirror of the first page.
+	index.Add(0x48800000, 4, 5);
+	// Even with no size, it's on a page.
+	index.Add(0x08A00000, 0, 6);
+
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x08800000) == std::vector<int>({ 1, 2, 5 }));
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x088007FF) == std::vector<int>({ 2, 3 }));
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x088FFC00) == std::vector<int>({ 4 }));
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x48900000) == std::vector<int>({ 4 }));
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x08A00000) == std::vector<int>({ 6 }));
+	EXPECT_TRUE(index.GetBlocksOnPage(0x08800800) == nullptr);
+	// Not even a second level table there.
+	EXPECT_TRUE(index.GetBlocksOnPage(0x09000000) == nullptr);
+
+	std::vector<int> blocks;
+	index.GetBlocksInRange(0x08800000, 0x800, &blocks);
+	EXPECT_TRUE(blocks == std::vector<int>({ 1, 2, 3, 5 }));
+	blocks.clear();
+	index.GetBlocksInRange(0x088FFC00, 0x100401, &blocks);
+	EXPECT_TRUE(blocks == std::vector<int>({ 4, 6 }));
+	blocks.clear();
+	// Runs off the end of memory, past tables that were never allocated.
+	index.GetBlocksInRange(0x1FFFFC00, 0x1000, &blocks);
+	EXPECT_TRUE(blocks.empty());
+
+	EXPECT_TRUE(index.Remove(0x088003F8, 0x10, 2));
+	EXPECT_FALSE(index.Remove(0x088003F8, 0x10, 2));
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x08800000) == std::vector<int>({ 1, 5 }));
+	EXPECT_TRUE(SortedBlocksOnPage(index, 0x08800400) == std::vector<int>({ 3 }));
+
+	index.RemoveFromAllPages(4);
+	EXPECT_TRUE(index.GetBlocksOnPage(0x088FFC00) == nullptr);
+	EXPECT_TRUE(index.GetBlocksOnPage(0x08900000) == nullptr);
+
+	index.Clear();
+	EXPECT_TRUE(index.GetBlocksOnPage(0x08800000) == nullptr);
+	EXPECT_TRUE(index.GetBlocksOnPage(0x08A00000) == nullptr);
+	return true;
+}
+
 static bool TestMemMap() {
 	Memory::g_MemorySize = Memory::RAM_DOUBLE_SIZE;
 
@@ -575,9 +753,14 @@ struct TestItem {
 #define TEST_ITEM(name) { #name, &Test ##name, }
 
 bool TestArmEmitter();
+bool TestAudioMixing();
 bool TestArm64Emitter();
 bool TestX64Emitter();
 bool TestShaderGenerators();
+bool TestShaderCompiler();
+bool TestTextureDecoders();
+bool TestTextureHashes();
+bool TestSoftwareGPUJit();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -596,11 +779,19 @@ TestItem availableTests[] = {
 	TEST_ITEM(MathUtil),
 	TEST_ITEM(Parsers),
 	TEST_ITEM(Jit),
+	TEST_ITEM(JitTiering),
 	TEST_ITEM(MatrixTranspose),
+	TEST_ITEM(IRMatrixOps),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(AudioMixing),
+	TEST_ITEM(TextureDecoders),
+	TEST_ITEM(TextureHashes),
+	TEST_ITEM(SoftwareGPUJit),
 	TEST_ITEM(CLZ),
+	TEST_ITEM(JitBlockPageIndex),
 	TEST_ITEM(ShaderGenerators),
+	TEST_ITEM(ShaderCompiler),
 };
 
 int main(int argc, const char *argv[]) {